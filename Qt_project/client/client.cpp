@@ -220,21 +220,21 @@ typedef int (*set_t)(void *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen
 typedef void (*crypt_t)(void *ctx, uint8_t *buf, uint32_t buflen, uint8_t *out);
 
 // Объявление массивов функций
-set_t set[] = { (set_t)salsa_set_key_and_iv,
-                (set_t)rabbit_set_key_and_iv,
-                (set_t)hc128_set_key_and_iv,
-                (set_t)sosemanuk_set_key_and_iv,
-                (set_t)grain_set_key_and_iv,
-                (set_t)mickey_set_key_and_iv,
-                (set_t)trivium_set_key_and_iv };
-
-crypt_t crypt[] = { (crypt_t)salsa_crypt,
-                    (crypt_t)rabbit_crypt,
-                    (crypt_t)hc128_crypt,
-                    (crypt_t)sosemanuk_crypt,
-                    (crypt_t)grain_crypt,
-                    (crypt_t)mickey_crypt,
-                    (crypt_t)trivium_crypt };
+static const set_t set[] = { (set_t)salsa_set_key_and_iv,
+                             (set_t)rabbit_set_key_and_iv,
+                             (set_t)hc128_set_key_and_iv,
+                             (set_t)sosemanuk_set_key_and_iv,
+                             (set_t)grain_set_key_and_iv,
+                             (set_t)mickey_set_key_and_iv,
+                             (set_t)trivium_set_key_and_iv };
+
+static const crypt_t crypt[] = { (crypt_t)salsa_crypt,
+                                 (crypt_t)rabbit_crypt,
+                                 (crypt_t)hc128_crypt,
+                                 (crypt_t)sosemanuk_crypt,
+                                 (crypt_t)grain_crypt,
+                                 (crypt_t)mickey_crypt,
+                                 (crypt_t)trivium_crypt };
 
 // Задаем массив максимальных длин ключей для вектора инициализации
 const int ivlen[7] = { 8, 8, 16, 16, 12, 10, 10 };
@@ -21,24 +21,24 @@
 #define MICKEY		10
 
 // Feedback mask associated with the register R
-uint32_t R_MASK[4] = { 0x1279327B, 0xB5546660,
-		       0xDF87818F, 0x00000003 };
+static const uint32_t R_MASK[4] = { 0x1279327B, 0xB5546660,
+				    0xDF87818F, 0x00000003 };
 
 // Input mask associated with register S
-uint32_t COMP0[4] = { 0x6AA97A30, 0x7942A809, 
-		      0x057EBFEA, 0x00000006 };
+static const uint32_t COMP0[4] = { 0x6AA97A30, 0x7942A809,
+				   0x057EBFEA, 0x00000006 };
 
 // Second input mask associated with register S
-uint32_t COMP1[4] = { 0xDD629E9A, 0xE3A21D63, 
-		      0x91C23DD7, 0x00000001 };
+static const uint32_t COMP1[4] = { 0xDD629E9A, 0xE3A21D63,
+				   0x91C23DD7, 0x00000001 };
 
 // Feedback mask associated with the register S for clock control_bit = 0
-uint32_t S_MASK0[4] = { 0x9FFA7FAF, 0xAF4A9381,
-			0x9CEC5802, 0x00000001 };
+static const uint32_t S_MASK0[4] = { 0x9FFA7FAF, 0xAF4A9381,
+				     0x9CEC5802, 0x00000001 };
 
 // Feedback mask associated with the register S for clock control_bit = 1
-uint32_t S_MASK1[4] = { 0x4C8CB877, 0x4911B063,
-			0x40FBC52B, 0x00000008 };
+static const uint32_t S_MASK1[4] = { 0x4C8CB877, 0x4911B063,
+				     0x40FBC52B, 0x00000008 };
 
 
 // Mickey initialization function
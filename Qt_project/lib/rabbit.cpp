@@ -120,10 +120,10 @@ rabbit_key_setup(struct rabbit_context *ctx)
 	ctx->c[2] = (k3 << 16) | (k3 >> 16);
 	ctx->c[4] = (k0 << 16) | (k0 >> 16);
 	ctx->c[6] = (k1 << 16) | (k1 >> 16);
-	ctx->c[1] = (k0 >> 16) | (k1 << 16);
-	ctx->c[3] = (k1 >> 16) | (k2 << 16);
-	ctx->c[5] = (k2 >> 16) | (k3 << 16);
-	ctx->c[7] = (k3 >> 16) | (k0 << 16);
+	ctx->c[1] = (k0 & 0xFFFF0000) | (k1 & 0xFFFF);
+	ctx->c[3] = (k1 & 0xFFFF0000) | (k2 & 0xFFFF);
+	ctx->c[5] = (k2 & 0xFFFF0000) | (k3 & 0xFFFF);
+	ctx->c[7] = (k3 & 0xFFFF0000) | (k0 & 0xFFFF);
 	
 	ctx->carry = 0;
 
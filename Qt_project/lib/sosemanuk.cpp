@@ -47,6 +47,13 @@
 // Cyclic shift
 #define ROTL32(v, n)	((v << n) | (v >> (32 - n)))
 
+// Alignment of the tables of the constants on the cache line (64 bytes)
+#ifdef __GNUC__
+#define CACHE_ALIGNED	__attribute__((aligned(64)))
+#else
+#define CACHE_ALIGNED
+#endif
+
 // Serpent S-boxes, implemented in bitslice mode.
 // These circuits have been published by Dag Arne Osvik ("Speeding up Serpent"). 
 // Published in the 3rd AES Candidate Conference.
@@ -279,7 +286,7 @@
 }
 
 // Multiplication by alpha: alpha * x = (x << 8) ^ mul_a[x >> 24]
-uint32_t mul_a[] = {
+static const uint32_t mul_a[] CACHE_ALIGNED = {
 	0x00000000, 0xE19FCF13, 0x6B973726, 0x8A08F835,
 	0xD6876E4C, 0x3718A15F, 0xBD10596A, 0x5C8F9679,
 	0x05A7DC98, 0xE438138B, 0x6E30EBBE, 0x8FAF24AD,
@@ -347,7 +354,7 @@ uint32_t mul_a[] = {
 };
 
 // Multiplication by 1/alpha: 1/alpha * x = (x >> 8) ^ mul_ia[x & 0xFF]
-uint32_t mul_ia[] = {
+static const uint32_t mul_ia[] CACHE_ALIGNED = {
 	0x00000000, 0x180F40CD, 0x301E8033, 0x2811C0FE,
 	0x603CA966, 0x7833E9AB, 0x50222955, 0x482D6998,
 	0xC078FBCC, 0xD877BB01, 0xF0667BFF, 0xE8693B32,
@@ -541,6 +548,10 @@ sosemanuk_set_key_and_iv(struct sosemanuk_context *ctx, const uint8_t *key, cons
 	
 	memcpy(ctx->key, key, ctx->keylen);
 	memcpy(ctx->iv, iv, ctx->ivlen);
+
+	// The key shorter than 256 bits is padded as the key of the Serpent: the bit 1, then zeros
+	if(ctx->keylen < SOSEMANUK)
+		ctx->key[ctx->keylen] = 0x01;
 	
 	sosemanuk_keysetup(ctx);
 
@@ -39,6 +39,18 @@
 #define S64(a, b, c)	((a << (96 - c))  | (b >> (c - 64)))
 #define S96(a, b, c)	((a << (128 - c)) | (b >> (c - 96)))
 
+// Reverse the bits of the 32-bit word. The bit 31 of the word of the state is the first bit of the 32 steps,
+// the keystream and the key of the eSTREAM reference are the bits from the least significant bit of the first byte
+#define REVERSE32(x) {								\
+	x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);			\
+	x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);			\
+	x = ((x >> 4) & 0x0F0F0F0F) | ((x & 0x0F0F0F0F) << 4);			\
+	x = (x >> 24) | ((x >> 8) & 0xFF00) | ((x << 8) & 0xFF0000) | (x << 24);	\
+}
+
+// Reverse the bits of the byte
+#define REVERSE8(x)	((uint8_t)((((x) * 0x0802LU & 0x22110LU) | ((x) * 0x8020LU & 0x88440LU)) * 0x10101LU >> 16))
+
 // Macros update the keystream
 #define T(w) { 							\
 	t1 = S64(w[2], w[1], 66) ^ S64(w[2], w[1], 93); 	\
@@ -97,11 +109,13 @@ trivium_keysetup(struct trivium_context *ctx)
 
 	memset(s, 0, sizeof(s));
 
+	// The bits K1 ... K80 (IV1 ... IV80) are the bits of the key (IV) from the last bit:
+	// the first byte is the last byte of the state of the register, the bits are reversed
 	for(i = 0; i < ctx->keylen; i++)
-		s[i] = ctx->key[i];
+		s[9 - i] = REVERSE8(ctx->key[i]);
 	
 	for(i = 0; i < ctx->ivlen; i++)
-		s[i + 12] = ctx->iv[i];
+		s[21 - i] = REVERSE8(ctx->iv[i]);
 
 	s[37] = 0x70;
 	
@@ -163,12 +177,14 @@ trivium_crypt(struct trivium_context *ctx, const uint8_t *buf, uint32_t buflen,
 
 	for(; buflen >= 4; buflen -= 4, buf += 4, out += 4) {
 		WORK_2(w, z);
+		REVERSE32(z);
 		
 		*(uint32_t *)(out + 0) = *(uint32_t *)(buf + 0) ^ U32TO32(z);
 	}
 
 	if(buflen) {
 		WORK_2(w, z);
+		REVERSE32(z);
 		
 		for(i = 0; i < buflen; i++, z >>= 8)
 			out[i] = buf[i] ^ (uint8_t)(z);
@@ -209,6 +225,7 @@ trivium_test_vectors(struct trivium_context *ctx)
 
 	for(i = 0; i < 10; i++) {
 		WORK_2(w, z);
+		REVERSE32(z);
 		PRINT_U32TO32(U32TO32(z));
 	}
 	
@@ -26,6 +26,18 @@
  * Russia, Komi Republic, Syktyvkar - 03.05.2015.
 */
 
+/*
+ * Thread safety.
+ * The functions of the ciphers and of the HASH functions are reentrant: the context is the only
+ * state of the algorithm, the tables are static const (.rodata, shared by the forked processes)
+ * and the checks of the processor are cached by the relaxed atomics. The independent contexts
+ * may be used by the threads at the same time without the locks (one context per thread),
+ * the one context is not shared by the threads without the lock of the caller.
+ * The counters ESTREAM_STATS are per thread (estream_stats.h). The limit of the SIMD lanes
+ * is the argument of the call (sha3x_hash_lanes) or the field of the context (blake3_init_lanes).
+ * The test: src/estream_stress.c (Makefile_stress, ThreadSanitizer).
+*/
+
 #ifndef ESTREAM_H
 #define ESTREAM_H
 
@@ -37,6 +49,7 @@
 #include "mickey.h"
 #include "trivium.h"
 #include "gost89.h"
+#include "estream_stats.h"
 
 #include "macro.h"
 
@@ -0,0 +1,20 @@
+/*
+ * Header-only inline mode of the ciphers (compile-time option ESTREAM_INLINE).
+ * With the ESTREAM_INLINE defined before including the estream.h (or the header of the cipher)
+ * the header includes the source of the cipher and the functions of the cipher are static inline:
+ * the crypt of the constant length (a packet of 64 bytes) is inlined to the loop of the caller,
+ * the number of the blocks is known at compile time and there is no call through the PLT.
+ * The program is not linked with the libestream.so (the instrumentation counters ESTREAM_STATS
+ * need the estream_stats.c). Without the ESTREAM_INLINE the functions are the functions of the library.
+*/
+
+#ifndef ESTREAM_INLINE_H
+#define ESTREAM_INLINE_H
+
+#ifdef ESTREAM_INLINE
+#define ESTREAM_API	static inline
+#else
+#define ESTREAM_API
+#endif
+
+#endif /* ESTREAM_INLINE_H */
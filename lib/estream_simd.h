@@ -0,0 +1,82 @@
+/*
+ * Vector kernels of the ciphers (GCC vector extensions): NEON on AArch64, SSE2 on x86-64.
+ * ESTREAM_SIMD is defined if the kernels are compiled (GCC, little-endian AArch64 or x86-64),
+ * estream_simd() checks the processor at run time (hwcap ASIMD of the AArch64, SSE2 is the base of the x86-64).
+ * ESTREAM_NO_SIMD (compile-time option) - estream_simd() is 0, the ciphers run the scalar code
+ * (the reference of the vector kernels in the fuzz test, estream_fuzz_ref.c).
+ * estream_xor - shared XOR of the message and the keystream of the vector kernels.
+ * The keystream stored by the 32-bit words is XORed by the LOAD32/STORE32: the 16-byte load
+ * of the four 32-bit stores is not forwarded from the store buffer (stall of the load).
+*/
+
+#ifndef ESTREAM_SIMD_H
+#define ESTREAM_SIMD_H
+
+#include <string.h>
+#include <stdint.h>
+
+#include "macro.h"
+
+#if defined(__GNUC__) && (defined(__aarch64__) || defined(__x86_64__)) && (__BYTE_ORDER == __LITTLE_ENDIAN)
+#define ESTREAM_SIMD
+
+#ifdef __aarch64__
+#include <sys/auxv.h>
+
+#ifndef HWCAP_ASIMD
+#define HWCAP_ASIMD	(1 << 1)
+#endif
+#endif
+
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+typedef uint8_t v16u8 __attribute__((vector_size(16)));
+
+// 1 if the vector kernels are supported by the processor
+static inline int
+estream_simd(void)
+{
+#if defined(ESTREAM_NO_SIMD)
+	return 0;
+#elif defined(__aarch64__)
+	// The threads of the first calls store the same value (relaxed atomic, no data race)
+	static int asimd = -1;
+	int r = __atomic_load_n(&asimd, __ATOMIC_RELAXED);
+
+	if(r < 0) {
+		r = (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+		__atomic_store_n(&asimd, r, __ATOMIC_RELAXED);
+	}
+
+	return r;
+#else
+	return 1;
+#endif
+}
+
+// Cyclic left 32 bit shift of the all lanes
+#define VROTL32(v, n)	(((v) << (n)) | ((v) >> (32 - (n))))
+
+#endif /* ESTREAM_SIMD */
+
+// out = buf ^ keystream, len - size of the message (the buffers may be unaligned, out may be buf)
+static inline void
+estream_xor(uint8_t *out, const uint8_t *buf, const uint8_t *keystream, uint32_t len)
+{
+#ifdef ESTREAM_SIMD
+	v16u8 x, k;
+
+	for(; len >= 16; len -= 16, buf += 16, keystream += 16, out += 16) {
+		memcpy(&x, buf, 16);
+		memcpy(&k, keystream, 16);
+		x ^= k;
+		memcpy(out, &x, 16);
+	}
+#endif
+	for(; len >= 4; len -= 4, buf += 4, keystream += 4, out += 4)
+		STORE32(out, LOAD32(buf) ^ LOAD32(keystream));
+
+	for(; len > 0; len--)
+		*out++ = *buf++ ^ *keystream++;
+}
+
+#endif /* ESTREAM_SIMD_H */
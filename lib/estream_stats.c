@@ -0,0 +1,185 @@
+/*
+ * Instrumentation counters of the ciphers.
+ * The counters of the thread are written only by the thread (relaxed atomic stores, no locks),
+ * the blocks of the threads are linked to the list on the first call and are never freed,
+ * so the snapshot reads them at any time.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "estream_stats.h"
+
+/*
+ * Counters of the thread
+ * alg - counters of the every algorithm
+ * calls - number of the crypt calls and of the setups of the thread (sampling of the durations)
+ * next - next block of the list
+*/
+struct estream_stats_thread {
+	struct estream_stats alg[ESTREAM_STATS_NALGS];
+	uint32_t calls[2];
+	struct estream_stats_thread *next;
+};
+
+// Relaxed atomic load and store of the counter (GCC 4.7), the older compilers (mips-linux-gnu-gcc-4.4):
+// volatile access (a 64-bit counter of the 32-bit processor may be read torn)
+#ifdef __ATOMIC_RELAXED
+#define STATS_LOAD(x)		__atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define STATS_STORE(x, v)	__atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#else
+#define STATS_LOAD(x)		(*(volatile uint64_t *)&(x))
+#define STATS_STORE(x, v)	(*(volatile uint64_t *)&(x) = (v))
+#endif
+
+static struct estream_stats_thread *threads;
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *stats_name[ESTREAM_STATS_NALGS] = { "Salsa", "Rabbit", "HC128", "Sosemanuk",
+						       "Grain", "Mickey", "Trivium", "GOST89" };
+
+// Name of the algorithm of the counters
+const char *
+estream_stats_name(int alg)
+{
+	if((alg < 0) || (alg >= ESTREAM_STATS_NALGS))
+		return NULL;
+
+	return stats_name[alg];
+}
+
+// Sum of the counters of the all threads
+void
+estream_stats_snapshot(struct estream_stats stats[ESTREAM_STATS_NALGS])
+{
+	struct estream_stats_thread *t;
+	uint64_t *sum, *x;
+	int i, j;
+
+	memset(stats, 0, ESTREAM_STATS_NALGS * sizeof(struct estream_stats));
+
+	pthread_mutex_lock(&threads_lock);
+
+	for(t = threads; t != NULL; t = t->next) {
+		for(i = 0; i < ESTREAM_STATS_NALGS; i++) {
+			sum = (uint64_t *)&stats[i];
+			x = (uint64_t *)&t->alg[i];
+
+			for(j = 0; j < sizeof(struct estream_stats) / sizeof(uint64_t); j++)
+				sum[j] += STATS_LOAD(x[j]);
+		}
+	}
+
+	pthread_mutex_unlock(&threads_lock);
+}
+
+#ifdef ESTREAM_STATS
+
+static __thread struct estream_stats_thread *thread_stats;
+
+// Counters of the current thread, NULL if the memory is not allocated (the call is not counted)
+static struct estream_stats_thread *
+stats_thread(void)
+{
+	struct estream_stats_thread *t = thread_stats;
+
+	if(t != NULL)
+		return t;
+
+	if((t = calloc(1, sizeof(struct estream_stats_thread))) == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&threads_lock);
+	t->next = threads;
+	threads = t;
+	pthread_mutex_unlock(&threads_lock);
+
+	thread_stats = t;
+
+	return t;
+}
+
+// Time stamp counter or the nanoseconds
+static uint64_t
+stats_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+// Add to the counter of the thread (the counter is written only by the thread)
+#define STATS_ADD(x, n)		STATS_STORE(x, (x) + (n))
+
+// Beginning of the call: every ESTREAM_STATS_SAMPLE-th crypt (setup) of the thread is timed
+// setup - 1 if the call is the setup of the key and IV, 0 if the crypt
+struct estream_stats_probe
+estream_stats_begin(uint32_t bytes, int setup)
+{
+	struct estream_stats_probe probe = { 0, bytes };
+	struct estream_stats_thread *t = stats_thread();
+
+	if((t != NULL) && ((++t->calls[setup] & (ESTREAM_STATS_SAMPLE - 1)) == 0))
+		probe.start = stats_cycles() | 1;
+
+	return probe;
+}
+
+// End of the crypt
+void
+estream_stats_crypt(const struct estream_stats_probe *probe, int alg, uint32_t block)
+{
+	struct estream_stats_thread *t = thread_stats;
+	struct estream_stats *s;
+
+	if(t == NULL)
+		return;
+
+	s = &t->alg[alg];
+
+	if(probe->start != 0) {
+		STATS_ADD(s->crypt_cycles, stats_cycles() - probe->start);
+		STATS_ADD(s->crypt_samples, 1);
+		STATS_ADD(s->crypt_sampled_bytes, probe->bytes);
+	}
+
+	STATS_ADD(s->crypt_calls, 1);
+	STATS_ADD(s->bytes, probe->bytes);
+	STATS_ADD(s->tail_bytes, probe->bytes % block);
+}
+
+// End of the setup of the key and IV
+void
+estream_stats_setup(const struct estream_stats_probe *probe, int alg)
+{
+	struct estream_stats_thread *t = thread_stats;
+	struct estream_stats *s;
+
+	if(t == NULL)
+		return;
+
+	s = &t->alg[alg];
+
+	if(probe->start != 0) {
+		STATS_ADD(s->setup_cycles, stats_cycles() - probe->start);
+		STATS_ADD(s->setup_samples, 1);
+	}
+
+	STATS_ADD(s->setup_calls, 1);
+}
+
+#endif /* ESTREAM_STATS */
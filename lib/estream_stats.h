@@ -0,0 +1,95 @@
+/*
+ * Instrumentation counters of the ciphers (compile-time option ESTREAM_STATS).
+ * Every thread has its own counters of every algorithm: crypt calls, bytes, tail bytes
+ * (the bytes of the last incomplete block of the call), setups of the key and IV,
+ * and the sampled durations (time stamp counter) of the every ESTREAM_STATS_SAMPLE-th crypt and setup.
+ * estream_stats_snapshot sums the counters of the all threads (the exited threads too).
+ * Without the ESTREAM_STATS the probes of the ciphers are empty and the snapshot is zero.
+*/
+
+#ifndef ESTREAM_STATS_H
+#define ESTREAM_STATS_H
+
+#include <stdint.h>
+
+// Algorithms of the counters (the numbers of the estream_speed_test)
+#define ESTREAM_STATS_SALSA	0
+#define ESTREAM_STATS_RABBIT	1
+#define ESTREAM_STATS_HC128	2
+#define ESTREAM_STATS_SOSEMANUK	3
+#define ESTREAM_STATS_GRAIN	4
+#define ESTREAM_STATS_MICKEY	5
+#define ESTREAM_STATS_TRIVIUM	6
+#define ESTREAM_STATS_GOST89	7
+
+// Number of the algorithms
+#define ESTREAM_STATS_NALGS	8
+
+// Every 64-th call of the thread is timed (power of two)
+#define ESTREAM_STATS_SAMPLE	64
+
+/*
+ * Counters of the algorithm
+ * crypt_calls, bytes - number of the crypt calls and the bytes of the calls
+ * tail_bytes - bytes of the incomplete blocks (the rest of the keystream block is discarded)
+ * setup_calls - number of the setups of the key and IV
+ * crypt_samples, crypt_sampled_bytes, crypt_cycles - timed crypt calls, their bytes and cycles
+ * setup_samples, setup_cycles - timed setups and their cycles
+ * The cycles are the time stamp counter (x86) or the nanoseconds (other processors).
+*/
+struct estream_stats {
+	uint64_t crypt_calls;
+	uint64_t bytes;
+	uint64_t tail_bytes;
+	uint64_t setup_calls;
+	uint64_t crypt_samples;
+	uint64_t crypt_sampled_bytes;
+	uint64_t crypt_cycles;
+	uint64_t setup_samples;
+	uint64_t setup_cycles;
+};
+
+// Sum of the counters of the all threads, stats[i] - algorithm i
+void estream_stats_snapshot(struct estream_stats stats[ESTREAM_STATS_NALGS]);
+
+// Name of the algorithm of the counters
+const char *estream_stats_name(int alg);
+
+#ifdef ESTREAM_STATS
+
+/*
+ * Probe of the call
+ * start - time stamp counter of the beginning, 0 if the call is not timed
+ * bytes - size of the message
+*/
+struct estream_stats_probe {
+	uint64_t start;
+	uint32_t bytes;
+};
+
+struct estream_stats_probe estream_stats_begin(uint32_t bytes, int setup);
+void estream_stats_crypt(const struct estream_stats_probe *probe, int alg, uint32_t block);
+void estream_stats_setup(const struct estream_stats_probe *probe, int alg);
+
+// Beginning of the crypt, bytes - size of the message
+#define ESTREAM_STATS_BEGIN(probe, bytes)	struct estream_stats_probe probe = estream_stats_begin((bytes), 0)
+
+// Beginning of the setup of the key and IV
+#define ESTREAM_STATS_BEGIN_SETUP(probe)	struct estream_stats_probe probe = estream_stats_begin(0, 1)
+
+// End of the crypt, block - size of the keystream block of the algorithm
+#define ESTREAM_STATS_CRYPT(probe, alg, block)	estream_stats_crypt(&(probe), (alg), (block))
+
+// End of the successful setup of the key and IV
+#define ESTREAM_STATS_SETUP(probe, alg)		estream_stats_setup(&(probe), (alg))
+
+#else
+
+#define ESTREAM_STATS_BEGIN(probe, bytes)
+#define ESTREAM_STATS_BEGIN_SETUP(probe)
+#define ESTREAM_STATS_CRYPT(probe, alg, block)
+#define ESTREAM_STATS_SETUP(probe, alg)
+
+#endif /* ESTREAM_STATS */
+
+#endif /* ESTREAM_STATS_H */
@@ -0,0 +1,34 @@
+/*
+ * USDT probes (sys/sdt.h) of the ciphers, compile-time option ESTREAM_USDT (make USDT=1).
+ * Provider estream, probes set_key__entry, set_key__return, crypt__entry, crypt__return.
+ * Arguments: algorithm (the numbers of the estream_stats.h), length in bytes (key or message), context,
+ * the return probes have the return value too (0, -1 of the bad length of the key or IV, 0 of the crypt).
+ * The return probe fires on every exit of the function.
+ * Example: bpftrace -e 'usdt:./libestream.so:estream:crypt__entry { @start[tid] = nsecs; }
+ *	usdt:./libestream.so:estream:crypt__return /@start[tid]/ { @ns[arg0] = hist(nsecs - @start[tid]); delete(@start[tid]); }'
+ * Without the ESTREAM_USDT the probes are empty.
+*/
+
+#ifndef ESTREAM_TRACE_H
+#define ESTREAM_TRACE_H
+
+#ifdef ESTREAM_USDT
+
+#include <stdint.h>
+#include <sys/sdt.h>
+
+// Entry of the function, the length is kept for the return probe
+#define ESTREAM_TRACE_ENTRY(name, alg, len, ctx)	const uint32_t trace_len = (len); \
+							DTRACE_PROBE3(estream, name##__entry, (alg), trace_len, (ctx))
+
+// Return of the function, res - return value
+#define ESTREAM_TRACE_RETURN(name, alg, ctx, res)	DTRACE_PROBE4(estream, name##__return, (alg), trace_len, (ctx), (res))
+
+#else
+
+#define ESTREAM_TRACE_ENTRY(name, alg, len, ctx)
+#define ESTREAM_TRACE_RETURN(name, alg, ctx, res)
+
+#endif /* ESTREAM_USDT */
+
+#endif /* ESTREAM_TRACE_H */
@@ -13,6 +13,8 @@
 
 #include "gost89.h"
 #include "macro.h"
+#include "estream_stats.h"
+#include "estream_trace.h"
 
 // Maximum GOST 28147-89 key length in bytes
 #define GOST89			32
@@ -24,7 +26,8 @@
 
 // n << 2 = n * 4
 // (0x12345678 >> 0) & 0xF = 0x8 (last 4 bits)
-#define SBOX(x, n)	(sbox[(n << 2) + ((x >> n) & 0xF)] << n)
+// The byte of the table is uint32_t before the shift (the int of the promotion overflows by the shift 28)
+#define SBOX(x, n)	((uint32_t)sbox[(n << 2) + ((x >> n) & 0xF)] << n)
 
 // GOST89 gamma update function
 #define GOST89_GAMMA_UPDATE(gamma) {	\
@@ -39,7 +42,7 @@
 }
 
 // Well-known Sbox used by Central Bank of Russia
-uint8_t sbox[] = {
+static const uint8_t sbox[] CACHE_ALIGNED = {
 	4, 10, 9, 2, 13, 8, 0, 14, 6, 11, 1, 12, 7, 15, 5, 3,
 	14, 11, 4, 12, 6, 13, 15, 10, 2, 3, 8, 1, 0, 7, 5, 9,
 	5, 8, 1, 13, 10, 3, 4, 2, 14, 15, 12, 7, 6, 0, 9, 11,
@@ -60,21 +63,29 @@ gost89_init(struct gost89_context *ctx)
 // Fill the gost89_context (secret key)
 // Return value: 0 (if all is well), -1 (is all bad)
 // Gamma - 64-bits length
-int
+ESTREAM_API int
 gost89_set_key_and_gamma(struct gost89_context *ctx, const uint8_t *key, const int keylen, const uint8_t gamma[8])
 {
+	ESTREAM_TRACE_ENTRY(set_key, ESTREAM_STATS_GOST89, keylen, ctx);
+	ESTREAM_STATS_BEGIN_SETUP(probe);
+
 	gost89_init(ctx);
 
 	if((keylen > 0) && (keylen <= GOST89))
 		ctx->keylen = keylen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_GOST89, ctx, -1);
 		return -1;
+	}
 	
 	memcpy(ctx->key, key, keylen);
 	memcpy(ctx->gamma, gamma, sizeof(ctx->gamma));
 
 	gost89_encrypt(ctx, ctx->gamma);
 
+	ESTREAM_STATS_SETUP(probe, ESTREAM_STATS_GOST89);
+	ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_GOST89, ctx, 0);
+
 	return 0;
 }
 
@@ -101,7 +112,7 @@ gost89_basic(struct gost89_context *ctx, uint32_t *n1, uint32_t *n2, const int x
  * ctx - pointer on gost89_context
  * n - pointer input buffer data (64 bytes)
 */
-void
+ESTREAM_API void
 gost89_encrypt(struct gost89_context *ctx, uint32_t *block)
 {
 	uint32_t *n1, *n2, temp;
@@ -125,7 +136,7 @@ gost89_encrypt(struct gost89_context *ctx, uint32_t *block)
 }
 
 // GOST89 decryption function. See gost89_encrypt
-void
+ESTREAM_API void
 gost89_decrypt(struct gost89_context *ctx, uint32_t *block)
 {
 	uint32_t *n1, *n2, temp;
@@ -155,18 +166,22 @@ gost89_decrypt(struct gost89_context *ctx, uint32_t *block)
  * out - pinter on output buffer data
  * buflen - length the data buffer
 */
-void
+ESTREAM_CLONES
+ESTREAM_API void
 gost89_gamma_crypt(struct gost89_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out)
 {
 	int i;
 	uint32_t gamma[2];
 
+	ESTREAM_TRACE_ENTRY(crypt, ESTREAM_STATS_GOST89, buflen, ctx);
+	ESTREAM_STATS_BEGIN(probe, buflen);
+
 	for(; buflen >= 8; buflen -= 8, buf += 8, out += 8) {
 		GOST89_GAMMA_UPDATE(ctx->gamma);
 		gost89_encrypt(ctx, ctx->gamma);
 
-		*(uint32_t *)(out + 0) = *(uint32_t *)(buf + 0) ^ U32TO32(ctx->gamma[0]);
-		*(uint32_t *)(out + 4) = *(uint32_t *)(buf + 4) ^ U32TO32(ctx->gamma[1]);
+		STORE32(out + 0, LOAD32(buf + 0) ^ U32TO32(ctx->gamma[0]));
+		STORE32(out + 4, LOAD32(buf + 4) ^ U32TO32(ctx->gamma[1]));
 	}
 
 	if(buflen > 0) {
@@ -176,8 +191,11 @@ gost89_gamma_crypt(struct gost89_context *ctx, const uint8_t *buf, uint32_t bufl
 		gamma[0] = U32TO32(ctx->gamma[0]);
 		gamma[1] = U32TO32(ctx->gamma[1]);
 
-		for(i = 0; i < 4; i++)
+		for(i = 0; i < buflen; i++)
 			out[i] = buf[i] ^ ((uint8_t *)gamma)[i];
 	}
+
+	ESTREAM_STATS_CRYPT(probe, ESTREAM_STATS_GOST89, 8);
+	ESTREAM_TRACE_RETURN(crypt, ESTREAM_STATS_GOST89, ctx, 0);
 }
 
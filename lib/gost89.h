@@ -7,6 +7,8 @@
 #ifndef GOST89_H
 #define GOST89_H
 
+#include "estream_inline.h"
+
 /*
  * GOST89 context
  * keylen - chiper key length in bytes
@@ -19,11 +21,15 @@ struct gost89_context {
 	uint32_t gamma[2];
 };
 
-int gost89_set_key_and_gamma(struct gost89_context *ctx, const uint8_t *key, const int keylen, const uint8_t gamma[8]);
+ESTREAM_API int gost89_set_key_and_gamma(struct gost89_context *ctx, const uint8_t *key, const int keylen, const uint8_t gamma[8]);
+
+ESTREAM_API void gost89_encrypt(struct gost89_context *ctx, uint32_t *block);
+ESTREAM_API void gost89_decrypt(struct gost89_context *ctx, uint32_t *block);
 
-void gost89_encrypt(struct gost89_context *ctx, uint32_t *block);
-void gost89_decrypt(struct gost89_context *ctx, uint32_t *block);
+ESTREAM_API void gost89_gamma_crypt(struct gost89_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
 
-void gost89_gamma_crypt(struct gost89_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
+#ifdef ESTREAM_INLINE
+#include "gost89.c"
+#endif
 
 #endif /* GOST89_H */
@@ -16,6 +16,9 @@
 #include <string.h>
 
 #include "grain.h"
+#include "macro.h"
+#include "estream_stats.h"
+#include "estream_trace.h"
 
 // Maximum Grain-128 key length in bytes
 #define GRAIN		16
@@ -97,26 +100,36 @@ grain_initialization_process(struct grain_context *ctx)
 
 // Fill the grain_context (key adn iv)
 // Return value: 0 (if all is well), -1 (is all bad)
-int
+ESTREAM_API int
 grain_set_key_and_iv(struct grain_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[12], const int ivlen)
 {
+	ESTREAM_TRACE_ENTRY(set_key, ESTREAM_STATS_GRAIN, keylen, ctx);
+	ESTREAM_STATS_BEGIN_SETUP(probe);
+
 	grain_init(ctx);
 
 	if((keylen <= GRAIN) && (keylen > 0))
 		ctx->keylen = keylen * 8;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_GRAIN, ctx, -1);
 		return -1;
+	}
 	
 	if((ivlen > 0) && (ivlen <= 12))
 		ctx->ivlen = ivlen * 8;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_GRAIN, ctx, -1);
 		return -1;
+	}
 	
 	memcpy(ctx->key, key, keylen);
 	memcpy(ctx->iv, iv, 12);
 
 	grain_initialization_process(ctx);
 
+	ESTREAM_STATS_SETUP(probe, ESTREAM_STATS_GRAIN);
+	ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_GRAIN, ctx, 0);
+
 	return 0;
 }
 
@@ -127,12 +140,16 @@ grain_set_key_and_iv(struct grain_context *ctx, const uint8_t *key, const int ke
  * buflen - length the data buffer
  * out - pointer on output buffer
 */
-void
+ESTREAM_CLONES
+ESTREAM_API void
 grain_crypt(struct grain_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out)
 {
 	uint8_t k = 0;
 	uint32_t i, j;	
 
+	ESTREAM_TRACE_ENTRY(crypt, ESTREAM_STATS_GRAIN, buflen, ctx);
+	ESTREAM_STATS_BEGIN(probe, buflen);
+
 	for(i = 0; i < buflen; i++) {
 		k = 0;
 
@@ -141,10 +158,13 @@ grain_crypt(struct grain_context *ctx, const uint8_t *buf, uint32_t buflen, uint
 
 		out[i] = buf[i] ^ k;
 	}
+
+	ESTREAM_STATS_CRYPT(probe, ESTREAM_STATS_GRAIN, 1);
+	ESTREAM_TRACE_RETURN(crypt, ESTREAM_STATS_GRAIN, ctx, 0);
 }
 
 // Test vectors print
-void
+ESTREAM_API void
 grain_test_vectors(struct grain_context *ctx)
 {
 	uint8_t keystream[16];
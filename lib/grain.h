@@ -7,6 +7,8 @@
 #ifndef GRAIN_H
 #define GRAIN_H
 
+#include "estream_inline.h"
+
 /*
  * Grain context
  * keylen - chiper key length in bits
@@ -25,10 +27,14 @@ struct grain_context {
 	uint8_t s[128];
 };
 
-int grain_set_key_and_iv(struct grain_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[12], const int ivlen);
+ESTREAM_API int grain_set_key_and_iv(struct grain_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[12], const int ivlen);
+
+ESTREAM_API void grain_crypt(struct grain_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
 
-void grain_crypt(struct grain_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
+ESTREAM_API void grain_test_vectors(struct grain_context *ctx);
 
-void grain_test_vectors(struct grain_context *ctx);
+#ifdef ESTREAM_INLINE
+#include "grain.c"
+#endif
 
 #endif
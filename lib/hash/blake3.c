@@ -0,0 +1,677 @@
+/*
+ * This program implements the BLAKE3 hash function.
+ * Author BLAKE3 algorithm - Jack O'Connor, Jean-Philippe Aumasson, Samuel Neves and Zooko Wilcox-O'Hearn.
+ * ----------------------
+ * The message is split into 1024-byte chunks, the chaining values of the chunks are
+ * merged by the binary tree of the parent nodes. Full subtrees of the update are
+ * compressed 4, 8 or 16 chunks at a time in the SIMD lanes (SSE4.1, AVX2, AVX-512),
+ * large subtrees are divided between the threads of the pool.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "blake3.h"
+#include "pool.h"
+#include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
+
+// Flags of the compression function
+#define CHUNK_START	1
+#define CHUNK_END	2
+#define PARENT		4
+#define ROOT		8
+
+// Minimum number of the chunks of the one thread
+#define BLAKE3_THREAD_CHUNKS	64
+
+// BLAKE3 initialization vector, the same as SHA256
+static const uint32_t IV[8] CACHE_ALIGNED = {
+	0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+	0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19 };
+
+// Message words of the 7 rounds
+static const uint8_t SCHEDULE[7][16] CACHE_ALIGNED = {
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{  2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8 },
+	{  3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1 },
+	{ 10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6 },
+	{ 12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4 },
+	{  9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7 },
+	{ 11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13 } };
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLAKE3_SIMD
+
+// 4 lanes, SSE4.1
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+#define BLAKE3_VEC		v4u32
+#define BLAKE3_LANES		4
+#define BLAKE3_HASH_LANES	blake3_hash4
+#include "blake3_kernel.h"
+#undef BLAKE3_VEC
+#undef BLAKE3_LANES
+#undef BLAKE3_HASH_LANES
+#pragma GCC pop_options
+
+// 8 lanes, AVX2
+#pragma GCC push_options
+#pragma GCC target("avx2")
+typedef uint32_t v8u32 __attribute__((vector_size(32)));
+#define BLAKE3_VEC		v8u32
+#define BLAKE3_LANES		8
+#define BLAKE3_HASH_LANES	blake3_hash8
+#include "blake3_kernel.h"
+#undef BLAKE3_VEC
+#undef BLAKE3_LANES
+#undef BLAKE3_HASH_LANES
+#pragma GCC pop_options
+
+// 16 lanes, AVX-512
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+typedef uint32_t v16u32 __attribute__((vector_size(64)));
+#define BLAKE3_VEC		v16u32
+#define BLAKE3_LANES		16
+#define BLAKE3_HASH_LANES	blake3_hash16
+#include "blake3_kernel.h"
+#undef BLAKE3_VEC
+#undef BLAKE3_LANES
+#undef BLAKE3_HASH_LANES
+#pragma GCC pop_options
+
+#endif /* BLAKE3_SIMD */
+
+// BLAKE3 G function
+#define G(a, b, c, d, x, y) {			\
+	v[a] = v[a] + v[b] + m[x];		\
+	v[d] = ROTR32((v[d] ^ v[a]), 16);	\
+	v[c] = v[c] + v[d];			\
+	v[b] = ROTR32((v[b] ^ v[c]), 12);	\
+	v[a] = v[a] + v[b] + m[y];		\
+	v[d] = ROTR32((v[d] ^ v[a]), 8);	\
+	v[c] = v[c] + v[d];			\
+	v[b] = ROTR32((v[b] ^ v[c]), 7);	\
+}
+
+/*
+ * Output of the node: input of the last compression, kept to compress
+ * it as the chaining value or as the root
+*/
+struct blake3_output {
+	uint32_t cv[8];
+	uint8_t block[64];
+	uint64_t counter;
+	int len;
+	uint8_t flags;
+};
+
+/*
+ * Task of the thread: chaining value of the full subtree
+ * data - first chunk of the subtree
+ * nchunks - number of the chunks (power of 2)
+ * key - key words
+ * counter - number of the first chunk
+ * lanes - kernel of the SIMD lanes of the context
+ * cv - chaining value
+*/
+struct blake3_task {
+	const uint8_t *data;
+	uint64_t nchunks;
+	const uint32_t *key;
+	uint64_t counter;
+	int lanes;
+	uint8_t cv[32];
+};
+
+// BLAKE3 compression function
+static void
+blake3_compress(const uint32_t cv[8], const uint8_t block[64], int len, uint64_t counter, uint8_t flags, uint32_t out[16])
+{
+	uint32_t v[16], m[16];
+	const uint8_t *s;
+	int i, r;
+
+	for(i = 0; i < 16; i++)
+		m[i] = U8TO32_LITTLE((block + i * 4));
+
+	for(i = 0; i < 8; i++)
+		v[i] = cv[i];
+
+	v[ 8] = IV[0];
+	v[ 9] = IV[1];
+	v[10] = IV[2];
+	v[11] = IV[3];
+	v[12] = (uint32_t)counter;
+	v[13] = (uint32_t)(counter >> 32);
+	v[14] = len;
+	v[15] = flags;
+
+	// BLAKE3 7 rounds
+	for(r = 0; r < 7; r++) {
+		s = SCHEDULE[r];
+
+		G(0, 4,  8, 12, s[ 0], s[ 1]);
+		G(1, 5,  9, 13, s[ 2], s[ 3]);
+		G(2, 6, 10, 14, s[ 4], s[ 5]);
+		G(3, 7, 11, 15, s[ 6], s[ 7]);
+		G(0, 5, 10, 15, s[ 8], s[ 9]);
+		G(1, 6, 11, 12, s[10], s[11]);
+		G(2, 7,  8, 13, s[12], s[13]);
+		G(3, 4,  9, 14, s[14], s[15]);
+	}
+
+	for(i = 0; i < 8; i++) {
+		out[i] = v[i] ^ v[i + 8];
+		out[i + 8] = v[i + 8] ^ cv[i];
+	}
+}
+
+// Chaining value of the output
+static void
+blake3_output_cv(const struct blake3_output *o, uint8_t cv[32])
+{
+	uint32_t out[16];
+	int i;
+
+	blake3_compress(o->cv, o->block, o->len, o->counter, o->flags, out);
+
+	for(i = 0; i < 8; i++)
+		U32TO8_LITTLE((cv + i * 4), out[i]);
+}
+
+// Output of the parent node: block - two chaining values of the children
+static void
+blake3_parent(struct blake3_output *o, const uint32_t key[8], const uint8_t block[64])
+{
+	memcpy(o->cv, key, sizeof(o->cv));
+	memcpy(o->block, block, 64);
+	o->counter = 0;
+	o->len = 64;
+	o->flags = PARENT;
+}
+
+// Number of the lanes used on this processor
+int
+blake3_lanes(void)
+{
+#ifdef BLAKE3_SIMD
+	if(__builtin_cpu_supports("avx512f"))
+		return 16;
+
+	if(__builtin_cpu_supports("avx2"))
+		return 8;
+
+	if(__builtin_cpu_supports("sse4.1"))
+		return 4;
+#endif
+	return 1;
+}
+
+// Kernel of the limit of the lanes: the widest kernel of the processor not wider than lanes, 0 - no limit
+static int
+blake3_kernel(int lanes)
+{
+	int max = blake3_lanes();
+
+	if((lanes == 0) || (lanes >= max))
+		return max;
+
+	if(lanes >= 8)
+		return 8;
+
+	return (lanes >= 4) ? 4 : 1;
+}
+
+/*
+ * Chaining values of the n inputs of the same number of the blocks (chunks or parent nodes)
+ * counter - counter of the first input, increment - next input has counter + 1
+ * lanes - kernel of the SIMD lanes (blake3_kernel)
+*/
+static void
+blake3_hash_many(const uint8_t *const *inputs, int n, int blocks, const uint32_t key[8], uint64_t counter,
+		 int increment, uint8_t flags_start, uint8_t flags_end, uint8_t *out, int lanes)
+{
+	uint32_t cv[8], out16[16];
+	int b, i;
+
+#ifdef BLAKE3_SIMD
+	for(; (lanes > 1) && (n >= lanes); n -= lanes, inputs += lanes, out += lanes * 32) {
+		if(lanes == 16)
+			blake3_hash16(inputs, blocks, key, counter, increment, 0, flags_start, flags_end, out);
+		else if(lanes == 8)
+			blake3_hash8(inputs, blocks, key, counter, increment, 0, flags_start, flags_end, out);
+		else
+			blake3_hash4(inputs, blocks, key, counter, increment, 0, flags_start, flags_end, out);
+
+		if(increment)
+			counter += lanes;
+	}
+#endif
+
+	// The remaining inputs one by one
+	for(; n > 0; n--, inputs++, out += 32) {
+		memcpy(cv, key, 32);
+
+		for(b = 0; b < blocks; b++) {
+			blake3_compress(cv, *inputs + b * 64, 64, counter,
+				(b == 0 ? flags_start : 0) | (b == blocks - 1 ? flags_end : 0), out16);
+			memcpy(cv, out16, sizeof(cv));
+		}
+
+		for(i = 0; i < 8; i++)
+			U32TO8_LITTLE((out + i * 4), cv[i]);
+
+		if(increment)
+			counter++;
+	}
+}
+
+// Chaining value of the full subtree: nchunks (power of 2) chunks from the data
+static void
+blake3_subtree(const uint8_t *data, uint64_t nchunks, const uint32_t key[8], uint64_t counter, int lanes, uint8_t cv[32])
+{
+	const uint8_t *inputs[16];
+	uint8_t cvs[16 * 32], pair[64];
+	int i, n;
+
+	// Leaves of the subtree: the chunks in the SIMD lanes, then the parents
+	if(nchunks <= 16) {
+		n = nchunks;
+
+		for(i = 0; i < n; i++)
+			inputs[i] = data + i * BLAKE3_CHUNK;
+
+		blake3_hash_many(inputs, n, BLAKE3_CHUNK / 64, key, counter, 1, CHUNK_START, CHUNK_END, cvs, lanes);
+
+		for(; n > 1; n /= 2) {
+			for(i = 0; i < n / 2; i++)
+				inputs[i] = cvs + i * 64;
+
+			blake3_hash_many(inputs, n / 2, 1, key, 0, 0, PARENT, PARENT, cvs, lanes);
+		}
+
+		memcpy(cv, cvs, 32);
+		return;
+	}
+
+	blake3_subtree(data, nchunks / 2, key, counter, lanes, pair);
+	blake3_subtree(data + nchunks / 2 * BLAKE3_CHUNK, nchunks / 2, key, counter + nchunks / 2, lanes, pair + 32);
+
+	inputs[0] = pair;
+	blake3_hash_many(inputs, 1, 1, key, 0, 0, PARENT, PARENT, cv, lanes);
+}
+
+// Thread task: chaining value of the full subtree
+static void
+blake3_task(void *arg)
+{
+	struct blake3_task *task = arg;
+
+	blake3_subtree(task->data, task->nchunks, task->key, task->counter, task->lanes, task->cv);
+}
+
+// Chaining values of the n (power of 2) parts of the subtree by the threads, merged up to the two children
+static void
+blake3_subtree_threads(struct blake3_context *ctx, const uint8_t *data, uint64_t nchunks, int n, uint8_t pair[64])
+{
+	struct blake3_task task[n];
+	struct pool_group group;
+	uint8_t cvs[n * 32];
+	const uint8_t *inputs[1];
+	uint64_t per;
+	int i;
+
+	per = nchunks / n;
+
+	pool_group_init(&group);
+
+	for(i = 0; i < n; i++) {
+		task[i].data = data + i * per * BLAKE3_CHUNK;
+		task[i].nchunks = per;
+		task[i].key = ctx->key;
+		task[i].counter = ctx->chunk.counter + i * per;
+		task[i].lanes = ctx->lanes;
+
+		// No memory for the task queue - hash in this thread
+		if(pool_submit_group(ctx->pool, &group, blake3_task, &task[i]))
+			blake3_task(&task[i]);
+	}
+
+	pool_wait_group(ctx->pool, &group);
+
+	for(i = 0; i < n; i++)
+		memcpy(cvs + i * 32, task[i].cv, 32);
+
+	for(; n > 2; n /= 2) {
+		for(i = 0; i < n / 2; i++) {
+			inputs[0] = cvs + i * 64;
+			blake3_hash_many(inputs, 1, 1, ctx->key, 0, 0, PARENT, PARENT, cvs + i * 32, ctx->lanes);
+		}
+	}
+
+	memcpy(pair, cvs, 64);
+}
+
+// Chaining values of the left and right children of the full subtree (nchunks >= 2)
+static void
+blake3_subtree_children(struct blake3_context *ctx, const uint8_t *data, uint64_t nchunks, uint8_t pair[64])
+{
+	int nthreads, n;
+
+	nthreads = (ctx->pool != NULL) ? pool_threads(ctx->pool) : 1;
+
+	// Number of the parts: power of 2, not less than the threads, if the parts are not too small
+	for(n = 2; (n < nthreads) && (nchunks / (n * 2) >= BLAKE3_THREAD_CHUNKS); n *= 2)
+		;
+
+	if((nthreads > 1) && (nchunks / n >= BLAKE3_THREAD_CHUNKS)) {
+		blake3_subtree_threads(ctx, data, nchunks, n, pair);
+		return;
+	}
+
+	blake3_subtree(data, nchunks / 2, ctx->key, ctx->chunk.counter, ctx->lanes, pair);
+	blake3_subtree(data + nchunks / 2 * BLAKE3_CHUNK, nchunks / 2, ctx->key,
+		ctx->chunk.counter + nchunks / 2, ctx->lanes, pair + 32);
+}
+
+// Reset the chunk state
+static void
+blake3_chunk_reset(struct blake3_context *ctx, uint64_t counter)
+{
+	memcpy(ctx->chunk.cv, ctx->key, sizeof(ctx->chunk.cv));
+	ctx->chunk.counter = counter;
+	ctx->chunk.nbytes = 0;
+	ctx->chunk.blocks = 0;
+}
+
+// Number of bytes of the current chunk
+static int
+blake3_chunk_len(struct blake3_chunk *chunk)
+{
+	return chunk->blocks * 64 + chunk->nbytes;
+}
+
+// Add the message to the chunk state, the last block is kept in the buffer
+static void
+blake3_chunk_update(struct blake3_chunk *chunk, const uint8_t *message, uint32_t msglen)
+{
+	uint32_t out[16];
+	uint32_t len;
+
+	while(msglen > 0) {
+		if(chunk->nbytes == 64) {
+			blake3_compress(chunk->cv, chunk->buffer, 64, chunk->counter,
+				chunk->blocks == 0 ? CHUNK_START : 0, out);
+			memcpy(chunk->cv, out, sizeof(chunk->cv));
+			chunk->blocks++;
+			chunk->nbytes = 0;
+		}
+
+		len = 64 - chunk->nbytes;
+		len = (msglen < len) ? msglen : len;
+
+		memcpy(chunk->buffer + chunk->nbytes, message, len);
+		chunk->nbytes += len;
+		message += len;
+		msglen -= len;
+	}
+}
+
+// Output of the chunk state
+static void
+blake3_chunk_output(struct blake3_chunk *chunk, struct blake3_output *o)
+{
+	memcpy(o->cv, chunk->cv, sizeof(o->cv));
+	memset(o->block, 0, sizeof(o->block));
+	memcpy(o->block, chunk->buffer, chunk->nbytes);
+	o->counter = chunk->counter;
+	o->len = chunk->nbytes;
+	o->flags = (chunk->blocks == 0 ? CHUNK_START : 0) | CHUNK_END;
+}
+
+// Merge the stack: after total_chunks chunks the stack has one value per bit of total_chunks
+static void
+blake3_merge_stack(struct blake3_context *ctx, uint64_t total_chunks)
+{
+	struct blake3_output o;
+	uint8_t *block;
+
+	while(ctx->nstack > __builtin_popcountll(total_chunks)) {
+		block = ctx->stack + (ctx->nstack - 2) * 32;
+		blake3_parent(&o, ctx->key, block);
+		blake3_output_cv(&o, block);
+		ctx->nstack--;
+	}
+}
+
+// Push the chaining value to the stack
+static void
+blake3_push(struct blake3_context *ctx, const uint8_t cv[32], uint64_t counter)
+{
+	blake3_merge_stack(ctx, counter);
+	memcpy(ctx->stack + ctx->nstack * 32, cv, 32);
+	ctx->nstack++;
+}
+
+// BLAKE3 initialization function
+void
+blake3_init(struct blake3_context *ctx)
+{
+	HASH_TRACE_ENTRY(init, HASH_TRACE_BLAKE3, 32, ctx);
+
+	memset(ctx, 0, sizeof(*ctx));
+
+	memcpy(ctx->key, IV, sizeof(ctx->key));
+	blake3_chunk_reset(ctx, 0);
+	ctx->lanes = blake3_lanes();
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_BLAKE3, ctx);
+}
+
+// BLAKE3 initialization function of the limit of the lanes
+void
+blake3_init_lanes(struct blake3_context *ctx, int lanes)
+{
+	blake3_init(ctx);
+
+	ctx->lanes = blake3_kernel(lanes);
+}
+
+// BLAKE3 initialization function of the multi-threaded mode
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+blake3_init_threads(struct blake3_context *ctx, int nthreads)
+{
+	blake3_init(ctx);
+
+	if(nthreads == 1)
+		return 0;
+
+	if((ctx->pool = pool_create(nthreads)) == NULL)
+		return -1;
+
+	ctx->own_pool = 1;
+
+	return 0;
+}
+
+// BLAKE3 initialization function of the shared pool
+void
+blake3_init_pool(struct blake3_context *ctx, struct pool *pool)
+{
+	blake3_init(ctx);
+
+	ctx->pool = pool;
+}
+
+// BLAKE3 update function
+void
+blake3_update(struct blake3_context *ctx, const void *message, uint32_t msglen)
+{
+	struct blake3_output o;
+	uint8_t cv[32], pair[64];
+	uint64_t nchunks;
+	uint32_t len;
+
+	HASH_TRACE_ENTRY(update, HASH_TRACE_BLAKE3, msglen, ctx);
+
+	// Fill the current chunk, it is closed only if the message continues
+	if(blake3_chunk_len(&ctx->chunk) > 0) {
+		len = BLAKE3_CHUNK - blake3_chunk_len(&ctx->chunk);
+		len = (msglen < len) ? msglen : len;
+
+		blake3_chunk_update(&ctx->chunk, message, len);
+		message += len;
+		msglen -= len;
+
+		if(msglen == 0) {
+			HASH_TRACE_RETURN(update, HASH_TRACE_BLAKE3, ctx);
+			return;
+		}
+
+		blake3_chunk_output(&ctx->chunk, &o);
+		blake3_output_cv(&o, cv);
+		blake3_push(ctx, cv, ctx->chunk.counter);
+		blake3_chunk_reset(ctx, ctx->chunk.counter + 1);
+	}
+
+	// Full subtrees directly from the message, the last chunk is kept for the final
+	while(msglen > BLAKE3_CHUNK) {
+
+		// The largest power of 2 chunks, aligned in the tree by the number of the chunks
+		for(nchunks = 1; nchunks * 2 * BLAKE3_CHUNK <= msglen; nchunks *= 2)
+			;
+
+		while(ctx->chunk.counter & (nchunks - 1))
+			nchunks /= 2;
+
+		if(nchunks == 1) {
+			blake3_chunk_update(&ctx->chunk, message, BLAKE3_CHUNK);
+			blake3_chunk_output(&ctx->chunk, &o);
+			blake3_output_cv(&o, cv);
+			blake3_push(ctx, cv, ctx->chunk.counter);
+		}
+		else {
+			// The children are pushed: the subtree may be the root of the tree
+			blake3_subtree_children(ctx, message, nchunks, pair);
+			blake3_push(ctx, pair, ctx->chunk.counter);
+			blake3_push(ctx, pair + 32, ctx->chunk.counter + nchunks / 2);
+		}
+
+		blake3_chunk_reset(ctx, ctx->chunk.counter + nchunks);
+		message += nchunks * BLAKE3_CHUNK;
+		msglen -= nchunks * BLAKE3_CHUNK;
+	}
+
+	if(msglen > 0) {
+		blake3_chunk_update(&ctx->chunk, message, msglen);
+		blake3_merge_stack(ctx, ctx->chunk.counter);
+	}
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_BLAKE3, ctx);
+}
+
+// Get the BLAKE3 hash of the message
+void
+blake3_final(struct blake3_context *ctx, uint8_t digest[32])
+{
+	struct blake3_output o;
+	uint8_t block[64];
+	uint32_t out[16];
+	int n, i;
+
+	HASH_TRACE_ENTRY(final, HASH_TRACE_BLAKE3, 32, ctx);
+
+	n = ctx->nstack;
+
+	// Output of the last chunk or of the last parent, then the parents up to the root
+	if((n == 0) || (blake3_chunk_len(&ctx->chunk) > 0)) {
+		blake3_chunk_output(&ctx->chunk, &o);
+	}
+	else {
+		n -= 2;
+		blake3_parent(&o, ctx->key, ctx->stack + n * 32);
+	}
+
+	while(n > 0) {
+		n--;
+		memcpy(block, ctx->stack + n * 32, 32);
+		blake3_output_cv(&o, block + 32);
+		blake3_parent(&o, ctx->key, block);
+	}
+
+	blake3_compress(o.cv, o.block, o.len, o.counter, o.flags | ROOT, out);
+
+	for(i = 0; i < 8; i++)
+		U32TO8_LITTLE((digest + i * 4), out[i]);
+
+	if(ctx->own_pool && (ctx->pool != NULL))
+		pool_destroy(ctx->pool);
+
+	ctx->pool = NULL;
+	ctx->own_pool = 0;
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_BLAKE3, ctx);
+}
+
+// Export the state of the incomplete message
+void
+blake3_export_state(const struct blake3_context *ctx, uint8_t state[BLAKE3_STATE_SIZE])
+{
+	uint8_t *p = state;
+
+	HASH_STATE_PUT_HEADER(p, "BLK3");
+	HASH_STATE_PUT32(p, ctx->key, 8);
+	HASH_STATE_PUT32(p, ctx->chunk.cv, 8);
+	U64TO8_LITTLE(p, ctx->chunk.counter);
+	p += 8;
+	HASH_STATE_PUT_BYTES(p, ctx->chunk.buffer, 64);
+	U32TO8_LITTLE(p, ctx->chunk.nbytes);
+	U32TO8_LITTLE((p + 4), ctx->chunk.blocks);
+	U32TO8_LITTLE((p + 8), ctx->nstack);
+	p += 12;
+	HASH_STATE_PUT_BYTES(p, ctx->stack, sizeof(ctx->stack));
+}
+
+// Import the state exported by blake3_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+blake3_import_state(struct blake3_context *ctx, const uint8_t state[BLAKE3_STATE_SIZE])
+{
+	const uint8_t *p = state;
+	uint32_t nbytes, blocks, nstack;
+
+	if(!HASH_STATE_CHECK_HEADER(p, "BLK3"))
+		return -1;
+
+	p += HASH_STATE_HEADER + 32 + 32 + 8 + 64;
+
+	nbytes = U8TO32_LITTLE(p);
+	blocks = U8TO32_LITTLE((p + 4));
+	nstack = U8TO32_LITTLE((p + 8));
+
+	// The last block of the chunk is in the buffer
+	if((nbytes > 64) || (blocks * 64 + nbytes > BLAKE3_CHUNK) || (nstack > BLAKE3_MAX_DEPTH + 1))
+		return -1;
+
+	p = state + HASH_STATE_HEADER;
+
+	HASH_STATE_GET32(p, ctx->key, 8);
+	HASH_STATE_GET32(p, ctx->chunk.cv, 8);
+	ctx->chunk.counter = U8TO64_LITTLE(p);
+	p += 8;
+	HASH_STATE_GET_BYTES(p, ctx->chunk.buffer, 64);
+	p += 12;
+	HASH_STATE_GET_BYTES(p, ctx->stack, sizeof(ctx->stack));
+
+	ctx->chunk.nbytes = nbytes;
+	ctx->chunk.blocks = blocks;
+	ctx->nstack = nstack;
+
+	return 0;
+}
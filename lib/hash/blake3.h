@@ -0,0 +1,88 @@
+/*
+ * BLAKE3 - hash function with the built-in Merkle tree, 2020 year.
+ * Author BLAKE3 algorithm - Jack O'Connor, Jean-Philippe Aumasson, Samuel Neves and Zooko Wilcox-O'Hearn.
+ * The chunks of the message are compressed in parallel SIMD lanes (SSE4.1, AVX2, AVX-512)
+ * and, optionally, the subtrees are compressed by the thread pool.
+ * Hash size - 256 bits
+*/
+
+#ifndef BLAKE3_H
+#define BLAKE3_H
+
+// Size in bytes of the chunk (leaf of the tree)
+#define BLAKE3_CHUNK	1024
+
+// Maximum depth of the tree (2^54 chunks = 2^64 bytes)
+#define BLAKE3_MAX_DEPTH	54
+
+// Size in bytes of the exported state: key, chunk state, stack of the chaining values
+#define BLAKE3_STATE_SIZE	(8 + 32 + 32 + 8 + 64 + 12 + (BLAKE3_MAX_DEPTH + 1) * 32)
+
+/*
+ * BLAKE3 chunk state
+ * cv - 256 bits chaining value
+ * counter - number of the chunk
+ * buffer - 512 bits input block
+ * nbytes - number of bytes in the buffer
+ * blocks - number of the compressed blocks of the chunk
+*/
+struct blake3_chunk {
+	uint32_t cv[8];
+	uint64_t counter;
+	uint8_t buffer[64];
+	int nbytes;
+	int blocks;
+};
+
+struct pool;
+
+/*
+ * BLAKE3 algorithm context
+ * key - 256 bits key words (IV for the hash mode)
+ * chunk - state of the current chunk
+ * nstack - number of the chaining values in the stack
+ * stack - chaining values of the subtrees waiting to be merged
+ * pool - thread pool of the multi-threaded mode, NULL if one thread
+ * own_pool - the pool is created by blake3_init_threads and destroyed by the final function
+ * lanes - number of the SIMD lanes of the chunks (16, 8, 4, 1), set by the initialization function
+*/
+struct blake3_context {
+	uint32_t key[8];
+	struct blake3_chunk chunk;
+	int nstack;
+	uint8_t stack[(BLAKE3_MAX_DEPTH + 1) * 32];
+	struct pool *pool;
+	int own_pool;
+	int lanes;
+};
+
+// Number of the SIMD lanes of the chunks used on this processor (16, 8, 4 or 1)
+int blake3_lanes(void);
+
+void blake3_init(struct blake3_context *ctx);
+
+// BLAKE3 initialization function of the limit of the lanes (16, 8, 4, 1), 0 - all lanes of the processor
+// The kernels may be compared on one processor (tests), the other contexts are not changed
+void blake3_init_lanes(struct blake3_context *ctx, int lanes);
+
+// Multi-threaded mode: large updates are split into subtrees hashed by the thread pool
+// nthreads - number of the threads, 0 - number of the processors
+// Return value: 0 (if all is well), -1 (if all bad)
+int blake3_init_threads(struct blake3_context *ctx, int nthreads);
+
+// Multi-threaded mode of the shared pool, the pool is not destroyed by the final function
+void blake3_init_pool(struct blake3_context *ctx, struct pool *pool);
+
+void blake3_update(struct blake3_context *ctx, const void *message, uint32_t msglen);
+
+// Frees the thread pool of the multi-threaded mode
+void blake3_final(struct blake3_context *ctx, uint8_t digest[32]);
+
+// Export the state of the incomplete message (the context is not changed)
+void blake3_export_state(const struct blake3_context *ctx, uint8_t state[BLAKE3_STATE_SIZE]);
+
+// Import the state exported by blake3_export_state, the thread pool of the context is kept
+// Return value: 0 (if all is well), -1 (if the state is not BLAKE3, the version is unknown or the state is damaged)
+int blake3_import_state(struct blake3_context *ctx, const uint8_t state[BLAKE3_STATE_SIZE]);
+
+#endif /* BLAKE3_H */
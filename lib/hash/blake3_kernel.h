@@ -0,0 +1,111 @@
+/*
+ * BLAKE3 compression kernel of the parallel lanes.
+ * The file is included by blake3.c once per vector width, before including define:
+ * BLAKE3_VEC - vector type of the 32-bit lanes
+ * BLAKE3_LANES - number of the lanes in BLAKE3_VEC
+ * BLAKE3_HASH_LANES - name of the kernel function
+ * Every lane compresses its own input (chunk or parent node) of the same number of blocks.
+*/
+
+// Cyclic right 32 bit shift of the all lanes
+#define VROTR32(v, n)	(((v) >> (n)) | ((v) << (32 - (n))))
+
+// BLAKE3 G function
+#define VG(a, b, c, d, x, y) {				\
+	v[a] = v[a] + v[b] + m[x];			\
+	v[d] = VROTR32((v[d] ^ v[a]), 16);		\
+	v[c] = v[c] + v[d];				\
+	v[b] = VROTR32((v[b] ^ v[c]), 12);		\
+	v[a] = v[a] + v[b] + m[y];			\
+	v[d] = VROTR32((v[d] ^ v[a]), 8);		\
+	v[c] = v[c] + v[d];				\
+	v[b] = VROTR32((v[b] ^ v[c]), 7);		\
+}
+
+/*
+ * inputs - BLAKE3_LANES pointers of the inputs
+ * blocks - number of the 64-byte blocks of the every input
+ * counter - counter of the first lane, increment - next lane has counter + 1
+ * flags_start, flags_end - flags of the first and the last block
+ * out - BLAKE3_LANES chaining values
+*/
+static void
+BLAKE3_HASH_LANES(const uint8_t *const *inputs, int blocks, const uint32_t key[8], uint64_t counter,
+		  int increment, uint8_t flags, uint8_t flags_start, uint8_t flags_end, uint8_t *out)
+{
+	uint32_t w[16][BLAKE3_LANES] __attribute__((aligned(64)));
+	BLAKE3_VEC h[8], v[16], m[16], lo, hi;
+	const uint8_t *s;
+	uint8_t f;
+	int b, i, l, r;
+
+	for(i = 0; i < 8; i++)
+		h[i] = (BLAKE3_VEC){ 0 } + key[i];
+
+	for(l = 0; l < BLAKE3_LANES; l++) {
+		w[0][l] = (uint32_t)(counter + (increment ? l : 0));
+		w[1][l] = (uint32_t)((counter + (increment ? l : 0)) >> 32);
+	}
+
+	memcpy(&lo, w[0], sizeof(lo));
+	memcpy(&hi, w[1], sizeof(hi));
+
+	for(b = 0; b < blocks; b++) {
+
+		// Transpose the message words: word i of the lane l to w[i][l]
+		for(l = 0; l < BLAKE3_LANES; l++)
+			for(i = 0; i < 16; i++)
+				w[i][l] = U8TO32_LITTLE((inputs[l] + b * 64 + i * 4));
+
+		for(i = 0; i < 16; i++)
+			memcpy(&m[i], w[i], sizeof(m[i]));
+
+		f = flags;
+
+		if(b == 0)
+			f |= flags_start;
+
+		if(b == blocks - 1)
+			f |= flags_end;
+
+		for(i = 0; i < 8; i++)
+			v[i] = h[i];
+
+		v[ 8] = (BLAKE3_VEC){ 0 } + IV[0];
+		v[ 9] = (BLAKE3_VEC){ 0 } + IV[1];
+		v[10] = (BLAKE3_VEC){ 0 } + IV[2];
+		v[11] = (BLAKE3_VEC){ 0 } + IV[3];
+		v[12] = lo;
+		v[13] = hi;
+		v[14] = (BLAKE3_VEC){ 0 } + 64;
+		v[15] = (BLAKE3_VEC){ 0 } + f;
+
+		// BLAKE3 7 rounds
+		for(r = 0; r < 7; r++) {
+			s = SCHEDULE[r];
+
+			VG(0, 4,  8, 12, s[ 0], s[ 1]);
+			VG(1, 5,  9, 13, s[ 2], s[ 3]);
+			VG(2, 6, 10, 14, s[ 4], s[ 5]);
+			VG(3, 7, 11, 15, s[ 6], s[ 7]);
+			VG(0, 5, 10, 15, s[ 8], s[ 9]);
+			VG(1, 6, 11, 12, s[10], s[11]);
+			VG(2, 7,  8, 13, s[12], s[13]);
+			VG(3, 4,  9, 14, s[14], s[15]);
+		}
+
+		for(i = 0; i < 8; i++)
+			h[i] = v[i] ^ v[i + 8];
+	}
+
+	// Transpose back the chaining values
+	for(i = 0; i < 8; i++)
+		memcpy(w[i], &h[i], sizeof(h[i]));
+
+	for(l = 0; l < BLAKE3_LANES; l++)
+		for(i = 0; i < 8; i++)
+			U32TO8_LITTLE((out + l * 32 + i * 4), w[i][l]);
+}
+
+#undef VROTR32
+#undef VG
@@ -0,0 +1,65 @@
+/*
+ * Exported state (midstate) of the hash functions.
+ * State: tag of the algorithm (4 bytes), version of the format (32 bits), fields of the context.
+ * All words are little-endian, so the state may be resumed on the other machine.
+ * The macros need "../macro.h" and move the pointer p after the written (read) data.
+*/
+
+#ifndef HASH_STATE_H
+#define HASH_STATE_H
+
+// Version of the format of the states
+#define HASH_STATE_VERSION	1
+
+// Size in bytes of the header of the state
+#define HASH_STATE_HEADER	8
+
+// Write the header of the state
+#define HASH_STATE_PUT_HEADER(p, tag) {			\
+	memcpy(p, tag, 4);					\
+	U32TO8_LITTLE((p + 4), HASH_STATE_VERSION);		\
+	p += HASH_STATE_HEADER;					\
+}
+
+// Check the header of the state: 1 (if the tag and the version are correct), 0 (if not)
+#define HASH_STATE_CHECK_HEADER(p, tag) \
+	(!memcmp(p, tag, 4) && (U8TO32_LITTLE((p + 4)) == HASH_STATE_VERSION))
+
+// Write (read) n 32-bit words of the array x
+#define HASH_STATE_PUT32(p, x, n) {			\
+	int i_;							\
+	for(i_ = 0; i_ < (n); i_++, p += 4)			\
+		U32TO8_LITTLE(p, (x)[i_]);			\
+}
+
+#define HASH_STATE_GET32(p, x, n) {			\
+	int i_;							\
+	for(i_ = 0; i_ < (n); i_++, p += 4)			\
+		(x)[i_] = U8TO32_LITTLE(p);			\
+}
+
+// Write (read) n 64-bit words of the array x
+#define HASH_STATE_PUT64(p, x, n) {			\
+	int i_;							\
+	for(i_ = 0; i_ < (n); i_++, p += 8)			\
+		U64TO8_LITTLE(p, (x)[i_]);			\
+}
+
+#define HASH_STATE_GET64(p, x, n) {			\
+	int i_;							\
+	for(i_ = 0; i_ < (n); i_++, p += 8)			\
+		(x)[i_] = U8TO64_LITTLE(p);			\
+}
+
+// Write (read) n bytes of the array x
+#define HASH_STATE_PUT_BYTES(p, x, n) {			\
+	memcpy(p, x, n);					\
+	p += (n);						\
+}
+
+#define HASH_STATE_GET_BYTES(p, x, n) {			\
+	memcpy(x, p, n);					\
+	p += (n);						\
+}
+
+#endif /* HASH_STATE_H */
@@ -0,0 +1,50 @@
+/*
+ * USDT probes (sys/sdt.h) of the HASH functions, compile-time option ESTREAM_USDT (make USDT=1).
+ * Provider hash, probes init__entry, init__return, update__entry, update__return, final__entry, final__return.
+ * Arguments: algorithm (the numbers of the hashsum), length in bytes (message of the update,
+ * hash of the init and final, threads of the KangarooTwelve init), context.
+ * Example: bpftrace -e 'usdt:./libestream.so:hash:update__entry { @bytes[arg0] = hist(arg1); }'
+ * Without the ESTREAM_USDT the probes are empty.
+*/
+
+#ifndef HASH_TRACE_H
+#define HASH_TRACE_H
+
+// Algorithms of the probes
+#define HASH_TRACE_MD5		0
+#define HASH_TRACE_SHA1		1
+#define HASH_TRACE_SHA224	2
+#define HASH_TRACE_SHA256	3
+#define HASH_TRACE_SHA384	4
+#define HASH_TRACE_SHA512	5
+#define HASH_TRACE_SHA3_224	6
+#define HASH_TRACE_SHA3_256	7
+#define HASH_TRACE_SHA3_384	8
+#define HASH_TRACE_SHA3_512	9
+#define HASH_TRACE_K12		10
+#define HASH_TRACE_BLAKE3	11
+
+// SHA3 algorithm by the size in bytes of the hash
+#define HASH_TRACE_SHA3(size)	(((size) == 28) ? HASH_TRACE_SHA3_224 : ((size) == 32) ? HASH_TRACE_SHA3_256 : \
+				 ((size) == 48) ? HASH_TRACE_SHA3_384 : HASH_TRACE_SHA3_512)
+
+#ifdef ESTREAM_USDT
+
+#include <stdint.h>
+#include <sys/sdt.h>
+
+// Entry of the function, the length is kept for the return probe
+#define HASH_TRACE_ENTRY(name, alg, len, ctx)	const uint32_t trace_len = (len); \
+						DTRACE_PROBE3(hash, name##__entry, (alg), trace_len, (ctx))
+
+// Return of the function
+#define HASH_TRACE_RETURN(name, alg, ctx)	DTRACE_PROBE3(hash, name##__return, (alg), trace_len, (ctx))
+
+#else
+
+#define HASH_TRACE_ENTRY(name, alg, len, ctx)
+#define HASH_TRACE_RETURN(name, alg, ctx)
+
+#endif /* ESTREAM_USDT */
+
+#endif /* HASH_TRACE_H */
@@ -0,0 +1,272 @@
+/*
+ * This program implements the HMAC (RFC 2104) and HKDF (RFC 5869) functions.
+ * HMAC(K, m) = H((K XOR opad) || H((K XOR ipad) || m)).
+ * ----------------------
+ * The hash contexts after the first block of the inner and outer hash do not depend
+ * on the message. They are calculated once by hmac_set_key and copied for every message.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "hmac.h"
+
+typedef void (*update_t)(void *ctx, const void *message, uint32_t msglen);
+typedef void (*final_t)(void *ctx, uint8_t *digest);
+
+/*
+ * Hash function of the HMAC
+ * block - size in bytes of the block
+ * size - size in bytes of the hash
+ * ctxsize - size in bytes of the hash context
+*/
+struct hmac_func {
+	int block;
+	int size;
+	int ctxsize;
+};
+
+static const struct hmac_func func[10] = {
+	{  64, 16, sizeof(struct md5_context) },
+	{  64, 20, sizeof(struct sha1_context) },
+	{  64, 28, sizeof(struct sha224_context) },
+	{  64, 32, sizeof(struct sha256_context) },
+	{ 128, 48, sizeof(struct sha384_context) },
+	{ 128, 64, sizeof(struct sha512_context) },
+	{ 144, 28, sizeof(struct sha3_context) },
+	{ 136, 32, sizeof(struct sha3_context) },
+	{ 104, 48, sizeof(struct sha3_context) },
+	{  72, 64, sizeof(struct sha3_context) } };
+
+// Pointer of the function HASH functions
+static const update_t update[10] = {
+	(update_t)md5_update,
+	(update_t)sha1_update,
+	(update_t)sha224_update,
+	(update_t)sha256_update,
+	(update_t)sha384_update,
+	(update_t)sha512_update,
+	(update_t)sha3_update,
+	(update_t)sha3_update,
+	(update_t)sha3_update,
+	(update_t)sha3_update };
+
+static const final_t final[10] = {
+	(final_t)md5_final,
+	(final_t)sha1_final,
+	(final_t)sha224_final,
+	(final_t)sha256_final,
+	(final_t)sha384_final,
+	(final_t)sha512_final,
+	(final_t)sha3_final,
+	(final_t)sha3_final,
+	(final_t)sha3_final,
+	(final_t)sha3_final };
+
+// Initialization of the hash context
+static void
+hmac_hash_init(union hmac_hash *hash, int alg)
+{
+	switch(alg) {
+	case HMAC_MD5 : md5_init(&hash->md5);
+			break;
+	case HMAC_SHA1 : sha1_init(&hash->sha1);
+			 break;
+	case HMAC_SHA224 : sha224_init(&hash->sha224);
+			   break;
+	case HMAC_SHA256 : sha256_init(&hash->sha256);
+			   break;
+	case HMAC_SHA384 : sha384_init(&hash->sha384);
+			   break;
+	case HMAC_SHA512 : sha512_init(&hash->sha512);
+			   break;
+	case HMAC_SHA3_224 : sha3_init(&hash->sha3, 224);
+			     break;
+	case HMAC_SHA3_256 : sha3_init(&hash->sha3, 256);
+			     break;
+	case HMAC_SHA3_384 : sha3_init(&hash->sha3, 384);
+			     break;
+	case HMAC_SHA3_512 : sha3_init(&hash->sha3, 512);
+			     break;
+	}
+}
+
+// Size in bytes of the HMAC, -1 if no such algorithm
+int
+hmac_size(int alg)
+{
+	if((alg < 0) || (alg > HMAC_SHA3_512))
+		return -1;
+
+	return func[alg].size;
+}
+
+// Precompute the HMAC key
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+hmac_set_key(struct hmac_key *key, int alg, const uint8_t *k, uint32_t keylen)
+{
+	uint8_t block[HMAC_MAX_BLOCK];
+	int i, n;
+
+	if(hmac_size(alg) < 0)
+		return -1;
+
+	n = func[alg].block;
+
+	memset(block, 0, sizeof(block));
+
+	// The key longer than the block is replaced by its hash
+	if(keylen > n) {
+		hmac_hash_init(&key->inner, alg);
+		update[alg](&key->inner, k, keylen);
+		final[alg](&key->inner, block);
+	}
+	else
+		memcpy(block, k, keylen);
+
+	key->alg = alg;
+
+	// Inner hash after the block (key XOR ipad)
+	for(i = 0; i < n; i++)
+		block[i] ^= 0x36;
+
+	hmac_hash_init(&key->inner, alg);
+	update[alg](&key->inner, block, n);
+
+	// Outer hash after the block (key XOR opad)
+	for(i = 0; i < n; i++)
+		block[i] ^= 0x36 ^ 0x5C;
+
+	hmac_hash_init(&key->outer, alg);
+	update[alg](&key->outer, block, n);
+
+	memset(block, 0, sizeof(block));
+
+	return 0;
+}
+
+// HMAC initialization function
+void
+hmac_init(struct hmac_context *ctx, const struct hmac_key *key)
+{
+	ctx->key = key;
+	memcpy(&ctx->hash, &key->inner, func[key->alg].ctxsize);
+}
+
+// HMAC update function
+void
+hmac_update(struct hmac_context *ctx, const void *message, uint32_t msglen)
+{
+	update[ctx->key->alg](&ctx->hash, message, msglen);
+}
+
+// HMAC final function
+// digest - hmac_size(alg) bytes
+void
+hmac_final(struct hmac_context *ctx, uint8_t *digest)
+{
+	uint8_t inner[HMAC_MAX_SIZE];
+	int alg = ctx->key->alg;
+
+	final[alg](&ctx->hash, inner);
+
+	memcpy(&ctx->hash, &ctx->key->outer, func[alg].ctxsize);
+	update[alg](&ctx->hash, inner, func[alg].size);
+	final[alg](&ctx->hash, digest);
+}
+
+// HMAC of the message
+void
+hmac(const struct hmac_key *key, const void *message, uint32_t msglen, uint8_t *digest)
+{
+	struct hmac_context ctx;
+
+	hmac_init(&ctx, key);
+	hmac_update(&ctx, message, msglen);
+	hmac_final(&ctx, digest);
+}
+
+// HKDF extract: prk = HMAC(salt, ikm)
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+hkdf_extract(int alg, const uint8_t *salt, uint32_t saltlen, const uint8_t *ikm, uint32_t ikmlen, uint8_t *prk)
+{
+	uint8_t zero[HMAC_MAX_SIZE];
+	struct hmac_key key;
+
+	if(hmac_size(alg) < 0)
+		return -1;
+
+	// No salt - string of the zeros of the hash size
+	if(salt == NULL) {
+		memset(zero, 0, sizeof(zero));
+		salt = zero;
+		saltlen = func[alg].size;
+	}
+
+	hmac_set_key(&key, alg, salt, saltlen);
+	hmac(&key, ikm, ikmlen, prk);
+
+	return 0;
+}
+
+// HKDF expand: T(i) = HMAC(prk, T(i-1) || info || i), okm = T(1) || T(2) || ...
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+hkdf_expand(int alg, const uint8_t *prk, uint32_t prklen, const uint8_t *info, uint32_t infolen, uint8_t *okm, uint32_t okmlen)
+{
+	struct hmac_key key;
+	struct hmac_context ctx;
+	uint8_t t[HMAC_MAX_SIZE];
+	uint8_t i;
+	int size, len;
+
+	if((size = hmac_size(alg)) < 0)
+		return -1;
+
+	if(okmlen > 255 * size)
+		return -1;
+
+	hmac_set_key(&key, alg, prk, prklen);
+
+	for(i = 1; okmlen > 0; i++) {
+		hmac_init(&ctx, &key);
+
+		if(i > 1)
+			hmac_update(&ctx, t, size);
+
+		hmac_update(&ctx, info, infolen);
+		hmac_update(&ctx, &i, 1);
+		hmac_final(&ctx, t);
+
+		len = (okmlen < size) ? okmlen : size;
+		memcpy(okm, t, len);
+		okm += len;
+		okmlen -= len;
+	}
+
+	memset(t, 0, sizeof(t));
+
+	return 0;
+}
+
+// HKDF: extract, then expand
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+hkdf(int alg, const uint8_t *salt, uint32_t saltlen, const uint8_t *ikm, uint32_t ikmlen,
+     const uint8_t *info, uint32_t infolen, uint8_t *okm, uint32_t okmlen)
+{
+	uint8_t prk[HMAC_MAX_SIZE];
+
+	if(hkdf_extract(alg, salt, saltlen, ikm, ikmlen, prk))
+		return -1;
+
+	if(hkdf_expand(alg, prk, hmac_size(alg), info, infolen, okm, okmlen))
+		return -1;
+
+	memset(prk, 0, sizeof(prk));
+
+	return 0;
+}
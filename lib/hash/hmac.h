@@ -0,0 +1,99 @@
+/*
+ * HMAC - keyed-hash message authentication code (RFC 2104).
+ * HKDF - HMAC-based key derivation function (RFC 5869).
+ * Hash functions - MD5, SHA1, SHA224, SHA256, SHA384, SHA512, SHA3/224, SHA3/256, SHA3/384, SHA3/512.
+ * The key object keeps the hash contexts after the (key XOR ipad) and (key XOR opad) blocks,
+ * so HMAC of the short message costs two compressions plus the message.
+*/
+
+#ifndef HMAC_H
+#define HMAC_H
+
+#include "md5.h"
+#include "sha1.h"
+#include "sha224.h"
+#include "sha256.h"
+#include "sha384.h"
+#include "sha512.h"
+#include "sha3.h"
+
+// Hash functions of the HMAC, numbers are the same as in the hashsum
+#define HMAC_MD5	0
+#define HMAC_SHA1	1
+#define HMAC_SHA224	2
+#define HMAC_SHA256	3
+#define HMAC_SHA384	4
+#define HMAC_SHA512	5
+#define HMAC_SHA3_224	6
+#define HMAC_SHA3_256	7
+#define HMAC_SHA3_384	8
+#define HMAC_SHA3_512	9
+
+// Maximum size in bytes of the hash and of the block
+#define HMAC_MAX_SIZE	64
+#define HMAC_MAX_BLOCK	144
+
+// Union all structures HASH functions
+union hmac_hash {
+	struct md5_context md5;
+	struct sha1_context sha1;
+	struct sha224_context sha224;
+	struct sha256_context sha256;
+	struct sha384_context sha384;
+	struct sha512_context sha512;
+	struct sha3_context sha3;
+};
+
+/*
+ * HMAC key
+ * alg - hash function
+ * inner - hash context after the block (key XOR ipad)
+ * outer - hash context after the block (key XOR opad)
+*/
+struct hmac_key {
+	int alg;
+	union hmac_hash inner;
+	union hmac_hash outer;
+};
+
+/*
+ * HMAC context of the message
+ * key - HMAC key
+ * hash - inner hash context of the message
+*/
+struct hmac_context {
+	const struct hmac_key *key;
+	union hmac_hash hash;
+};
+
+// Size in bytes of the HMAC, -1 if no such algorithm
+int hmac_size(int alg);
+
+// Precompute the HMAC key
+// Return value: 0 (if all is well), -1 (if all bad)
+int hmac_set_key(struct hmac_key *key, int alg, const uint8_t *k, uint32_t keylen);
+
+// HMAC of the message in parts: init, update, final
+void hmac_init(struct hmac_context *ctx, const struct hmac_key *key);
+
+void hmac_update(struct hmac_context *ctx, const void *message, uint32_t msglen);
+
+void hmac_final(struct hmac_context *ctx, uint8_t *digest);
+
+// HMAC of the message
+void hmac(const struct hmac_key *key, const void *message, uint32_t msglen, uint8_t *digest);
+
+// HKDF extract: prk = HMAC(salt, ikm), prk is hmac_size(alg) bytes
+// Return value: 0 (if all is well), -1 (if all bad)
+int hkdf_extract(int alg, const uint8_t *salt, uint32_t saltlen, const uint8_t *ikm, uint32_t ikmlen, uint8_t *prk);
+
+// HKDF expand: okmlen bytes (not more than 255 * hmac_size(alg)) of the key material
+// Return value: 0 (if all is well), -1 (if all bad)
+int hkdf_expand(int alg, const uint8_t *prk, uint32_t prklen, const uint8_t *info, uint32_t infolen, uint8_t *okm, uint32_t okmlen);
+
+// HKDF: extract, then expand
+// Return value: 0 (if all is well), -1 (if all bad)
+int hkdf(int alg, const uint8_t *salt, uint32_t saltlen, const uint8_t *ikm, uint32_t ikmlen,
+	 const uint8_t *info, uint32_t infolen, uint8_t *okm, uint32_t okmlen);
+
+#endif /* HMAC_H */
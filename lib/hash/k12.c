@@ -0,0 +1,431 @@
+/*
+ * This program implements the KangarooTwelve tree hash function.
+ * Author KangarooTwelve - Guido Bertoni, Joan Daemen, Michael Peeters, Gilles Van Assche,
+ * Ronny Van Keer and Benoit Viguier.
+ * ----------------------
+ * S = M || C || length_encode(|C|). If S is not longer than one chunk, the hash is
+ * TurboSHAKE128(S, 0x07). Otherwise S is split into the chunks S_0 ... S_n,
+ * CV_i = TurboSHAKE128(S_i, 0x0B, 32) are calculated in parallel and the hash is
+ * TurboSHAKE128(S_0 || 03 00 00 00 00 00 00 00 || CV_1 ... CV_n || length_encode(n) || FF FF, 0x06).
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "sha3.h"
+#include "k12.h"
+#include "pool.h"
+#include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
+
+// TurboSHAKE128 rate in bytes and the number of the rounds
+#define K12_RATE	168
+#define K12_ROUNDS	12
+
+// Word index in the state of the i-th 64-bit word of the block
+#define WORD(i)		(((i) % 5) * 5 + (i) / 5)
+
+/*
+ * Task of the thread: hash of the chunks
+ * data - first chunk
+ * n - number of the chunks
+ * cv - chaining values of the chunks
+*/
+struct k12_task {
+	const uint8_t *data;
+	int n;
+	uint8_t (*cv)[32];
+};
+
+// Absorb one block of the sponge
+static void
+k12_block(struct k12_sponge *s, const uint8_t block[K12_RATE])
+{
+	int i;
+
+	for(i = 0; i < K12_RATE / 8; i++)
+		s->state[WORD(i)] ^= U8TO64_LITTLE((block + i * 8));
+
+	keccak_permute(s->state, K12_ROUNDS);
+}
+
+// Absorb the message of the sponge
+static void
+k12_absorb(struct k12_sponge *s, const uint8_t *message, uint32_t msglen)
+{
+	uint32_t len;
+
+	// Fill the partial block
+	if(s->nbytes > 0) {
+		len = K12_RATE - s->nbytes;
+
+		if(msglen < len) {
+			memcpy(s->buffer + s->nbytes, message, msglen);
+			s->nbytes += msglen;
+			return;
+		}
+
+		memcpy(s->buffer + s->nbytes, message, len);
+		message += len;
+		msglen -= len;
+
+		k12_block(s, s->buffer);
+	}
+
+	// Full blocks directly from the message
+	while(msglen >= K12_RATE) {
+		k12_block(s, message);
+		message += K12_RATE;
+		msglen -= K12_RATE;
+	}
+
+	memcpy(s->buffer, message, msglen);
+	s->nbytes = msglen;
+}
+
+// Padding with the domain separation byte ds and squeeze outlen bytes of the sponge
+static void
+k12_squeeze(struct k12_sponge *s, uint8_t ds, uint8_t *out, uint32_t outlen)
+{
+	uint8_t block[K12_RATE];
+	uint32_t len;
+	int i;
+
+	memset(s->buffer + s->nbytes, 0, K12_RATE - s->nbytes);
+	s->buffer[s->nbytes] = ds;
+	s->buffer[K12_RATE-1] |= 0x80;
+
+	k12_block(s, s->buffer);
+
+	for(;;) {
+		for(i = 0; i < K12_RATE / 8; i++)
+			U64TO8_LITTLE((block + i * 8), s->state[WORD(i)]);
+
+		len = (outlen < K12_RATE) ? outlen : K12_RATE;
+		memcpy(out, block, len);
+		out += len;
+		outlen -= len;
+
+		if(outlen == 0)
+			break;
+
+		keccak_permute(s->state, K12_ROUNDS);
+	}
+}
+
+// length_encode(x): x in big-endian without leading zeros, then the number of the bytes
+static int
+k12_length_encode(uint8_t out[9], uint64_t x)
+{
+	int n, i;
+
+	for(n = 0; (n < 8) && (x >> (8 * n)); n++)
+		;
+
+	for(i = 0; i < n; i++)
+		out[i] = x >> (8 * (n - i - 1));
+
+	out[n] = n;
+
+	return n + 1;
+}
+
+// Chaining value of the one chunk: TurboSHAKE128(chunk, 0x0B, 32)
+static void
+k12_chunk(const uint8_t *chunk, uint32_t len, uint8_t cv[32])
+{
+	struct k12_sponge s;
+
+	memset(&s, 0, sizeof(s));
+	k12_absorb(&s, chunk, len);
+	k12_squeeze(&s, 0x0B, cv, 32);
+}
+
+// Thread task: chaining values of the full chunks
+static void
+k12_task(void *arg)
+{
+	struct k12_task *task = arg;
+	int i;
+
+	for(i = 0; i < task->n; i++)
+		k12_chunk(task->data + i * K12_CHUNK, K12_CHUNK, task->cv[i]);
+}
+
+// Hash n full chunks in parallel and absorb the chaining values of the final node
+static void
+k12_chunks(struct k12_context *ctx, const uint8_t *data, int n)
+{
+	struct k12_task task[n];
+	struct pool_group group;
+	int i, ntasks, per;
+
+	if(ctx->pool == NULL) {
+		task[0].data = data;
+		task[0].n = n;
+		task[0].cv = ctx->cv;
+		k12_task(&task[0]);
+	}
+	else {
+		ntasks = pool_threads(ctx->pool);
+		per = (n + ntasks - 1) / ntasks;
+
+		pool_group_init(&group);
+
+		for(i = ntasks = 0; i < n; i += per, ntasks++) {
+			task[ntasks].data = data + i * K12_CHUNK;
+			task[ntasks].n = (n - i < per) ? n - i : per;
+			task[ntasks].cv = ctx->cv + i;
+
+			// No memory for the task queue - hash in this thread
+			if(pool_submit_group(ctx->pool, &group, k12_task, &task[ntasks]))
+				k12_task(&task[ntasks]);
+		}
+
+		pool_wait_group(ctx->pool, &group);
+	}
+
+	k12_absorb(&ctx->node, (uint8_t *)ctx->cv, n * 32);
+	ctx->nchunks += n;
+}
+
+// KangarooTwelve initialization function of the given pool
+// own - the pool is destroyed by the final function
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+k12_init_context(struct k12_context *ctx, struct pool *pool, int own)
+{
+	int threads;
+
+	HASH_TRACE_ENTRY(init, HASH_TRACE_K12, (pool != NULL) ? pool_threads(pool) : 1, ctx);
+
+	memset(ctx, 0, sizeof(*ctx));
+
+	ctx->pool = pool;
+	ctx->own_pool = own;
+	threads = (pool != NULL) ? pool_threads(pool) : 1;
+
+	ctx->size = K12_CHUNK * K12_LEAVES * threads;
+	ctx->buffer = malloc(ctx->size);
+	ctx->cv = malloc(K12_LEAVES * threads * sizeof(*ctx->cv));
+
+	if((ctx->buffer == NULL) || (ctx->cv == NULL)) {
+		free(ctx->buffer);
+		free(ctx->cv);
+
+		if(own && (pool != NULL))
+			pool_destroy(pool);
+
+		HASH_TRACE_RETURN(init, HASH_TRACE_K12, ctx);
+		return -1;
+	}
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_K12, ctx);
+	return 0;
+}
+
+// KangarooTwelve initialization function
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+k12_init(struct k12_context *ctx, int nthreads)
+{
+	struct pool *pool = NULL;
+
+	if((nthreads != 1) && ((pool = pool_create(nthreads)) == NULL)) {
+		memset(ctx, 0, sizeof(*ctx));
+		return -1;
+	}
+
+	return k12_init_context(ctx, pool, 1);
+}
+
+// KangarooTwelve initialization function of the shared pool
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+k12_init_pool(struct k12_context *ctx, struct pool *pool)
+{
+	return k12_init_context(ctx, pool, 0);
+}
+
+// KangarooTwelve update function
+// msglen - the size in bytes of the message
+void
+k12_update(struct k12_context *ctx, const void *message, uint32_t msglen)
+{
+	const uint8_t padding[8] = { 0x03 };
+	uint32_t len;
+
+	HASH_TRACE_ENTRY(update, HASH_TRACE_K12, msglen, ctx);
+
+	if(msglen == 0) {
+		HASH_TRACE_RETURN(update, HASH_TRACE_K12, ctx);
+		return;
+	}
+
+	// The first chunk is kept until it is clear that S is longer than one chunk
+	if(!ctx->tree) {
+		len = K12_CHUNK - ctx->nbytes;
+		len = (msglen < len) ? msglen : len;
+
+		memcpy(ctx->buffer + ctx->nbytes, message, len);
+		ctx->nbytes += len;
+		message += len;
+		msglen -= len;
+
+		if(msglen == 0) {
+			HASH_TRACE_RETURN(update, HASH_TRACE_K12, ctx);
+			return;
+		}
+
+		k12_absorb(&ctx->node, ctx->buffer, K12_CHUNK);
+		k12_absorb(&ctx->node, padding, sizeof(padding));
+		ctx->nbytes = 0;
+		ctx->tree = 1;
+	}
+
+	while(msglen > 0) {
+
+		// Hash the full buffer of chunks directly from the message
+		if((ctx->nbytes == 0) && (msglen >= ctx->size)) {
+			k12_chunks(ctx, message, ctx->size / K12_CHUNK);
+			message += ctx->size;
+			msglen -= ctx->size;
+			continue;
+		}
+
+		len = ctx->size - ctx->nbytes;
+		len = (msglen < len) ? msglen : len;
+
+		memcpy(ctx->buffer + ctx->nbytes, message, len);
+		ctx->nbytes += len;
+		message += len;
+		msglen -= len;
+
+		if(ctx->nbytes == ctx->size) {
+			k12_chunks(ctx, ctx->buffer, ctx->size / K12_CHUNK);
+			ctx->nbytes = 0;
+		}
+	}
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_K12, ctx);
+}
+
+// KangarooTwelve final function with the customization string
+void
+k12_final_custom(struct k12_context *ctx, const void *custom, uint32_t customlen, uint8_t *digest, uint32_t outlen)
+{
+	const uint8_t end[2] = { 0xFF, 0xFF };
+	uint8_t encode[9];
+	uint32_t n;
+
+	HASH_TRACE_ENTRY(final, HASH_TRACE_K12, outlen, ctx);
+
+	k12_update(ctx, custom, customlen);
+	k12_update(ctx, encode, k12_length_encode(encode, customlen));
+
+	if(!ctx->tree) {
+		k12_absorb(&ctx->node, ctx->buffer, ctx->nbytes);
+		k12_squeeze(&ctx->node, 0x07, digest, outlen);
+	}
+	else {
+		// Full chunks of the buffer, then the last (partial) chunk
+		n = ctx->nbytes / K12_CHUNK;
+
+		if(n > 0)
+			k12_chunks(ctx, ctx->buffer, n);
+
+		if(ctx->nbytes % K12_CHUNK) {
+			k12_chunk(ctx->buffer + n * K12_CHUNK, ctx->nbytes % K12_CHUNK, ctx->cv[0]);
+			k12_absorb(&ctx->node, ctx->cv[0], 32);
+			ctx->nchunks++;
+		}
+
+		k12_absorb(&ctx->node, encode, k12_length_encode(encode, ctx->nchunks));
+		k12_absorb(&ctx->node, end, sizeof(end));
+		k12_squeeze(&ctx->node, 0x06, digest, outlen);
+	}
+
+	if(ctx->own_pool && (ctx->pool != NULL))
+		pool_destroy(ctx->pool);
+
+	free(ctx->buffer);
+	free(ctx->cv);
+	memset(ctx, 0, sizeof(*ctx));
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_K12, ctx);
+}
+
+// KangarooTwelve final function: empty customization string, 256 bits hash
+void
+k12_final(struct k12_context *ctx, uint8_t digest[32])
+{
+	k12_final_custom(ctx, NULL, 0, digest, 32);
+}
+
+// Export the state of the incomplete message
+void
+k12_export_state(struct k12_context *ctx, uint8_t state[K12_STATE_SIZE])
+{
+	uint8_t *p = state;
+	uint32_t n;
+
+	// Only the last partial chunk is left in the buffer
+	if(ctx->tree && ((n = ctx->nbytes / K12_CHUNK) > 0)) {
+		k12_chunks(ctx, ctx->buffer, n);
+		ctx->nbytes -= n * K12_CHUNK;
+		memmove(ctx->buffer, ctx->buffer + n * K12_CHUNK, ctx->nbytes);
+	}
+
+	HASH_STATE_PUT_HEADER(p, "K12 ");
+	HASH_STATE_PUT64(p, ctx->node.state, 25);
+	HASH_STATE_PUT_BYTES(p, ctx->node.buffer, K12_RATE);
+	U32TO8_LITTLE(p, ctx->node.nbytes);
+	U64TO8_LITTLE((p + 4), ctx->nchunks);
+	U32TO8_LITTLE((p + 12), ctx->tree);
+	U32TO8_LITTLE((p + 16), ctx->nbytes);
+	p += 20;
+
+	memcpy(p, ctx->buffer, ctx->nbytes);
+	memset(p + ctx->nbytes, 0, K12_CHUNK - ctx->nbytes);
+}
+
+// Import the state exported by k12_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+k12_import_state(struct k12_context *ctx, const uint8_t state[K12_STATE_SIZE])
+{
+	const uint8_t *p = state;
+	uint32_t node_nbytes, tree, nbytes;
+	uint64_t nchunks;
+
+	if((ctx->buffer == NULL) || !HASH_STATE_CHECK_HEADER(p, "K12 "))
+		return -1;
+
+	p += HASH_STATE_HEADER + 200 + K12_RATE;
+
+	node_nbytes = U8TO32_LITTLE(p);
+	nchunks = U8TO64_LITTLE((p + 4));
+	tree = U8TO32_LITTLE((p + 12));
+	nbytes = U8TO32_LITTLE((p + 16));
+
+	// The first chunk is whole in the buffer, after it - only the partial chunk
+	if((node_nbytes >= K12_RATE) || (tree > 1) || (nbytes > K12_CHUNK) ||
+	   (tree && (nbytes == K12_CHUNK)) || (!tree && (nchunks > 0)))
+		return -1;
+
+	p = state + HASH_STATE_HEADER;
+
+	HASH_STATE_GET64(p, ctx->node.state, 25);
+	HASH_STATE_GET_BYTES(p, ctx->node.buffer, K12_RATE);
+	p += 20;
+
+	ctx->node.nbytes = node_nbytes;
+	ctx->nchunks = nchunks;
+	ctx->tree = tree;
+	ctx->nbytes = nbytes;
+	memcpy(ctx->buffer, p, nbytes);
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * KangarooTwelve - tree hash function on top of the Keccak-p[1600, 12] permutation, 2016 year.
+ * Author KangarooTwelve - Guido Bertoni, Joan Daemen, Michael Peeters, Gilles Van Assche,
+ * Ronny Van Keer and Benoit Viguier.
+ * The message is split into 8192-byte chunks, hashed in parallel by the thread pool.
+ * The hash does not depend on the number of the threads.
+ * Hash size - any, 256 bits by default.
+*/
+
+#ifndef K12_H
+#define K12_H
+
+// Size in bytes of the chunk (leaf of the tree)
+#define K12_CHUNK	8192
+
+// Number of the chunks hashed by one thread at one time
+#define K12_LEAVES	8
+
+// Size in bytes of the exported state: sponge of the final node and the last (partial) chunk
+#define K12_STATE_SIZE	(8 + 200 + 168 + 20 + K12_CHUNK)
+
+/*
+ * KangarooTwelve sponge (TurboSHAKE128)
+ * state - 1600 bits state
+ * buffer - 1344 bits input message
+ * nbytes - number of bytes in the buffer
+*/
+struct k12_sponge {
+	uint64_t state[25];
+	uint8_t buffer[168];
+	int nbytes;
+};
+
+struct pool;
+
+/*
+ * KangarooTwelve algorithm context
+ * node - sponge of the final node
+ * buffer - first chunk of the message, then the chunks waiting to be hashed
+ * nbytes - number of bytes in the buffer
+ * size - size of the buffer (K12_CHUNK * K12_LEAVES * number of the threads)
+ * nchunks - number of the hashed chunks (without the first chunk)
+ * tree - the message is longer than one chunk, the first chunk is in the final node
+ * pool - thread pool, NULL if one thread
+ * own_pool - the pool is created by k12_init and destroyed by the final function
+ * cv - chaining values of the chunks of the buffer
+*/
+struct k12_context {
+	struct k12_sponge node;
+	uint8_t *buffer;
+	uint32_t nbytes;
+	uint32_t size;
+	uint64_t nchunks;
+	int tree;
+	struct pool *pool;
+	int own_pool;
+	uint8_t (*cv)[32];
+};
+
+// KangarooTwelve initialization function
+// nthreads - number of the threads, 0 - number of the processors
+// Return value: 0 (if all is well), -1 (if all bad)
+int k12_init(struct k12_context *ctx, int nthreads);
+
+// KangarooTwelve initialization function, the chunks are hashed by the shared pool
+// The pool is not destroyed by the final function
+// Return value: 0 (if all is well), -1 (if all bad)
+int k12_init_pool(struct k12_context *ctx, struct pool *pool);
+
+// KangarooTwelve update function
+// msglen - the size in bytes of the message
+void k12_update(struct k12_context *ctx, const void *message, uint32_t msglen);
+
+// KangarooTwelve final function with the customization string
+// custom - customization string, customlen - the size in bytes of the string
+// digest - the pointer of the hash, outlen - the size in bytes of the hash
+// Frees the memory and threads of the context
+void k12_final_custom(struct k12_context *ctx, const void *custom, uint32_t customlen, uint8_t *digest, uint32_t outlen);
+
+// KangarooTwelve final function: empty customization string, 256 bits hash
+void k12_final(struct k12_context *ctx, uint8_t digest[32]);
+
+// Export the state of the incomplete message
+// The full chunks waiting in the buffer are hashed first, the hash is not changed
+void k12_export_state(struct k12_context *ctx, uint8_t state[K12_STATE_SIZE]);
+
+// Import the state exported by k12_export_state to the context initialized by k12_init (k12_init_pool)
+// Return value: 0 (if all is well), -1 (if the state is not KangarooTwelve, the version is unknown or the state is damaged)
+int k12_import_state(struct k12_context *ctx, const uint8_t state[K12_STATE_SIZE]);
+
+#endif /* K12_H */
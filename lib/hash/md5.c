@@ -12,6 +12,8 @@
 
 #include "md5.h"
 #include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
 
 // Functions for the 4 rounds
 #define F(x, y, z)	((x & y) | ((~x) & z))
@@ -40,12 +42,16 @@ static const unsigned char md5pad[64] = { 0x80 };
 void
 md5_init(struct md5_context *ctx)
 {
+	HASH_TRACE_ENTRY(init, HASH_TRACE_MD5, 16, ctx);
+
 	memset(ctx, 0, sizeof(*ctx));
 
 	ctx->state[0] = 0x67452301UL;
 	ctx->state[1] = 0xEFCDAB89UL;
 	ctx->state[2] = 0x98BADCFEUL;
 	ctx->state[3] = 0x10325476UL;
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_MD5, ctx);
 }
 
 // 32-byte array is transformed into 8-byte array
@@ -63,6 +69,7 @@ uint32_to_bytes(uint8_t *out, const uint32_t *in, const int n)
 }
 
 // MD5 algorithm
+ESTREAM_CLONES
 static void
 md5_hash(uint32_t state[4], const uint8_t block[64])
 {
@@ -164,6 +171,8 @@ md5_update(struct md5_context *ctx, const void *message, uint32_t msglen)
 {
 	int n, len;
 
+	HASH_TRACE_ENTRY(update, HASH_TRACE_MD5, msglen, ctx);
+
 	n = (ctx->nbits[0] >> 3) & 0x3F;
 
 	len = 64 - n;
@@ -176,27 +185,31 @@ md5_update(struct md5_context *ctx, const void *message, uint32_t msglen)
 		++ctx->nbits[1];
 	ctx->nbits[1] += msglen >> 29;
 
-	if(msglen >= len) {
-		
-		// Calculate hash
+	// Fill and hash the partial block left by the previous call
+	if((n > 0) && (msglen >= len)) {
 		memcpy(ctx->buffer + n, message, len);
 		message += len;
 		msglen -= len;
 
 		md5_hash(ctx->state, ctx->buffer);
 
-		// Calculate hash of the remaining messages
+		n = 0;
+	}
+
+	// Calculate hash of the full blocks directly from the message
+	if(n == 0) {
 		while(msglen >= 64) {
 			md5_hash(ctx->state, message);
 			message += 64;
 			msglen -= 64;
 		}
-
-		n = 0;
 	}
 
 	// Save message remaining bytes of the buffer
-	memcpy(ctx->buffer + n, message, msglen);
+	if(msglen > 0)
+		memcpy(ctx->buffer + n, message, msglen);
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_MD5, ctx);
 }
 
 // Get the MD5 hash of the message
@@ -207,6 +220,8 @@ md5_final(struct md5_context *ctx, uint8_t digest[16])
 	uint8_t nbits[8];
 	int n, npad;
 
+	HASH_TRACE_ENTRY(final, HASH_TRACE_MD5, 16, ctx);
+
 	n = (ctx->nbits[0] >> 3) & 0x3F;
 	npad = ((n < 56) ? 56 : 120) - n;
 
@@ -216,5 +231,37 @@ md5_final(struct md5_context *ctx, uint8_t digest[16])
 	md5_update(ctx, nbits, 8);
 
 	uint32_to_bytes(digest, ctx->state, 4);
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_MD5, ctx);
 }
 
+// Export the state of the incomplete message
+void
+md5_export_state(const struct md5_context *ctx, uint8_t state[MD5_STATE_SIZE])
+{
+	uint8_t *p = state;
+
+	HASH_STATE_PUT_HEADER(p, "MD5 ");
+	HASH_STATE_PUT32(p, ctx->nbits, 2);
+	HASH_STATE_PUT32(p, ctx->state, 4);
+	HASH_STATE_PUT_BYTES(p, ctx->buffer, 64);
+}
+
+// Import the state exported by md5_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+md5_import_state(struct md5_context *ctx, const uint8_t state[MD5_STATE_SIZE])
+{
+	const uint8_t *p = state;
+
+	if(!HASH_STATE_CHECK_HEADER(p, "MD5 "))
+		return -1;
+
+	p += HASH_STATE_HEADER;
+
+	HASH_STATE_GET32(p, ctx->nbits, 2);
+	HASH_STATE_GET32(p, ctx->state, 4);
+	HASH_STATE_GET_BYTES(p, ctx->buffer, 64);
+
+	return 0;
+}
@@ -7,6 +7,9 @@
 #ifndef MD5_H
 #define MD5_H
 
+// Size in bytes of the exported state
+#define MD5_STATE_SIZE	96
+
 /*
  * MD5 algorithm context
  * nbits - number bit of the message
@@ -26,4 +29,11 @@ void md5_update(struct md5_context *ctx, const void *message, uint32_t msglen);
 
 void md5_final(struct md5_context *ctx, uint8_t digest[16]);
 
+// Export the state of the incomplete message (the context is not changed)
+void md5_export_state(const struct md5_context *ctx, uint8_t state[MD5_STATE_SIZE]);
+
+// Import the state exported by md5_export_state, then the message may be continued
+// Return value: 0 (if all is well), -1 (if the state is not MD5 or the version is unknown)
+int md5_import_state(struct md5_context *ctx, const uint8_t state[MD5_STATE_SIZE]);
+
 #endif /* MD5_H */
@@ -0,0 +1,349 @@
+/*
+ * This program implements the PBKDF2 key derivation function RFC 8018 with HMAC-SHA256 and HMAC-SHA512.
+ * T_i = U_1 XOR U_2 XOR ... XOR U_c, U_1 = HMAC(P, S || INT(i)), U_j = HMAC(P, U_(j-1)).
+ * ----------------------
+ * Every iteration is two compressions from the HMAC midstates of the password with the constant padding.
+ * The output blocks T_i of all passwords are independent jobs: they are iterated together,
+ * one job per SIMD lane (SHA256: 4/8/16 lanes, SHA512: 2/4/8 lanes).
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "pbkdf2.h"
+#include "../macro.h"
+
+// Maximum number of the lanes
+#define PBKDF2_MAX_LANES	16
+
+// SHA256 64 constant
+static const uint32_t K256[64] CACHE_ALIGNED = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+	0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+	0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+	0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+	0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+	0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+	0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+	0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+	0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2 };
+
+// SHA512 80 constant
+static const uint64_t K512[80] CACHE_ALIGNED = {
+	0x428A2F98D728AE22, 0x7137449123EF65CD, 0xB5C0FBCFEC4D3B2F, 0xE9B5DBA58189DBBC,
+	0x3956C25BF348B538, 0x59F111F1B605D019, 0x923F82A4AF194F9B, 0xAB1C5ED5DA6D8118,
+	0xD807AA98A3030242, 0x12835B0145706FBE, 0x243185BE4EE4B28C, 0x550C7DC3D5FFB4E2,
+	0x72BE5D74F27B896F, 0x80DEB1FE3B1696B1, 0x9BDC06A725C71235, 0xC19BF174CF692694,
+	0xE49B69C19EF14AD2, 0xEFBE4786384F25E3, 0x0FC19DC68B8CD5B5, 0x240CA1CC77AC9C65,
+	0x2DE92C6F592B0275, 0x4A7484AA6EA6E483, 0x5CB0A9DCBD41FBD4, 0x76F988DA831153B5,
+	0x983E5152EE66DFAB, 0xA831C66D2DB43210, 0xB00327C898FB213F, 0xBF597FC7BEEF0EE4,
+	0xC6E00BF33dA88FC2, 0xD5A79147930AA725, 0x06CA6351E003826F, 0x142929670A0E6E70,
+	0x27B70A8546D22FFC, 0x2E1B21385C26C926, 0x4D2C6DFC5AC42AED, 0x53380d139D95B3DF,
+	0x650A73548BAF63DE, 0x766A0ABB3C77B2A8, 0x81C2C92E47EDAEE6, 0x92722C851482353B,
+	0xA2BFE8A14CF10364, 0xA81A664BBC423001, 0xC24B8B70D0F89791, 0xC76C51A30654BE30,
+	0xD192E819D6EF5218, 0xD69906245565A910, 0xF40E35855771202A, 0x106AA07032BBD1B8,
+	0x19A4C116B8D2D0C8, 0x1E376C085141AB53, 0x2748774CDF8EEB99, 0x34B0BCB5E19B48A8,
+	0x391C0CB3C5C95A63, 0x4ED8AA4AE3418ACB, 0x5B9CCA4F7763E373, 0x682E6FF3D6B2B8A3,
+	0x748F82EE5DEFB2FC, 0x78A5636F43172F60, 0x84C87814A1F0AB72, 0x8CC702081A6439EC,
+	0x90BEFFFA23631E28, 0xA4506CEBDE82BDE9, 0xBEF9A3F7B2C67915, 0xC67178F2E372532B,
+	0xCA273ECEEA26619C, 0xD186B8C721C0C207, 0xEADA7DD6CDE0EB1E, 0xF57D4F7FEE6ED178,
+	0x06F067AA72176FBA, 0x0A637DC5A2C898A6, 0x113F9804BEF90DAE, 0x1B710B35131C471B,
+	0x28DB77F523047D84, 0x32CAAB7B40C72493, 0x3C9EBE0A15C9BEBC, 0x431D67C49C100D4C,
+	0x4CC5D4BECB3E42B6, 0x597F299CFC657E2A, 0x5FCB6FAB3AD6FAEC, 0x6C44198C4A475817 };
+
+// One lane, no SIMD
+#define PBKDF2_SHA	256
+#define PBKDF2_VEC	uint32_t
+#define PBKDF2_LANES	1
+#define PBKDF2_ITERATE	pbkdf2_sha256_x1
+#include "pbkdf2_kernel.h"
+#undef PBKDF2_SHA
+#undef PBKDF2_VEC
+#undef PBKDF2_LANES
+#undef PBKDF2_ITERATE
+
+#define PBKDF2_SHA	512
+#define PBKDF2_VEC	uint64_t
+#define PBKDF2_LANES	1
+#define PBKDF2_ITERATE	pbkdf2_sha512_x1
+#include "pbkdf2_kernel.h"
+#undef PBKDF2_SHA
+#undef PBKDF2_VEC
+#undef PBKDF2_LANES
+#undef PBKDF2_ITERATE
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PBKDF2_SIMD
+
+// SHA256 4 lanes and SHA512 2 lanes, SSE2
+#pragma GCC push_options
+#pragma GCC target("sse2")
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+typedef uint64_t v2u64 __attribute__((vector_size(16)));
+#define PBKDF2_SHA	256
+#define PBKDF2_VEC	v4u32
+#define PBKDF2_LANES	4
+#define PBKDF2_ITERATE	pbkdf2_sha256_x4
+#include "pbkdf2_kernel.h"
+#undef PBKDF2_SHA
+#undef PBKDF2_VEC
+#undef PBKDF2_LANES
+#undef PBKDF2_ITERATE
+#define PBKDF2_SHA	512
+#define PBKDF2_VEC	v2u64
+#define PBKDF2_LANES	2
+#define PBKDF2_ITERATE	pbkdf2_sha512_x2
+#include "pbkdf2_kernel.h"
+#undef PBKDF2_SHA
+#undef PBKDF2_VEC
+#undef PBKDF2_LANES
+#undef PBKDF2_ITERATE
+#pragma GCC pop_options
+
+// SHA256 8 lanes and SHA512 4 lanes, AVX2
+#pragma GCC push_options
+#pragma GCC target("avx2")
+typedef uint32_t v8u32 __attribute__((vector_size(32)));
+typedef uint64_t v4u64 __attribute__((vector_size(32)));
+#define PBKDF2_SHA	256
+#define PBKDF2_VEC	v8u32
+#define PBKDF2_LANES	8
+#define PBKDF2_ITERATE	pbkdf2_sha256_x8
+#include "pbkdf2_kernel.h"
+#undef PBKDF2_SHA
+#undef PBKDF2_VEC
+#undef PBKDF2_LANES
+#undef PBKDF2_ITERATE
+#define PBKDF2_SHA	512
+#define PBKDF2_VEC	v4u64
+#define PBKDF2_LANES	4
+#define PBKDF2_ITERATE	pbkdf2_sha512_x4
+#include "pbkdf2_kernel.h"
+#undef PBKDF2_SHA
+#undef PBKDF2_VEC
+#undef PBKDF2_LANES
+#undef PBKDF2_ITERATE
+#pragma GCC pop_options
+
+// SHA256 16 lanes and SHA512 8 lanes, AVX-512
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+typedef uint32_t v16u32 __attribute__((vector_size(64)));
+typedef uint64_t v8u64 __attribute__((vector_size(64)));
+#define PBKDF2_SHA	256
+#define PBKDF2_VEC	v16u32
+#define PBKDF2_LANES	16
+#define PBKDF2_ITERATE	pbkdf2_sha256_x16
+#include "pbkdf2_kernel.h"
+#undef PBKDF2_SHA
+#undef PBKDF2_VEC
+#undef PBKDF2_LANES
+#undef PBKDF2_ITERATE
+#define PBKDF2_SHA	512
+#define PBKDF2_VEC	v8u64
+#define PBKDF2_LANES	8
+#define PBKDF2_ITERATE	pbkdf2_sha512_x8
+#include "pbkdf2_kernel.h"
+#undef PBKDF2_SHA
+#undef PBKDF2_VEC
+#undef PBKDF2_LANES
+#undef PBKDF2_ITERATE
+#pragma GCC pop_options
+
+#endif /* PBKDF2_SIMD */
+
+/*
+ * Words of the all lanes
+ * w32 - SHA256 words, w64 - SHA512 words
+*/
+union pbkdf2_words {
+	uint32_t w32[8 * PBKDF2_MAX_LANES];
+	uint64_t w64[8 * PBKDF2_MAX_LANES];
+};
+
+// Number of the lanes used on this processor
+int
+pbkdf2_lanes(int alg)
+{
+#ifdef PBKDF2_SIMD
+	if(__builtin_cpu_supports("avx512f"))
+		return (alg == PBKDF2_SHA256) ? 16 : 8;
+
+	if(__builtin_cpu_supports("avx2"))
+		return (alg == PBKDF2_SHA256) ? 8 : 4;
+
+	if(__builtin_cpu_supports("sse2"))
+		return (alg == PBKDF2_SHA256) ? 4 : 2;
+#endif
+	return 1;
+}
+
+// Next narrower kernel
+static int
+pbkdf2_narrow(int alg, int lanes)
+{
+	if((alg == PBKDF2_SHA256) && (lanes == 4))
+		return 1;
+
+	return lanes / 2;
+}
+
+// c iterations of the all lanes: x[0] - inner, x[1] - outer, x[2] - U_1, x[3] - T
+static void
+pbkdf2_iterate(int alg, int lanes, union pbkdf2_words x[4], uint32_t c)
+{
+	if(alg == PBKDF2_SHA256) {
+		switch(lanes) {
+#ifdef PBKDF2_SIMD
+		case 16 : pbkdf2_sha256_x16(x[0].w32, x[1].w32, x[2].w32, x[3].w32, c);
+			  return;
+		case 8 : pbkdf2_sha256_x8(x[0].w32, x[1].w32, x[2].w32, x[3].w32, c);
+			 return;
+		case 4 : pbkdf2_sha256_x4(x[0].w32, x[1].w32, x[2].w32, x[3].w32, c);
+			 return;
+#endif
+		default : pbkdf2_sha256_x1(x[0].w32, x[1].w32, x[2].w32, x[3].w32, c);
+			  return;
+		}
+	}
+
+	switch(lanes) {
+#ifdef PBKDF2_SIMD
+	case 8 : pbkdf2_sha512_x8(x[0].w64, x[1].w64, x[2].w64, x[3].w64, c);
+		 return;
+	case 4 : pbkdf2_sha512_x4(x[0].w64, x[1].w64, x[2].w64, x[3].w64, c);
+		 return;
+	case 2 : pbkdf2_sha512_x2(x[0].w64, x[1].w64, x[2].w64, x[3].w64, c);
+		 return;
+#endif
+	default : pbkdf2_sha512_x1(x[0].w64, x[1].w64, x[2].w64, x[3].w64, c);
+		  return;
+	}
+}
+
+// Load the job to the lane l: midstates of the key and U_1
+static void
+pbkdf2_load(int alg, union pbkdf2_words x[4], int lanes, int l, const struct hmac_key *key, const uint8_t *u)
+{
+	int i;
+
+	for(i = 0; i < 8; i++) {
+		if(alg == PBKDF2_SHA256) {
+			x[0].w32[i * lanes + l] = key->inner.sha256.state[i];
+			x[1].w32[i * lanes + l] = key->outer.sha256.state[i];
+			x[2].w32[i * lanes + l] = U8TO32_BIG((u + i * 4));
+		}
+		else {
+			x[0].w64[i * lanes + l] = key->inner.sha512.state[i];
+			x[1].w64[i * lanes + l] = key->outer.sha512.state[i];
+			x[2].w64[i * lanes + l] = U8TO64_BIG((u + i * 8));
+		}
+	}
+}
+
+// Store T of the lane l
+static void
+pbkdf2_store(int alg, union pbkdf2_words x[4], int lanes, int l, uint8_t *t)
+{
+	int i;
+
+	for(i = 0; i < 8; i++) {
+		if(alg == PBKDF2_SHA256) {
+			U32TO8_BIG((t + i * 4), x[3].w32[i * lanes + l]);
+		}
+		else {
+			U64TO8_BIG((t + i * 8), x[3].w64[i * lanes + l]);
+		}
+	}
+}
+
+// Key derivation of the n passwords with the same salt
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+pbkdf2_many(int alg, int n, const uint8_t *password[], const uint32_t passlen[], const uint8_t *salt,
+	    uint32_t saltlen, uint32_t iterations, uint8_t *out[], uint32_t outlen)
+{
+	union pbkdf2_words x[4] __attribute__((aligned(64)));
+	struct hmac_key key;
+	struct hmac_context ctx;
+	uint8_t u[HMAC_MAX_SIZE], count[4];
+	uint8_t *dst[PBKDF2_MAX_LANES];
+	uint32_t len[PBKDF2_MAX_LANES];
+	int size, blocks, jobs, job, lanes, used, current, p, b, l;
+
+	if(((alg != PBKDF2_SHA256) && (alg != PBKDF2_SHA512)) || (iterations == 0))
+		return -1;
+
+	size = hmac_size(alg);
+	blocks = (outlen + size - 1) / size;
+	jobs = n * blocks;
+
+	// Narrower kernel if the wide one has free lanes
+	lanes = pbkdf2_lanes(alg);
+
+	while((lanes > 1) && (pbkdf2_narrow(alg, lanes) >= jobs))
+		lanes = pbkdf2_narrow(alg, lanes);
+
+	current = -1;
+
+	for(job = 0; job < jobs; job += lanes) {
+		used = (jobs - job < lanes) ? jobs - job : lanes;
+
+		for(l = 0; l < used; l++) {
+			p = (job + l) / blocks;
+			b = (job + l) % blocks;
+
+			if(p != current) {
+				hmac_set_key(&key, alg, password[p], passlen[p]);
+				current = p;
+			}
+
+			// U_1 = HMAC(P, S || INT(i))
+			U32TO8_BIG(count, (uint32_t)(b + 1));
+
+			hmac_init(&ctx, &key);
+			hmac_update(&ctx, salt, saltlen);
+			hmac_update(&ctx, count, 4);
+			hmac_final(&ctx, u);
+
+			pbkdf2_load(alg, x, lanes, l, &key, u);
+
+			dst[l] = out[p] + b * size;
+			len[l] = (outlen - b * size < size) ? outlen - b * size : size;
+		}
+
+		// Free lanes repeat the last job
+		for(; l < lanes; l++)
+			pbkdf2_load(alg, x, lanes, l, &key, u);
+
+		pbkdf2_iterate(alg, lanes, x, iterations - 1);
+
+		for(l = 0; l < used; l++) {
+			pbkdf2_store(alg, x, lanes, l, u);
+			memcpy(dst[l], u, len[l]);
+		}
+	}
+
+	memset(x, 0, sizeof(x));
+	memset(u, 0, sizeof(u));
+	memset(&key, 0, sizeof(key));
+
+	return 0;
+}
+
+// Key derivation: outlen bytes of the key
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+pbkdf2(int alg, const uint8_t *password, uint32_t passlen, const uint8_t *salt, uint32_t saltlen,
+       uint32_t iterations, uint8_t *out, uint32_t outlen)
+{
+	return pbkdf2_many(alg, 1, &password, &passlen, salt, saltlen, iterations, &out, outlen);
+}
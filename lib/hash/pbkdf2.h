@@ -0,0 +1,29 @@
+/*
+ * PBKDF2 - password-based key derivation function 2 (RFC 8018) with HMAC-SHA256 and HMAC-SHA512.
+ * The iterations of the several output blocks and of the several passwords
+ * are calculated together in the parallel SIMD lanes (SSE2, AVX2, AVX-512).
+*/
+
+#ifndef PBKDF2_H
+#define PBKDF2_H
+
+#include "hmac.h"
+
+// Hash functions of the PBKDF2
+#define PBKDF2_SHA256	HMAC_SHA256
+#define PBKDF2_SHA512	HMAC_SHA512
+
+// Number of the lanes used on this processor
+int pbkdf2_lanes(int alg);
+
+// Key derivation: outlen bytes of the key from the password and the salt
+// Return value: 0 (if all is well), -1 (if all bad)
+int pbkdf2(int alg, const uint8_t *password, uint32_t passlen, const uint8_t *salt, uint32_t saltlen,
+	   uint32_t iterations, uint8_t *out, uint32_t outlen);
+
+// Key derivation of the n passwords with the same salt, out[i] - outlen bytes of the i-th key
+// Return value: 0 (if all is well), -1 (if all bad)
+int pbkdf2_many(int alg, int n, const uint8_t *password[], const uint32_t passlen[], const uint8_t *salt,
+		uint32_t saltlen, uint32_t iterations, uint8_t *out[], uint32_t outlen);
+
+#endif /* PBKDF2_H */
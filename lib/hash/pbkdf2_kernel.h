@@ -0,0 +1,140 @@
+/*
+ * PBKDF2 iteration kernel of the parallel lanes.
+ * The file is included by pbkdf2.c once per hash and vector width, before including define:
+ * PBKDF2_SHA - 256 (HMAC-SHA256) or 512 (HMAC-SHA512)
+ * PBKDF2_VEC - vector type of the lanes (the word type for one lane)
+ * PBKDF2_LANES - number of the lanes in PBKDF2_VEC
+ * PBKDF2_ITERATE - name of the kernel function
+ * Layout: word i of lane l in x[i * PBKDF2_LANES + l].
+*/
+
+#if PBKDF2_SHA == 256
+#define WORD		uint32_t
+#define WBITS		32
+#define ROUNDS		64
+#define KTAB		K256
+#define PADLEN		((64 + 32) * 8)
+#define VSIGMA0(x)	(VROTR(x, 2) ^ VROTR(x, 13) ^ VROTR(x, 22))
+#define VSIGMA1(x)	(VROTR(x, 6) ^ VROTR(x, 11) ^ VROTR(x, 25))
+#define VDELTA0(x)	(VROTR(x, 7) ^ VROTR(x, 18) ^ ((x) >> 3))
+#define VDELTA1(x)	(VROTR(x, 17) ^ VROTR(x, 19) ^ ((x) >> 10))
+#else
+#define WORD		uint64_t
+#define WBITS		64
+#define ROUNDS		80
+#define KTAB		K512
+#define PADLEN		((128 + 64) * 8)
+#define VSIGMA0(x)	(VROTR(x, 28) ^ VROTR(x, 34) ^ VROTR(x, 39))
+#define VSIGMA1(x)	(VROTR(x, 14) ^ VROTR(x, 18) ^ VROTR(x, 41))
+#define VDELTA0(x)	(VROTR(x, 1) ^ VROTR(x, 8) ^ ((x) >> 7))
+#define VDELTA1(x)	(VROTR(x, 19) ^ VROTR(x, 61) ^ ((x) >> 6))
+#endif
+
+// Cyclic right shift of the all lanes
+#define VROTR(v, n)	(((v) >> (n)) | ((v) << (WBITS - (n))))
+
+// Word x in the all lanes
+#define VSET(x)		((PBKDF2_VEC){ 0 } + (x))
+
+/*
+ * ROUND - one round of the SHA2 compression
+ * The next word of the message schedule is calculated in place: w[r & 15]
+*/
+#define ROUND(a, b, c, d, e, f, g, h, r) {						\
+	if((r) >= 16)									\
+		w[(r) & 15] += VDELTA1(w[((r) - 2) & 15]) + w[((r) - 7) & 15] +	\
+			       VDELTA0(w[((r) - 15) & 15]);				\
+	t = h + VSIGMA1(e) + ((e & f) ^ (~e & g)) + KTAB[r] + w[(r) & 15];		\
+	d += t;										\
+	h = t + VSIGMA0(a) + ((a & b) ^ (a & c) ^ (b & c));				\
+}
+
+/*
+ * inner, outer - HMAC midstates of the lanes
+ * u - U_1 of the lanes
+ * sum - T = U_1 XOR U_2 XOR ... XOR U_(iterations + 1) of the lanes
+*/
+static void
+PBKDF2_ITERATE(const WORD *inner, const WORD *outer, const WORD *u, WORD *sum, uint32_t iterations)
+{
+	PBKDF2_VEC in[8], out[8], U[8], T[8], w[16], a, b, c, d, e, f, g, h, t;
+	uint32_t n;
+	int i, k, r;
+
+	for(i = 0; i < 8; i++) {
+		memcpy(&in[i], inner + i * PBKDF2_LANES, sizeof(PBKDF2_VEC));
+		memcpy(&out[i], outer + i * PBKDF2_LANES, sizeof(PBKDF2_VEC));
+		memcpy(&U[i], u + i * PBKDF2_LANES, sizeof(PBKDF2_VEC));
+		T[i] = U[i];
+	}
+
+	for(n = 0; n < iterations; n++) {
+
+		// k = 0: inner hash of U, k = 1: outer hash of the inner hash
+		for(k = 0; k < 2; k++) {
+			for(i = 0; i < 8; i++)
+				w[i] = U[i];
+
+			// The message is always one hash: the padding is constant
+			w[8] = VSET((WORD)0x80 << (WBITS - 8));
+
+			for(i = 9; i < 15; i++)
+				w[i] = VSET(0);
+
+			w[15] = VSET(PADLEN);
+
+			if(k == 0)
+				memcpy(U, in, sizeof(U));
+			else
+				memcpy(U, out, sizeof(U));
+
+			a = U[0];
+			b = U[1];
+			c = U[2];
+			d = U[3];
+			e = U[4];
+			f = U[5];
+			g = U[6];
+			h = U[7];
+
+			for(r = 0; r < ROUNDS; r += 8) {
+				ROUND(a, b, c, d, e, f, g, h, r);
+				ROUND(h, a, b, c, d, e, f, g, r + 1);
+				ROUND(g, h, a, b, c, d, e, f, r + 2);
+				ROUND(f, g, h, a, b, c, d, e, r + 3);
+				ROUND(e, f, g, h, a, b, c, d, r + 4);
+				ROUND(d, e, f, g, h, a, b, c, r + 5);
+				ROUND(c, d, e, f, g, h, a, b, r + 6);
+				ROUND(b, c, d, e, f, g, h, a, r + 7);
+			}
+
+			U[0] += a;
+			U[1] += b;
+			U[2] += c;
+			U[3] += d;
+			U[4] += e;
+			U[5] += f;
+			U[6] += g;
+			U[7] += h;
+		}
+
+		for(i = 0; i < 8; i++)
+			T[i] ^= U[i];
+	}
+
+	for(i = 0; i < 8; i++)
+		memcpy(sum + i * PBKDF2_LANES, &T[i], sizeof(PBKDF2_VEC));
+}
+
+#undef WORD
+#undef WBITS
+#undef ROUNDS
+#undef KTAB
+#undef PADLEN
+#undef VSIGMA0
+#undef VSIGMA1
+#undef VDELTA0
+#undef VDELTA1
+#undef VROTR
+#undef VSET
+#undef ROUND
@@ -0,0 +1,452 @@
+/*
+ * This program implements the work-stealing thread pool for the parallel hash modes.
+ * Every worker has its own deque of the tasks: the worker takes the last task of its deque,
+ * the idle worker steals the first task of the other deques.
+ * Tasks submitted by the worker go to its deque, other tasks - to the deques in turn.
+ * The thread waiting for the group of the tasks executes the tasks too,
+ * so the task may submit the subtasks and wait for them.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+// Initial size of the task deque
+#define POOL_QUEUE	64
+
+// Task of the pool
+struct pool_task {
+	pool_task_t func;
+	void *arg;
+	struct pool_group *group;
+};
+
+/*
+ * Deque of the tasks of the one worker
+ * lock - mutex of the deque
+ * tasks - circular array of the tasks
+ * size - size of the array
+ * head - index of the first task
+ * count - number of the tasks
+*/
+struct pool_deque {
+	pthread_mutex_t lock;
+	struct pool_task *tasks;
+	int size;
+	int head;
+	int count;
+};
+
+/*
+ * Worker of the pool
+ * pool - pool of the worker
+ * index - number of the deque of the worker
+*/
+struct pool_worker {
+	struct pool *pool;
+	int index;
+};
+
+/*
+ * Pool context
+ * lock - mutex of the counters
+ * work - signal for the workers: new task or stop
+ * done - signal for the waiting threads: the group or all tasks are completed, new task
+ * queued - number of the tasks in the deques
+ * pending - number of the queued and executing tasks
+ * waiters - number of the threads waiting for the group
+ * next - deque of the next task submitted not by the worker
+ * stop - the workers must exit
+ * nthreads - number of the worker threads
+ * threads - worker threads
+ * workers - workers
+ * deques - deques of the workers
+*/
+struct pool {
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+	int queued;
+	int pending;
+	int waiters;
+	int next;
+	int stop;
+	int nthreads;
+	pthread_t *threads;
+	struct pool_worker *workers;
+	struct pool_deque *deques;
+};
+
+// Worker of the current thread, NULL if the thread is not the worker
+static __thread struct pool_worker *self;
+
+// Add the task to the end of the deque
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+pool_push(struct pool_deque *deque, const struct pool_task *task)
+{
+	struct pool_task *tasks;
+	int i, size;
+
+	pthread_mutex_lock(&deque->lock);
+
+	// The deque is full - double the size
+	if(deque->count == deque->size) {
+		size = deque->size * 2;
+
+		if((tasks = malloc(size * sizeof(*tasks))) == NULL) {
+			pthread_mutex_unlock(&deque->lock);
+			return -1;
+		}
+
+		for(i = 0; i < deque->count; i++)
+			tasks[i] = deque->tasks[(deque->head + i) % deque->size];
+
+		free(deque->tasks);
+		deque->tasks = tasks;
+		deque->size = size;
+		deque->head = 0;
+	}
+
+	deque->tasks[(deque->head + deque->count) % deque->size] = *task;
+	deque->count++;
+
+	pthread_mutex_unlock(&deque->lock);
+
+	return 0;
+}
+
+// Take the task: last - the last task (owner), else the first task (thief)
+// Return value: 1 (the task is taken), 0 (the deque is empty)
+static int
+pool_pop(struct pool_deque *deque, int last, struct pool_task *task)
+{
+	int res = 0;
+
+	pthread_mutex_lock(&deque->lock);
+
+	if(deque->count > 0) {
+		if(last)
+			*task = deque->tasks[(deque->head + deque->count - 1) % deque->size];
+		else {
+			*task = deque->tasks[deque->head];
+			deque->head = (deque->head + 1) % deque->size;
+		}
+
+		deque->count--;
+		res = 1;
+	}
+
+	pthread_mutex_unlock(&deque->lock);
+
+	return res;
+}
+
+// Find the task: own deque of the worker, then steal from the other deques
+// index - deque of the worker, -1 if the thread is not the worker
+// Return value: 1 (the task is taken), 0 (no tasks)
+static int
+pool_take(struct pool *pool, int index, struct pool_task *task)
+{
+	int i, start;
+
+	if((index >= 0) && pool_pop(&pool->deques[index], 1, task))
+		goto taken;
+
+	start = (index >= 0) ? index + 1 : 0;
+
+	for(i = 0; i < pool->nthreads; i++) {
+		if(pool_pop(&pool->deques[(start + i) % pool->nthreads], 0, task))
+			goto taken;
+	}
+
+	return 0;
+
+taken:
+	pthread_mutex_lock(&pool->lock);
+	pool->queued--;
+	pthread_mutex_unlock(&pool->lock);
+
+	return 1;
+}
+
+// Execute the task and count it as completed
+static void
+pool_run(struct pool *pool, struct pool_task *task)
+{
+	int wake;
+
+	task->func(task->arg);
+
+	pthread_mutex_lock(&pool->lock);
+
+	pool->pending--;
+	wake = (pool->pending == 0);
+
+	if(task->group != NULL)
+		wake |= (--task->group->pending == 0);
+
+	if(wake)
+		pthread_cond_broadcast(&pool->done);
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+// Index of the deque of the current thread, -1 if the thread is not the worker of the pool
+static int
+pool_self(struct pool *pool)
+{
+	return ((self != NULL) && (self->pool == pool)) ? self->index : -1;
+}
+
+// Worker thread of the pool
+static void *
+pool_thread(void *arg)
+{
+	struct pool_worker *worker = arg;
+	struct pool *pool = worker->pool;
+	struct pool_task task;
+
+	self = worker;
+
+	for(;;) {
+		if(pool_take(pool, worker->index, &task)) {
+			pool_run(pool, &task);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+
+		while((pool->queued == 0) && !pool->stop)
+			pthread_cond_wait(&pool->work, &pool->lock);
+
+		if((pool->queued == 0) && pool->stop) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return NULL;
+}
+
+// Stop the first n worker threads and free the pool
+static void
+pool_free(struct pool *pool, int n)
+{
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i = 0; i < n; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	for(i = 0; i < pool->nthreads; i++) {
+		pthread_mutex_destroy(&pool->deques[i].lock);
+		free(pool->deques[i].tasks);
+	}
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->work);
+	pthread_cond_destroy(&pool->done);
+
+	free(pool->deques);
+	free(pool->workers);
+	free(pool->threads);
+	free(pool);
+}
+
+// Create the pool
+// Return value: pointer of the pool or NULL (if all bad)
+struct pool *
+pool_create(int nthreads)
+{
+	struct pool *pool;
+	int i;
+
+	if(nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if(nthreads <= 0)
+		nthreads = 1;
+
+	if((pool = calloc(1, sizeof(*pool))) == NULL)
+		return NULL;
+
+	pool->threads = malloc(nthreads * sizeof(*pool->threads));
+	pool->workers = malloc(nthreads * sizeof(*pool->workers));
+	pool->deques = calloc(nthreads, sizeof(*pool->deques));
+
+	if((pool->threads == NULL) || (pool->workers == NULL) || (pool->deques == NULL)) {
+		free(pool->deques);
+		free(pool->workers);
+		free(pool->threads);
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	for(i = 0; i < nthreads; i++) {
+		pthread_mutex_init(&pool->deques[i].lock, NULL);
+		pool->deques[i].size = POOL_QUEUE;
+		pool->deques[i].tasks = malloc(POOL_QUEUE * sizeof(struct pool_task));
+	}
+
+	pool->nthreads = nthreads;
+
+	for(i = 0; i < nthreads; i++) {
+		if(pool->deques[i].tasks == NULL) {
+			pool_free(pool, 0);
+			return NULL;
+		}
+	}
+
+	for(i = 0; i < nthreads; i++) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].index = i;
+
+		if(pthread_create(&pool->threads[i], NULL, pool_thread, &pool->workers[i])) {
+			pool_free(pool, i);
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+// Number of the worker threads of the pool
+int
+pool_threads(struct pool *pool)
+{
+	return pool->nthreads;
+}
+
+// Initialization of the group of the tasks
+void
+pool_group_init(struct pool_group *group)
+{
+	group->pending = 0;
+}
+
+// Add the task of the group to the pool
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+pool_submit_group(struct pool *pool, struct pool_group *group, pool_task_t func, void *arg)
+{
+	struct pool_task task;
+	int index;
+
+	task.func = func;
+	task.arg = arg;
+	task.group = group;
+
+	// The counters are increased before the task can be taken
+	pthread_mutex_lock(&pool->lock);
+
+	if((index = pool_self(pool)) < 0)
+		index = pool->next++ % pool->nthreads;
+
+	pool->queued++;
+	pool->pending++;
+
+	if(group != NULL)
+		group->pending++;
+
+	pthread_mutex_unlock(&pool->lock);
+
+	if(pool_push(&pool->deques[index], &task)) {
+		pthread_mutex_lock(&pool->lock);
+
+		pool->queued--;
+		pool->pending--;
+
+		if(group != NULL)
+			group->pending--;
+
+		pthread_mutex_unlock(&pool->lock);
+
+		return -1;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+
+	pthread_cond_signal(&pool->work);
+
+	if(pool->waiters > 0)
+		pthread_cond_broadcast(&pool->done);
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return 0;
+}
+
+// Add the task to the pool
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+pool_submit(struct pool *pool, pool_task_t func, void *arg)
+{
+	return pool_submit_group(pool, NULL, func, arg);
+}
+
+// Wait for the tasks of the group, executing the tasks of the pool meanwhile
+void
+pool_wait_group(struct pool *pool, struct pool_group *group)
+{
+	struct pool_task task;
+	int index = pool_self(pool);
+
+	for(;;) {
+		pthread_mutex_lock(&pool->lock);
+
+		if(group->pending == 0) {
+			pthread_mutex_unlock(&pool->lock);
+			return;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+
+		if(pool_take(pool, index, &task)) {
+			pool_run(pool, &task);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		pool->waiters++;
+
+		while((group->pending > 0) && (pool->queued == 0))
+			pthread_cond_wait(&pool->done, &pool->lock);
+
+		pool->waiters--;
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+// Wait for all submitted tasks to complete
+void
+pool_wait(struct pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+
+	while(pool->pending > 0)
+		pthread_cond_wait(&pool->done, &pool->lock);
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+// Wait for all tasks, stop the worker threads and free the pool
+void
+pool_destroy(struct pool *pool)
+{
+	pool_free(pool, pool->nthreads);
+}
@@ -0,0 +1,53 @@
+/*
+ * Work-stealing thread pool for the parallel hash modes (KangarooTwelve and BLAKE3 tree hashing, hashsum).
+ * Every worker has its own deque of the tasks, the idle worker steals the tasks of the others.
+ * The task may submit the group of the subtasks to the same pool and wait for the group.
+*/
+
+#ifndef POOL_H
+#define POOL_H
+
+// Task function of the pool
+typedef void (*pool_task_t)(void *arg);
+
+struct pool;
+
+/*
+ * Group of the tasks
+ * pending - number of the not completed tasks of the group
+*/
+struct pool_group {
+	int pending;
+};
+
+// Create the pool
+// nthreads - number of the worker threads, 0 - number of the processors
+// Return value: pointer of the pool or NULL (if all bad)
+struct pool *pool_create(int nthreads);
+
+// Number of the worker threads of the pool
+int pool_threads(struct pool *pool);
+
+// Add the task to the pool
+// Return value: 0 (if all is well), -1 (if all bad)
+int pool_submit(struct pool *pool, pool_task_t func, void *arg);
+
+// Initialization of the group of the tasks
+void pool_group_init(struct pool_group *group);
+
+// Add the task of the group to the pool
+// Return value: 0 (if all is well), -1 (if all bad)
+int pool_submit_group(struct pool *pool, struct pool_group *group, pool_task_t func, void *arg);
+
+// Wait for the tasks of the group, the waiting thread executes the tasks of the pool meanwhile
+// May be called by the task of the pool
+void pool_wait_group(struct pool *pool, struct pool_group *group);
+
+// Wait for all submitted tasks to complete
+// Must not be called by the task of the pool
+void pool_wait(struct pool *pool);
+
+// Wait for all tasks, stop the worker threads and free the pool
+void pool_destroy(struct pool *pool);
+
+#endif /* POOL_H */
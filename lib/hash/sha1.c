@@ -12,6 +12,8 @@
 
 #include "sha1.h"
 #include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
 
 // SHA1 constant
 #define K0	0x5A827999
@@ -42,12 +44,14 @@
 }
 
 // Single bit (byte 0x80), other 63 bytes are zero
-static uint8_t sha1pad[64] = { 0x80 };
+static const uint8_t sha1pad[64] = { 0x80 };
 
 // Initialization function
 void
 sha1_init(struct sha1_context *ctx)
 {
+	HASH_TRACE_ENTRY(init, HASH_TRACE_SHA1, 20, ctx);
+
 	memset(ctx, 0, sizeof(*ctx));
 
 	ctx->state[0] = 0x67452301;
@@ -55,6 +59,8 @@ sha1_init(struct sha1_context *ctx)
 	ctx->state[2] = 0x98BADCFE;
 	ctx->state[3] = 0x10325476;
 	ctx->state[4] = 0xC3D2E1F0;
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_SHA1, ctx);
 }
 
 // 32-byte array is transformed into 8-byte array
@@ -72,6 +78,7 @@ uint32_to_bytes(uint8_t *out, uint32_t *in, const int n)
 }
 
 // SHA1 hash function
+ESTREAM_CLONES
 static void
 sha1_hash(struct sha1_context *ctx, const uint8_t buffer[64])
 {
@@ -269,6 +276,8 @@ sha1_update(struct sha1_context *ctx, const void *message, uint32_t msglen)
 {
 	int n, len;
 
+	HASH_TRACE_ENTRY(update, HASH_TRACE_SHA1, msglen, ctx);
+
 	n = ctx->nbits[0] & 0x3F;
 
 	len = 64 - n;
@@ -280,28 +289,31 @@ sha1_update(struct sha1_context *ctx, const void *message, uint32_t msglen)
 	if(ctx->nbits[0] < msglen)
 		++ctx->nbits[1];
 
-	if(msglen >= len) {
-		
-		// Calculate hash
+	// Fill and hash the partial block left by the previous call
+	if((n > 0) && (msglen >= len)) {
 		memcpy(ctx->buffer + n, message, len);
 		message += len;
 		msglen -= len;
 
 		sha1_hash(ctx, ctx->buffer);
 
-		// Calculate hash of the remaining messages
+		n = 0;
+	}
+
+	// Calculate hash of the full blocks directly from the message
+	if(n == 0) {
 		while(msglen >= 64) {
 			sha1_hash(ctx, message);
 			message += 64;
 			msglen -= 64;
 		}
-	
-		n = 0;
 	}
 
 	// Save message remaining bytes of the buffer
 	if(msglen > 0)
 		memcpy(ctx->buffer + n, message, msglen);
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_SHA1, ctx);
 }
 
 // Get the SHA1 hash of the message
@@ -313,6 +325,8 @@ sha1_final(struct sha1_context *ctx, uint8_t digest[20])
 	uint8_t nb[8];
 	int n, npad;
 
+	HASH_TRACE_ENTRY(final, HASH_TRACE_SHA1, 20, ctx);
+
 	n = ctx->nbits[0] & 0x3F;
 	npad = ((n < 56) ? 56 : 120) - n;
 
@@ -328,5 +342,37 @@ sha1_final(struct sha1_context *ctx, uint8_t digest[20])
 	sha1_update(ctx, nb, 8);
 
 	uint32_to_bytes(digest, ctx->state, 5);
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_SHA1, ctx);
 }
 
+// Export the state of the incomplete message
+void
+sha1_export_state(const struct sha1_context *ctx, uint8_t state[SHA1_STATE_SIZE])
+{
+	uint8_t *p = state;
+
+	HASH_STATE_PUT_HEADER(p, "SHA1");
+	HASH_STATE_PUT32(p, ctx->nbits, 2);
+	HASH_STATE_PUT32(p, ctx->state, 5);
+	HASH_STATE_PUT_BYTES(p, ctx->buffer, 64);
+}
+
+// Import the state exported by sha1_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+sha1_import_state(struct sha1_context *ctx, const uint8_t state[SHA1_STATE_SIZE])
+{
+	const uint8_t *p = state;
+
+	if(!HASH_STATE_CHECK_HEADER(p, "SHA1"))
+		return -1;
+
+	p += HASH_STATE_HEADER;
+
+	HASH_STATE_GET32(p, ctx->nbits, 2);
+	HASH_STATE_GET32(p, ctx->state, 5);
+	HASH_STATE_GET_BYTES(p, ctx->buffer, 64);
+
+	return 0;
+}
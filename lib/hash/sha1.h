@@ -7,6 +7,9 @@
 #ifndef SHA1_H
 #define SHA1_H
 
+// Size in bytes of the exported state
+#define SHA1_STATE_SIZE	100
+
 /*
  * SHA1 algorithm context
  * nbits - number bit of the input message
@@ -25,4 +28,11 @@ void sha1_update(struct sha1_context *ctx, const void *message, uint32_t msglen)
 
 void sha1_final(struct sha1_context *ctx, uint8_t digest[20]);
 
+// Export the state of the incomplete message (the context is not changed)
+void sha1_export_state(const struct sha1_context *ctx, uint8_t state[SHA1_STATE_SIZE]);
+
+// Import the state exported by sha1_export_state, then the message may be continued
+// Return value: 0 (if all is well), -1 (if the state is not SHA1 or the version is unknown)
+int sha1_import_state(struct sha1_context *ctx, const uint8_t state[SHA1_STATE_SIZE]);
+
 #endif /* SHA1_H */
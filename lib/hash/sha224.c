@@ -12,6 +12,8 @@
 
 #include "sha224.h"
 #include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
 
 // Functions for the SHA224 algorithm
 #define CH(x, y, z)	((x & y) ^ ((~x) & z))
@@ -45,7 +47,7 @@
 const uint8_t sha224pad[64] = { 0x80 };
 
 // SHA224 64 constant
-static const uint32_t K[64] = {
+static const uint32_t K[64] CACHE_ALIGNED = {
 	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
 	0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
 	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
@@ -67,6 +69,8 @@ static const uint32_t K[64] = {
 void
 sha224_init(struct sha224_context *ctx)
 {
+	HASH_TRACE_ENTRY(init, HASH_TRACE_SHA224, 28, ctx);
+
 	memset(ctx, 0, sizeof(*ctx));
 
 	ctx->state[0] = 0xC1059ED8;
@@ -77,6 +81,8 @@ sha224_init(struct sha224_context *ctx)
 	ctx->state[5] = 0x68581511;
 	ctx->state[6] = 0x64F98FA7;
 	ctx->state[7] = 0xBEFA4FA4;
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_SHA224, ctx);
 }
 
 // 32-byte array is transformed into 8-byte array
@@ -259,6 +265,8 @@ sha224_update(struct sha224_context *ctx, const void *message, uint32_t msglen)
 {
 	int n, len;
 
+	HASH_TRACE_ENTRY(update, HASH_TRACE_SHA224, msglen, ctx);
+
 	n = ctx->nbits[0] & 0x3F;
 
 	len = 64 - n;
@@ -270,28 +278,31 @@ sha224_update(struct sha224_context *ctx, const void *message, uint32_t msglen)
 	if(ctx->nbits[0] < msglen)
 		++ctx->nbits[1];
 	
-	if(msglen >= len) {
-		
-		// Calculate hash
+	// Fill and hash the partial block left by the previous call
+	if((n > 0) && (msglen >= len)) {
 		memcpy(ctx->buffer + n, message, len);
 		message += len;
 		msglen -= len;
-		
+
 		sha224_hash(ctx, ctx->buffer);
 
-		// Calculate hash of the remaining messages
+		n = 0;
+	}
+
+	// Calculate hash of the full blocks directly from the message
+	if(n == 0) {
 		while(msglen >= 64) {
 			sha224_hash(ctx, message);
 			message += 64;
 			msglen -= 64;
 		}
-
-		n = 0;
 	}
 
 	// Save message remaining bytes of the buffer
-	if(msglen >= 0)
+	if(msglen > 0)
 		memcpy(ctx->buffer + n, message, msglen);
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_SHA224, ctx);
 }
 
 // Get the SHA224 hash of the message
@@ -303,6 +314,8 @@ sha224_final(struct sha224_context *ctx, uint8_t digest[28])
 	uint8_t nb[8];
 	int n, npad;
 
+	HASH_TRACE_ENTRY(final, HASH_TRACE_SHA224, 28, ctx);
+
 	n = ctx->nbits[0] & 0x3F;
 	npad = ((n < 56) ? 56 : 120) - n;
 
@@ -318,5 +331,37 @@ sha224_final(struct sha224_context *ctx, uint8_t digest[28])
 	sha224_update(ctx, nb, 8);
 
 	uint32_to_bytes(digest, ctx->state, 7);
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_SHA224, ctx);
 }
 
+// Export the state of the incomplete message
+void
+sha224_export_state(const struct sha224_context *ctx, uint8_t state[SHA224_STATE_SIZE])
+{
+	uint8_t *p = state;
+
+	HASH_STATE_PUT_HEADER(p, "S224");
+	HASH_STATE_PUT32(p, ctx->nbits, 2);
+	HASH_STATE_PUT32(p, ctx->state, 8);
+	HASH_STATE_PUT_BYTES(p, ctx->buffer, 64);
+}
+
+// Import the state exported by sha224_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+sha224_import_state(struct sha224_context *ctx, const uint8_t state[SHA224_STATE_SIZE])
+{
+	const uint8_t *p = state;
+
+	if(!HASH_STATE_CHECK_HEADER(p, "S224"))
+		return -1;
+
+	p += HASH_STATE_HEADER;
+
+	HASH_STATE_GET32(p, ctx->nbits, 2);
+	HASH_STATE_GET32(p, ctx->state, 8);
+	HASH_STATE_GET_BYTES(p, ctx->buffer, 64);
+
+	return 0;
+}
@@ -7,6 +7,9 @@
 #ifndef SHA224_H
 #define SHA224_H
 
+// Size in bytes of the exported state
+#define SHA224_STATE_SIZE	112
+
 /*
  * SHA224 algorithm context
  * nbits - number bit of the input message
@@ -25,4 +28,11 @@ void sha224_update(struct sha224_context *ctx, const void *message, uint32_t msg
 
 void sha224_final(struct sha224_context *ctx, uint8_t digest[28]);
 
+// Export the state of the incomplete message (the context is not changed)
+void sha224_export_state(const struct sha224_context *ctx, uint8_t state[SHA224_STATE_SIZE]);
+
+// Import the state exported by sha224_export_state, then the message may be continued
+// Return value: 0 (if all is well), -1 (if the state is not SHA224 or the version is unknown)
+int sha224_import_state(struct sha224_context *ctx, const uint8_t state[SHA224_STATE_SIZE]);
+
 #endif /* SHA224_H */
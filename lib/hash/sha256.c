@@ -12,6 +12,20 @@
 
 #include "sha256.h"
 #include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
+
+// ARMv8 crypto extensions (sha256h, sha256h2, sha256su0, sha256su1), GCC 8 and later
+#if defined(__GNUC__) && defined(__aarch64__) && (__GNUC__ >= 8)
+#define SHA256_ARM
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2	(1 << 6)
+#endif
+#endif
 
 // Functions for the SHA256 algorithm
 #define CH(x, y, z)	((x & y) ^ ((~x) & z))
@@ -45,7 +59,7 @@
 const uint8_t sha256pad[64] = { 0x80 };
 
 // SHA256 64 constant
-static const uint32_t K[64] = {
+static const uint32_t K[64] CACHE_ALIGNED = {
 	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
 	0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
 	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
@@ -67,6 +81,8 @@ static const uint32_t K[64] = {
 void
 sha256_init(struct sha256_context *ctx)
 {
+	HASH_TRACE_ENTRY(init, HASH_TRACE_SHA256, 32, ctx);
+
 	memset(ctx, 0, sizeof(*ctx));
 
 	ctx->state[0] = 0x6A09E667;
@@ -77,6 +93,8 @@ sha256_init(struct sha256_context *ctx)
 	ctx->state[5] = 0x9B05688C;
 	ctx->state[6] = 0x1F83D9AB;
 	ctx->state[7] = 0x5BE0CD19;
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_SHA256, ctx);
 }
 
 // 32-byte array is transformed into 8-byte array
@@ -93,13 +111,72 @@ uint32_to_bytes(uint8_t *out, uint32_t *in, const int n)
 	}
 }
 
+#ifdef SHA256_ARM
+#pragma GCC push_options
+#pragma GCC target("arch=armv8-a+crypto")
+
+// SHA256 hash function on the ARMv8 crypto extensions: 4 rounds per the sha256h/sha256h2 pair
+static void
+sha256_hash_arm(struct sha256_context *ctx, const uint8_t buffer[64])
+{
+	uint32x4_t abcd, efgh, abcd_save, efgh_save, msg[4], wk, temp;
+	int i;
+
+	abcd = abcd_save = vld1q_u32(ctx->state);
+	efgh = efgh_save = vld1q_u32(ctx->state + 4);
+
+	for(i = 0; i < 4; i++)
+		msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(buffer + 16 * i)));
+
+	for(i = 0; i < 16; i++) {
+		wk = vaddq_u32(msg[i & 3], vld1q_u32(K + 4 * i));
+		temp = abcd;
+		abcd = vsha256hq_u32(abcd, efgh, wk);
+		efgh = vsha256h2q_u32(efgh, temp, wk);
+
+		// Message schedule of the next 4 words
+		if(i < 12)
+			msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]),
+					msg[(i + 2) & 3], msg[(i + 3) & 3]);
+	}
+
+	vst1q_u32(ctx->state, vaddq_u32(abcd, abcd_save));
+	vst1q_u32(ctx->state + 4, vaddq_u32(efgh, efgh_save));
+}
+
+#pragma GCC pop_options
+
+// 1 if the processor has the SHA2 instructions (hwcap of the kernel)
+static int
+sha256_arm(void)
+{
+	static int sha2 = -1;
+	int r = __atomic_load_n(&sha2, __ATOMIC_RELAXED);
+
+	if(r < 0) {
+		r = (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+		__atomic_store_n(&sha2, r, __ATOMIC_RELAXED);
+	}
+
+	return r;
+}
+#endif /* SHA256_ARM */
+
 // SHA256 hash function
+ESTREAM_CLONES
 static void
 sha256_hash(struct sha256_context *ctx, const uint8_t buffer[64])
 {
 	uint32_t W[64];
 	uint32_t a, b, c, d, e, f, g, h;
 
+#ifdef SHA256_ARM
+	if(sha256_arm()) {
+		sha256_hash_arm(ctx, buffer);
+		return;
+	}
+#endif
+
 	a = ctx->state[0];
 	b = ctx->state[1];
 	c = ctx->state[2];
@@ -259,6 +336,8 @@ sha256_update(struct sha256_context *ctx, const void *message, uint32_t msglen)
 {
 	int n, len;
 
+	HASH_TRACE_ENTRY(update, HASH_TRACE_SHA256, msglen, ctx);
+
 	n = ctx->nbits[0] & 0x3F;
 
 	len = 64 - n;
@@ -270,28 +349,31 @@ sha256_update(struct sha256_context *ctx, const void *message, uint32_t msglen)
 	if(ctx->nbits[0] < msglen)
 		++ctx->nbits[1];
 
-	if(msglen >= len) {
-		
-		// Calculate hash
+	// Fill and hash the partial block left by the previous call
+	if((n > 0) && (msglen >= len)) {
 		memcpy(ctx->buffer + n, message, len);
 		message += len;
 		msglen -= len;
 
 		sha256_hash(ctx, ctx->buffer);
 
-		// Calculate hash of the remaining messages
+		n = 0;
+	}
+
+	// Calculate hash of the full blocks directly from the message
+	if(n == 0) {
 		while(msglen >= 64) {
 			sha256_hash(ctx, message);
 			message += 64;
 			msglen -= 64;
 		}
-
-		n = 0;
 	}
 
 	// Save message remaining bytes of the buffer
-	if(msglen >= 0)
+	if(msglen > 0)
 		memcpy(ctx->buffer + n, message, msglen);
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_SHA256, ctx);
 }
 
 // Get the SHA256 hash of the message
@@ -303,6 +385,8 @@ sha256_final(struct sha256_context *ctx, uint8_t digest[32])
 	uint8_t nb[8];
 	int n, npad;
 
+	HASH_TRACE_ENTRY(final, HASH_TRACE_SHA256, 32, ctx);
+
 	n = ctx->nbits[0] & 0x3F;
 	npad = ((n < 56) ? 56 : 120) - n;
 
@@ -318,5 +402,37 @@ sha256_final(struct sha256_context *ctx, uint8_t digest[32])
 	sha256_update(ctx, nb, 8);
 
 	uint32_to_bytes(digest, ctx->state, 8);
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_SHA256, ctx);
 }
 
+// Export the state of the incomplete message
+void
+sha256_export_state(const struct sha256_context *ctx, uint8_t state[SHA256_STATE_SIZE])
+{
+	uint8_t *p = state;
+
+	HASH_STATE_PUT_HEADER(p, "S256");
+	HASH_STATE_PUT32(p, ctx->nbits, 2);
+	HASH_STATE_PUT32(p, ctx->state, 8);
+	HASH_STATE_PUT_BYTES(p, ctx->buffer, 64);
+}
+
+// Import the state exported by sha256_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+sha256_import_state(struct sha256_context *ctx, const uint8_t state[SHA256_STATE_SIZE])
+{
+	const uint8_t *p = state;
+
+	if(!HASH_STATE_CHECK_HEADER(p, "S256"))
+		return -1;
+
+	p += HASH_STATE_HEADER;
+
+	HASH_STATE_GET32(p, ctx->nbits, 2);
+	HASH_STATE_GET32(p, ctx->state, 8);
+	HASH_STATE_GET_BYTES(p, ctx->buffer, 64);
+
+	return 0;
+}
@@ -7,6 +7,9 @@
 #ifndef SHA256_H
 #define SHA256_H
 
+// Size in bytes of the exported state
+#define SHA256_STATE_SIZE	112
+
 /*
  * SHA256 algorithm context
  * nbits - number bit of the input message
@@ -25,4 +28,11 @@ void sha256_update(struct sha256_context *ctx, const void *message, uint32_t msg
 
 void sha256_final(struct sha256_context *ctx, uint8_t digest[32]);
 
+// Export the state of the incomplete message (the context is not changed)
+void sha256_export_state(const struct sha256_context *ctx, uint8_t state[SHA256_STATE_SIZE]);
+
+// Import the state exported by sha256_export_state, then the message may be continued
+// Return value: 0 (if all is well), -1 (if the state is not SHA256 or the version is unknown)
+int sha256_import_state(struct sha256_context *ctx, const uint8_t state[SHA256_STATE_SIZE]);
+
 #endif /* SHA256_H */
@@ -12,9 +12,11 @@
 
 #include "sha3.h"
 #include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
 
 // SHA3 rotate index
-static const uint64_t ROTATE[25] = {
+static const uint64_t ROTATE[25] CACHE_ALIGNED = {
 	 0, 36,  3, 41, 18,
 	 1, 44, 10, 45,  2,
 	62,  6, 43, 15, 61,
@@ -23,7 +25,7 @@ static const uint64_t ROTATE[25] = {
 };
 
 // SHA3 array of the constant, RC[i] XOR A[0] end of the round
-static const uint64_t RC[24] = {
+static const uint64_t RC[24] CACHE_ALIGNED = {
 	0x0000000000000001, 0x0000000000008082,
 	0x800000000000808A, 0x8000000080008000,
 	0x000000000000808B, 0x0000000080000001,
@@ -43,6 +45,8 @@ static const uint64_t RC[24] = {
 void
 sha3_init(struct sha3_context *ctx, int hash_size)
 {
+	HASH_TRACE_ENTRY(init, HASH_TRACE_SHA3(hash_size / 8), hash_size / 8, ctx);
+
 	memset(ctx, 0, sizeof(*ctx));
 
 	// Fill the sha3_context depending on the size of the hash
@@ -63,47 +67,24 @@ sha3_init(struct sha3_context *ctx, int hash_size)
 		  ctx->r = 72;
 		  break;
 	}
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_SHA3(ctx->hash_size), ctx);
 }
 
-// SHA3 hash function
-static void
-sha3_hash(struct sha3_context *ctx, const uint8_t buffer[144])
+// Keccak-f[1600] permutation of the state
+// rounds - number of the rounds: 24 for SHA3, 12 for KangarooTwelve
+ESTREAM_CLONES
+void
+keccak_permute(uint64_t state[25], int rounds)
 {
 	uint64_t C[5], D[5], B[25], A[25];
 	int i;
 
 	// Copy state of the array A
-	memcpy(A, ctx->state, sizeof(A));
-
-	A[ 0] ^= U8TO64_LITTLE(buffer + 0);
-	A[ 5] ^= U8TO64_LITTLE(buffer + 8);
-	A[10] ^= U8TO64_LITTLE(buffer + 16);
-	A[15] ^= U8TO64_LITTLE(buffer + 24);
-	A[20] ^= U8TO64_LITTLE(buffer + 32);
-	A[ 1] ^= U8TO64_LITTLE(buffer + 40);
-	A[ 6] ^= U8TO64_LITTLE(buffer + 48);
-	A[11] ^= U8TO64_LITTLE(buffer + 56);
-	A[16] ^= U8TO64_LITTLE(buffer + 64);
-	
-	if(ctx->hash_size < 64) {
-		A[21] ^= U8TO64_LITTLE(buffer + 72);
-		A[ 2] ^= U8TO64_LITTLE(buffer + 80);
-		A[ 7] ^= U8TO64_LITTLE(buffer + 88);
-		A[12] ^= U8TO64_LITTLE(buffer + 96);
-	
-		if(ctx->hash_size < 48) {
-			A[17] ^= U8TO64_LITTLE(buffer + 104);
-			A[21] ^= U8TO64_LITTLE(buffer + 112);
-			A[ 3] ^= U8TO64_LITTLE(buffer + 120);
-			A[ 8] ^= U8TO64_LITTLE(buffer + 128);
-		}
-	
-		if(ctx->hash_size < 32)
-			A[13] ^= U8TO64_LITTLE(buffer + 136);
-	}
+	memcpy(A, state, sizeof(A));
 
-	// SHA3 24 round
-	for(i = 0; i < 24; i++) {
+	// The last rounds of the 24 SHA3 rounds
+	for(i = 24 - rounds; i < 24; i++) {
 		C[0] = A[ 0] ^ A[ 1] ^ A[ 2] ^ A[ 3] ^ A[ 4];
 		C[1] = A[ 5] ^ A[ 6] ^ A[ 7] ^ A[ 8] ^ A[ 9];
 		C[2] = A[10] ^ A[11] ^ A[12] ^ A[13] ^ A[14];
@@ -142,7 +123,8 @@ sha3_hash(struct sha3_context *ctx, const uint8_t buffer[144])
 		A[23] ^= D[4];
 		A[24] ^= D[4];
 
-		B[ 0] = ROTL64(A[ 0], ROTATE[ 0]);
+		// ROTATE[0] is zero, the shift by 64 is undefined
+		B[ 0] = A[ 0];
 		B[ 8] = ROTL64(A[ 1], ROTATE[ 1]);
 		B[11] = ROTL64(A[ 2], ROTATE[ 2]);
 		B[19] = ROTL64(A[ 3], ROTATE[ 3]);
@@ -197,11 +179,45 @@ sha3_hash(struct sha3_context *ctx, const uint8_t buffer[144])
 		A[0] ^= RC[i];
 	}
 
-	// SHA3 hash save
-	memcpy(ctx->state, A, sizeof(A));
+	// Keccak state save
+	memcpy(state, A, sizeof(A));
+}
+
+// SHA3 hash function
+static void
+sha3_hash(struct sha3_context *ctx, const uint8_t buffer[144])
+{
+	ctx->state[ 0] ^= U8TO64_LITTLE(buffer + 0);
+	ctx->state[ 5] ^= U8TO64_LITTLE(buffer + 8);
+	ctx->state[10] ^= U8TO64_LITTLE(buffer + 16);
+	ctx->state[15] ^= U8TO64_LITTLE(buffer + 24);
+	ctx->state[20] ^= U8TO64_LITTLE(buffer + 32);
+	ctx->state[ 1] ^= U8TO64_LITTLE(buffer + 40);
+	ctx->state[ 6] ^= U8TO64_LITTLE(buffer + 48);
+	ctx->state[11] ^= U8TO64_LITTLE(buffer + 56);
+	ctx->state[16] ^= U8TO64_LITTLE(buffer + 64);
+	
+	if(ctx->hash_size < 64) {
+		ctx->state[21] ^= U8TO64_LITTLE(buffer + 72);
+		ctx->state[ 2] ^= U8TO64_LITTLE(buffer + 80);
+		ctx->state[ 7] ^= U8TO64_LITTLE(buffer + 88);
+		ctx->state[12] ^= U8TO64_LITTLE(buffer + 96);
+	
+		if(ctx->hash_size < 48) {
+			ctx->state[17] ^= U8TO64_LITTLE(buffer + 104);
+			ctx->state[22] ^= U8TO64_LITTLE(buffer + 112);
+			ctx->state[ 3] ^= U8TO64_LITTLE(buffer + 120);
+			ctx->state[ 8] ^= U8TO64_LITTLE(buffer + 128);
+		}
+	
+		if(ctx->hash_size < 32)
+			ctx->state[13] ^= U8TO64_LITTLE(buffer + 136);
+	}
+
+	keccak_permute(ctx->state, 24);
 }
 
-// SHA3 padding function
+// SHA3 padding function (FIPS 202): domain bits 01 of the SHA3 and the pad10*1 - the byte 0x06 ... 0x80
 static void
 sha3_padding(struct sha3_context *ctx, uint8_t buffer[144])
 {
@@ -209,14 +225,14 @@ sha3_padding(struct sha3_context *ctx, uint8_t buffer[144])
 
 	n = ctx->nbytes;
 
-	// If add 1 byte -> padding 0x81
+	// If add 1 byte -> padding 0x86
 	if(ctx->nbytes + 1 == ctx->r) {
-		buffer[ctx->r-1] = 0x81;
+		buffer[ctx->r-1] = 0x86;
 		return;
 	}
 
-	// Add 0x01 in the end message
-	buffer[n] = 0x01;
+	// Add 0x06 in the end message
+	buffer[n] = 0x06;
 
 	// Add 0x00 in the message
 	memset(buffer + (n+1), 0, ctx->r - n - 2);
@@ -232,46 +248,41 @@ sha3_update(struct sha3_context *ctx, void *message, uint32_t msglen)
 {
 	int n, len, r;
 
+	HASH_TRACE_ENTRY(update, HASH_TRACE_SHA3(ctx->hash_size), msglen, ctx);
+
 	n = ctx->nbytes;
 	r = ctx->r;
-	len = r - n;
 
-	// Check buffer empty
-	if(len == 0) {
-		len = r;
-		n = 0;
-	}
+	// Fill the partial block left by the previous call
+	if(n > 0) {
+		len = r - n;
+
+		if(msglen < len) {
+			memcpy(ctx->buffer + n, message, msglen);
+			ctx->nbytes += msglen;
+			HASH_TRACE_RETURN(update, HASH_TRACE_SHA3(ctx->hash_size), ctx);
+			return;
+		}
 
-	if(msglen >= len) {
-	
-		// Calculate hash
 		memcpy(ctx->buffer + n, message, len);
 		message += len;
 		msglen -= len;
 
 		sha3_hash(ctx, ctx->buffer);
-
-		// Calculate hash of the remaining messages
-		while(msglen >= r) {
-			sha3_hash(ctx, message);
-			message += len;
-			msglen -= len;
-		}
-
-		n = 0;
-		ctx->nbytes = r;
 	}
 
-	// The number of bytes in the buffer
-	ctx->nbytes += msglen;
-
-	// If number of bytes > R, then nbytes = msglen 
-	if(ctx->nbytes > r)
-		ctx->nbytes = msglen;
+	// Calculate hash of the full blocks directly from the message
+	while(msglen >= r) {
+		sha3_hash(ctx, message);
+		message += r;
+		msglen -= r;
+	}
 
 	// Save message remaining bytes of the buffer
-	if(msglen > 0)
-		memcpy(ctx->buffer + n, message, msglen);
+	memcpy(ctx->buffer, message, msglen);
+	ctx->nbytes = msglen;
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_SHA3(ctx->hash_size), ctx);
 }
 
 // SHA3 final function
@@ -279,11 +290,11 @@ sha3_update(struct sha3_context *ctx, void *message, uint32_t msglen)
 void
 sha3_final(struct sha3_context *ctx, uint8_t *digest)
 {
-	// Padding message
-	if((ctx->r - ctx->nbytes) > 0) {
-		sha3_padding(ctx, ctx->buffer);
-		sha3_hash(ctx, ctx->buffer);
-	}
+	HASH_TRACE_ENTRY(final, HASH_TRACE_SHA3(ctx->hash_size), ctx->hash_size, ctx);
+
+	// Padding message, the last block always contains padding
+	sha3_padding(ctx, ctx->buffer);
+	sha3_hash(ctx, ctx->buffer);
 
 	// Save hash of the digest
 	U64TO8_LITTLE((digest +  0), ctx->state[ 0]);
@@ -307,5 +318,51 @@ sha3_final(struct sha3_context *ctx, uint8_t *digest)
 			U64TO8_LITTLE((digest + 56), ctx->state[11]);
 		}
 	}
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_SHA3(ctx->hash_size), ctx);
 }
 
+// Export the state of the incomplete message
+void
+sha3_export_state(const struct sha3_context *ctx, uint8_t state[SHA3_STATE_SIZE])
+{
+	uint8_t *p = state;
+
+	HASH_STATE_PUT_HEADER(p, "SHA3");
+	HASH_STATE_PUT64(p, ctx->state, 25);
+	HASH_STATE_PUT_BYTES(p, ctx->buffer, 144);
+	U32TO8_LITTLE(p, ctx->hash_size);
+	U32TO8_LITTLE((p + 4), ctx->nbytes);
+	U32TO8_LITTLE((p + 8), ctx->r);
+}
+
+// Import the state exported by sha3_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+sha3_import_state(struct sha3_context *ctx, const uint8_t state[SHA3_STATE_SIZE])
+{
+	const uint8_t *p = state;
+	uint32_t hash_size, nbytes, r;
+
+	if(!HASH_STATE_CHECK_HEADER(p, "SHA3"))
+		return -1;
+
+	p += HASH_STATE_HEADER;
+
+	hash_size = U8TO32_LITTLE((p + 200 + 144));
+	nbytes = U8TO32_LITTLE((p + 200 + 148));
+	r = U8TO32_LITTLE((p + 200 + 152));
+
+	// The rate depends on the size of the hash, the buffer is not full
+	if(((hash_size != 28) && (hash_size != 32) && (hash_size != 48) && (hash_size != 64)) ||
+	   (r != 200 - 2 * hash_size) || (nbytes >= r))
+		return -1;
+
+	HASH_STATE_GET64(p, ctx->state, 25);
+	HASH_STATE_GET_BYTES(p, ctx->buffer, 144);
+	ctx->hash_size = hash_size;
+	ctx->nbytes = nbytes;
+	ctx->r = r;
+
+	return 0;
+}
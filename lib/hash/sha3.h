@@ -7,6 +7,9 @@
 #ifndef SHA3_H
 #define SHA3_H
 
+// Size in bytes of the exported state
+#define SHA3_STATE_SIZE	364
+
 /*
  * SHA3 algorithm context
  * state - 1600 bits output state (Hash)
@@ -23,6 +26,10 @@ struct sha3_context {
 	int r;
 };
 
+// Keccak-f[1600] permutation of the state
+// rounds - number of the last rounds: 24 for SHA3, 12 for KangarooTwelve
+void keccak_permute(uint64_t state[25], int rounds);
+
 // SHA3 initialization function
 // hash_size - the size in bits of the hash
 void sha3_init(struct sha3_context *ctx, int hash_size);
@@ -35,4 +42,11 @@ void sha3_update(struct sha3_context *ctx, void *message, uint32_t msglen);
 // digest - the pointer of the hash
 void sha3_final(struct sha3_context *ctx, uint8_t *digest);
 
+// Export the state of the incomplete message (the context is not changed)
+void sha3_export_state(const struct sha3_context *ctx, uint8_t state[SHA3_STATE_SIZE]);
+
+// Import the state exported by sha3_export_state, then the message may be continued
+// Return value: 0 (if all is well), -1 (if the state is not SHA3, the version is unknown or the state is damaged)
+int sha3_import_state(struct sha3_context *ctx, const uint8_t state[SHA3_STATE_SIZE]);
+
 #endif /* SHA3_H */
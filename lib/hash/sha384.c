@@ -12,6 +12,8 @@
 
 #include "sha384.h"
 #include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
 
 // Functions for the SHA384 algorithm
 #define CH(x, y, z)	((x & y) ^ ((~x) & z))
@@ -45,7 +47,7 @@
 const uint8_t sha384pad[128] = { 0x80 };
 
 // SHA384 80 constant
-static const uint64_t K[80] = { 
+static const uint64_t K[80] CACHE_ALIGNED = {
 	0x428A2F98D728AE22, 0x7137449123EF65CD, 0xB5C0FBCFEC4D3B2F, 0xE9B5DBA58189DBBC,
 	0x3956C25BF348B538, 0x59F111F1B605D019, 0x923F82A4AF194F9B, 0xAB1C5ED5DA6D8118,
 	0xD807AA98A3030242, 0x12835B0145706FBE, 0x243185BE4EE4B28C, 0x550C7DC3D5FFB4E2,
@@ -71,6 +73,8 @@ static const uint64_t K[80] = {
 void
 sha384_init(struct sha384_context *ctx)
 {
+	HASH_TRACE_ENTRY(init, HASH_TRACE_SHA384, 48, ctx);
+
 	memset(ctx, 0, sizeof(*ctx));
 
 	ctx->state[0] = 0xCBBB9D5DC1059ED8;
@@ -81,6 +85,8 @@ sha384_init(struct sha384_context *ctx)
 	ctx->state[5] = 0x8EB44A8768581511;
 	ctx->state[6] = 0xDB0C2E0D64F98FA7;
 	ctx->state[7] = 0x47B5481DBEFA4FA4;
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_SHA384, ctx);
 }
 
 // 32-byte array is transformed into 8-byte array
@@ -313,6 +319,8 @@ sha384_update(struct sha384_context *ctx, const void *message, uint32_t msglen)
 {
 	int n, len;
 
+	HASH_TRACE_ENTRY(update, HASH_TRACE_SHA384, msglen, ctx);
+
 	n = ctx->nbits[0] & 0x7F;
 
 	len = 128 - n;
@@ -324,28 +332,31 @@ sha384_update(struct sha384_context *ctx, const void *message, uint32_t msglen)
 	if(ctx->nbits[0] < msglen)
 		++ctx->nbits[1];
 
-	if(msglen >= len) {
-	
-		// Calculate hash
+	// Fill and hash the partial block left by the previous call
+	if((n > 0) && (msglen >= len)) {
 		memcpy(ctx->buffer + n, message, len);
 		message += len;
 		msglen -= len;
 
 		sha384_hash(ctx, ctx->buffer);
 
-		// Calculate hash of the remaining messages
+		n = 0;
+	}
+
+	// Calculate hash of the full blocks directly from the message
+	if(n == 0) {
 		while(msglen >= 128) {
 			sha384_hash(ctx, message);
 			message += 128;
 			msglen -= 128;
 		}
-
-		n = 0;
 	}
 
 	// Save message remaining bytes of the buffer
-	if(msglen >= 0)
+	if(msglen > 0)
 		memcpy(ctx->buffer + n, message, msglen);
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_SHA384, ctx);
 }
 
 // Get the SHA384 hash of the message
@@ -357,6 +368,8 @@ sha384_final(struct sha384_context *ctx, uint8_t digest[48])
 	uint8_t nb[16];
 	int n, npad;
 
+	HASH_TRACE_ENTRY(final, HASH_TRACE_SHA384, 48, ctx);
+
 	n = ctx->nbits[0] & 0x7F;
 	npad = ((n < 112) ? 112 : 240) - n;
 
@@ -373,5 +386,37 @@ sha384_final(struct sha384_context *ctx, uint8_t digest[48])
 	sha384_update(ctx, nb, 16);
 
 	uint64_to_bytes(digest, ctx->state, 6);
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_SHA384, ctx);
 }
 
+// Export the state of the incomplete message
+void
+sha384_export_state(const struct sha384_context *ctx, uint8_t state[SHA384_STATE_SIZE])
+{
+	uint8_t *p = state;
+
+	HASH_STATE_PUT_HEADER(p, "S384");
+	HASH_STATE_PUT32(p, ctx->nbits, 2);
+	HASH_STATE_PUT64(p, ctx->state, 8);
+	HASH_STATE_PUT_BYTES(p, ctx->buffer, 128);
+}
+
+// Import the state exported by sha384_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+sha384_import_state(struct sha384_context *ctx, const uint8_t state[SHA384_STATE_SIZE])
+{
+	const uint8_t *p = state;
+
+	if(!HASH_STATE_CHECK_HEADER(p, "S384"))
+		return -1;
+
+	p += HASH_STATE_HEADER;
+
+	HASH_STATE_GET32(p, ctx->nbits, 2);
+	HASH_STATE_GET64(p, ctx->state, 8);
+	HASH_STATE_GET_BYTES(p, ctx->buffer, 128);
+
+	return 0;
+}
@@ -7,6 +7,9 @@
 #ifndef SHA384_H
 #define SHA384_H
 
+// Size in bytes of the exported state
+#define SHA384_STATE_SIZE	208
+
 /*
  * SHA384 algorithm context
  * nbits - number bit of the input message
@@ -25,4 +28,11 @@ void sha384_update(struct sha384_context *ctx, const void *message, uint32_t msg
 
 void sha384_final(struct sha384_context *ctx, uint8_t digest[48]);
 
+// Export the state of the incomplete message (the context is not changed)
+void sha384_export_state(const struct sha384_context *ctx, uint8_t state[SHA384_STATE_SIZE]);
+
+// Import the state exported by sha384_export_state, then the message may be continued
+// Return value: 0 (if all is well), -1 (if the state is not SHA384 or the version is unknown)
+int sha384_import_state(struct sha384_context *ctx, const uint8_t state[SHA384_STATE_SIZE]);
+
 #endif /* SHA384_H */
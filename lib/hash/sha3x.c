@@ -0,0 +1,248 @@
+/*
+ * This program implements the multi-buffer SHA3 hash function.
+ * Author SHA3 algorithm - Guido Bertoni, Joan Daemen, Michael Peeters and Gilles Van Assche.
+ * ----------------------
+ * Up to 8 independent Keccak states are interleaved as parallel 64-bit lanes
+ * and permuted together with AVX2 (4 lanes) or AVX-512 (8 lanes).
+ * Messages may have different length: the lane whose message is finished
+ * gives the hash and immediately takes the next message.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "sha3.h"
+#include "sha3x.h"
+#include "../macro.h"
+
+// SHA3 rotate index
+static const uint64_t ROTATE[25] CACHE_ALIGNED = {
+	 0, 36,  3, 41, 18,
+	 1, 44, 10, 45,  2,
+	62,  6, 43, 15, 61,
+	28, 55, 25, 21, 56,
+	27, 20, 39,  8, 14
+};
+
+// SHA3 array of the constant, RC[i] XOR A[0] end of the round
+static const uint64_t RC[24] CACHE_ALIGNED = {
+	0x0000000000000001, 0x0000000000008082,
+	0x800000000000808A, 0x8000000080008000,
+	0x000000000000808B, 0x0000000080000001,
+	0x8000000080008081, 0x8000000000008009,
+	0x000000000000008A, 0x0000000000000088,
+	0x0000000080008009, 0x000000008000000A,
+	0x000000008000808B, 0x800000000000008B,
+	0x8000000000008089, 0x8000000000008003,
+	0x8000000000008002, 0x8000000000000080,
+	0x000000000000800A, 0x800000008000000A,
+	0x8000000080008081, 0x8000000000008080,
+	0x0000000080000001, 0x8000000080008008
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA3X_SIMD
+
+// 4 lanes, AVX2
+#pragma GCC push_options
+#pragma GCC target("avx2")
+typedef uint64_t v4u64 __attribute__((vector_size(32)));
+#define SHA3X_VEC	v4u64
+#define SHA3X_LANES	4
+#define SHA3X_PERMUTE	sha3x_permute4
+#include "sha3x_kernel.h"
+#undef SHA3X_VEC
+#undef SHA3X_LANES
+#undef SHA3X_PERMUTE
+#pragma GCC pop_options
+
+// 8 lanes, AVX-512
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+typedef uint64_t v8u64 __attribute__((vector_size(64)));
+#define SHA3X_VEC	v8u64
+#define SHA3X_LANES	8
+#define SHA3X_PERMUTE	sha3x_permute8
+#include "sha3x_kernel.h"
+#undef SHA3X_VEC
+#undef SHA3X_LANES
+#undef SHA3X_PERMUTE
+#pragma GCC pop_options
+
+#endif /* SHA3X_SIMD */
+
+/*
+ * State of the one lane
+ * message - the remaining part of the message
+ * msglen - the remaining size in bytes of the message
+ * index - number of the message, -1 if the lane is free
+ * last - the last (padded) block is absorbed
+ * buffer - the last padded block
+*/
+struct sha3x_lane {
+	const uint8_t *message;
+	uint32_t msglen;
+	int index;
+	int last;
+	uint8_t buffer[144];
+};
+
+// Number of the lanes used on this processor
+int
+sha3x_lanes(void)
+{
+#ifdef SHA3X_SIMD
+	if(__builtin_cpu_supports("avx512f"))
+		return 8;
+
+	if(__builtin_cpu_supports("avx2"))
+		return 4;
+#endif
+	return 1;
+}
+
+// Rate in bytes of the SHA3, depends on the size of the hash
+static int
+sha3x_rate(int hash_size)
+{
+	switch(hash_size) {
+	case 224 : return 144;
+	case 256 : return 136;
+	case 384 : return 104;
+	default : return 72;
+	}
+}
+
+// Word index in the state of the i-th 64-bit word of the block
+#define WORD(i)		(((i) % 5) * 5 + (i) / 5)
+
+// Take the next block of the lane: full block of the message or the last padded block
+static const uint8_t *
+sha3x_block(struct sha3x_lane *lane, int r)
+{
+	const uint8_t *block;
+	uint32_t n;
+
+	if(lane->msglen >= r) {
+		block = lane->message;
+		lane->message += r;
+		lane->msglen -= r;
+		return block;
+	}
+
+	// Padding as in the sha3_padding function
+	n = lane->msglen;
+	memcpy(lane->buffer, lane->message, n);
+	memset(lane->buffer + n, 0, r - n);
+	lane->buffer[n] = 0x06;
+	lane->buffer[r-1] |= 0x80;
+	lane->last = 1;
+
+	return lane->buffer;
+}
+
+// SHA3x hash function of the limit of the lanes
+void
+sha3x_hash_lanes(int hash_size, int n, const void *message[], const uint32_t msglen[], uint8_t *digest[], int lanes)
+{
+	uint64_t state[25 * SHA3X_MAX_LANES] __attribute__((aligned(64)));
+	struct sha3x_lane lane[SHA3X_MAX_LANES];
+	struct sha3_context ctx;
+	const uint8_t *block;
+	uint64_t word;
+	int r, size, next, active, i, j, l;
+
+	// The widest kernel of the processor not wider than the limit
+	if((lanes == 0) || (lanes >= sha3x_lanes()))
+		lanes = sha3x_lanes();
+	else
+		lanes = (lanes >= 4) ? 4 : 1;
+
+	// No SIMD - one by one
+	if(lanes == 1) {
+		for(i = 0; i < n; i++) {
+			sha3_init(&ctx, hash_size);
+			sha3_update(&ctx, (void *)message[i], msglen[i]);
+			sha3_final(&ctx, digest[i]);
+		}
+		return;
+	}
+
+	r = sha3x_rate(hash_size);
+	size = (200 - r) / 2;
+
+	memset(state, 0, sizeof(state));
+
+	// Fill the lanes by the first messages
+	for(l = next = active = 0; l < lanes; l++) {
+		lane[l].index = -1;
+
+		if(next < n) {
+			lane[l].message = message[next];
+			lane[l].msglen = msglen[next];
+			lane[l].index = next++;
+			lane[l].last = 0;
+			active++;
+		}
+	}
+
+	while(active > 0) {
+
+		// Absorb the next block of the every busy lane
+		for(l = 0; l < lanes; l++) {
+			if(lane[l].index < 0)
+				continue;
+
+			block = sha3x_block(&lane[l], r);
+
+			for(i = 0; i < r / 8; i++)
+				state[WORD(i) * lanes + l] ^= U8TO64_LITTLE((block + i * 8));
+		}
+
+#ifdef SHA3X_SIMD
+		if(lanes == 8)
+			sha3x_permute8(state);
+		else
+			sha3x_permute4(state);
+#endif
+
+		// Squeeze the hash of the finished lanes and take the next messages
+		for(l = 0; l < lanes; l++) {
+			if((lane[l].index < 0) || !lane[l].last)
+				continue;
+
+			for(i = j = 0; j < size; i++, j += 8) {
+				word = state[WORD(i) * lanes + l];
+
+				if(size - j >= 8) {
+					U64TO8_LITTLE((digest[lane[l].index] + j), word);
+				}
+				else {
+					U32TO8_LITTLE((digest[lane[l].index] + j), (uint32_t)word);
+				}
+			}
+
+			for(i = 0; i < 25; i++)
+				state[i * lanes + l] = 0;
+
+			lane[l].index = -1;
+			active--;
+
+			if(next < n) {
+				lane[l].message = message[next];
+				lane[l].msglen = msglen[next];
+				lane[l].index = next++;
+				lane[l].last = 0;
+				active++;
+			}
+		}
+	}
+}
+
+// SHA3x hash function
+void
+sha3x_hash(int hash_size, int n, const void *message[], const uint32_t msglen[], uint8_t *digest[])
+{
+	sha3x_hash_lanes(hash_size, n, message, msglen, digest, 0);
+}
@@ -0,0 +1,34 @@
+/*
+ * SHA3x - multi-buffer SHA3 (Keccak), 2008 year.
+ * Author SHA3 algorithm - Joan Daemen, Guido Bertoni, Michael Peeters and Gilles Van Assche.
+ * Independent messages are hashed in parallel 64-bit lanes:
+ * 8 lanes (AVX-512), 4 lanes (AVX2) or one by one (other processors).
+ * Hash size - 224, 256, 384, 512.
+*/
+
+#ifndef SHA3X_H
+#define SHA3X_H
+
+// Maximum number of the lanes
+#define SHA3X_MAX_LANES		8
+
+// Number of the lanes used on this processor (8, 4 or 1)
+int sha3x_lanes(void);
+
+/*
+ * SHA3x hash function
+ * hash_size - the size in bits of the hash (same for all messages)
+ * n - number of the messages
+ * message - array of n pointers of the messages
+ * msglen - array of n sizes in bytes of the messages, may be different
+ * digest - array of n pointers of the hashes
+ * Result is the same as sha3_init/sha3_update/sha3_final for every message.
+*/
+void sha3x_hash(int hash_size, int n, const void *message[], const uint32_t msglen[], uint8_t *digest[]);
+
+// SHA3x hash function of the limit of the lanes (8, 4, 1), 0 - all lanes of the processor
+// The kernels may be compared on one processor (tests)
+void sha3x_hash_lanes(int hash_size, int n, const void *message[], const uint32_t msglen[], uint8_t *digest[],
+		      int lanes);
+
+#endif /* SHA3X_H */
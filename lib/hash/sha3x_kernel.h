@@ -0,0 +1,104 @@
+/*
+ * SHA3x Keccak-f[1600] permutation kernel.
+ * The file is included by sha3x.c once per vector width, before including define:
+ * SHA3X_VEC - vector type of the 64-bit lanes
+ * SHA3X_LANES - number of the lanes in SHA3X_VEC
+ * SHA3X_PERMUTE - name of the permutation function
+ * State layout: state[25 * SHA3X_LANES], word i of lane l in state[i * SHA3X_LANES + l].
+*/
+
+// Cyclic left 64 bit shift of the all lanes
+#define VROTL64(v, n)	(((v) << (n)) | ((v) >> (64 - (n))))
+
+// Theta, rho and pi steps for one word: B[b] = ROTL64(A[a] ^ D[d], ROTATE[a])
+#define RHO_PI(a, b, d)	(B[b] = VROTL64((A[a] ^ D[d]), ROTATE[a]))
+
+// Chi step for one row
+#define CHI(i, j, k)	(A[i] = B[i] ^ (~B[j] & B[k]))
+
+static void
+SHA3X_PERMUTE(uint64_t *state)
+{
+	SHA3X_VEC A[25], B[25], C[5], D[5];
+	int i;
+
+	for(i = 0; i < 25; i++)
+		memcpy(&A[i], state + i * SHA3X_LANES, sizeof(SHA3X_VEC));
+
+	// SHA3 24 round
+	for(i = 0; i < 24; i++) {
+		C[0] = A[ 0] ^ A[ 1] ^ A[ 2] ^ A[ 3] ^ A[ 4];
+		C[1] = A[ 5] ^ A[ 6] ^ A[ 7] ^ A[ 8] ^ A[ 9];
+		C[2] = A[10] ^ A[11] ^ A[12] ^ A[13] ^ A[14];
+		C[3] = A[15] ^ A[16] ^ A[17] ^ A[18] ^ A[19];
+		C[4] = A[20] ^ A[21] ^ A[22] ^ A[23] ^ A[24];
+
+		D[0] = C[4] ^ VROTL64(C[1], 1);
+		D[1] = C[0] ^ VROTL64(C[2], 1);
+		D[2] = C[1] ^ VROTL64(C[3], 1);
+		D[3] = C[2] ^ VROTL64(C[4], 1);
+		D[4] = C[3] ^ VROTL64(C[0], 1);
+
+		// ROTATE[0] is zero, the shift by 64 is undefined
+		B[0] = A[0] ^ D[0];
+		RHO_PI( 1,  8, 0);
+		RHO_PI( 2, 11, 0);
+		RHO_PI( 3, 19, 0);
+		RHO_PI( 4, 22, 0);
+		RHO_PI( 5,  2, 1);
+		RHO_PI( 6,  5, 1);
+		RHO_PI( 7, 13, 1);
+		RHO_PI( 8, 16, 1);
+		RHO_PI( 9, 24, 1);
+		RHO_PI(10,  4, 2);
+		RHO_PI(11,  7, 2);
+		RHO_PI(12, 10, 2);
+		RHO_PI(13, 18, 2);
+		RHO_PI(14, 21, 2);
+		RHO_PI(15,  1, 3);
+		RHO_PI(16,  9, 3);
+		RHO_PI(17, 12, 3);
+		RHO_PI(18, 15, 3);
+		RHO_PI(19, 23, 3);
+		RHO_PI(20,  3, 4);
+		RHO_PI(21,  6, 4);
+		RHO_PI(22, 14, 4);
+		RHO_PI(23, 17, 4);
+		RHO_PI(24, 20, 4);
+
+		CHI( 0,  5, 10);
+		CHI( 1,  6, 11);
+		CHI( 2,  7, 12);
+		CHI( 3,  8, 13);
+		CHI( 4,  9, 14);
+		CHI( 5, 10, 15);
+		CHI( 6, 11, 16);
+		CHI( 7, 12, 17);
+		CHI( 8, 13, 18);
+		CHI( 9, 14, 19);
+		CHI(10, 15, 20);
+		CHI(11, 16, 21);
+		CHI(12, 17, 22);
+		CHI(13, 18, 23);
+		CHI(14, 19, 24);
+		CHI(15, 20,  0);
+		CHI(16, 21,  1);
+		CHI(17, 22,  2);
+		CHI(18, 23,  3);
+		CHI(19, 24,  4);
+		CHI(20,  0,  5);
+		CHI(21,  1,  6);
+		CHI(22,  2,  7);
+		CHI(23,  3,  8);
+		CHI(24,  4,  9);
+
+		A[0] ^= RC[i];
+	}
+
+	for(i = 0; i < 25; i++)
+		memcpy(state + i * SHA3X_LANES, &A[i], sizeof(SHA3X_VEC));
+}
+
+#undef VROTL64
+#undef RHO_PI
+#undef CHI
@@ -12,6 +12,8 @@
 
 #include "sha512.h"
 #include "../macro.h"
+#include "hash_state.h"
+#include "hash_trace.h"
 
 // Functions for the SHA512 algorithm
 #define CH(x, y, z)	((x & y) ^ ((~x) & z))
@@ -45,7 +47,7 @@
 const uint8_t sha512pad[128] = { 0x80 };
 
 // SHA512 80 constant
-static const uint64_t K[80] = { 
+static const uint64_t K[80] CACHE_ALIGNED = {
 	0x428A2F98D728AE22, 0x7137449123EF65CD, 0xB5C0FBCFEC4D3B2F, 0xE9B5DBA58189DBBC,
 	0x3956C25BF348B538, 0x59F111F1B605D019, 0x923F82A4AF194F9B, 0xAB1C5ED5DA6D8118,
 	0xD807AA98A3030242, 0x12835B0145706FBE, 0x243185BE4EE4B28C, 0x550C7DC3D5FFB4E2,
@@ -71,6 +73,8 @@ static const uint64_t K[80] = {
 void
 sha512_init(struct sha512_context *ctx)
 {
+	HASH_TRACE_ENTRY(init, HASH_TRACE_SHA512, 64, ctx);
+
 	memset(ctx, 0, sizeof(*ctx));
 
 	ctx->state[0] = 0x6A09E667F3BCC908;
@@ -81,6 +85,8 @@ sha512_init(struct sha512_context *ctx)
 	ctx->state[5] = 0x9B05688C2B3E6C1F;
 	ctx->state[6] = 0x1F83D9ABFB41BD6B;
 	ctx->state[7] = 0x5BE0CD19137E2179;
+
+	HASH_TRACE_RETURN(init, HASH_TRACE_SHA512, ctx);
 }
 
 // 32-byte array is transformed into 8-byte array
@@ -116,6 +122,7 @@ uint64_to_bytes(uint8_t *out, uint64_t *in, const int n)
 }
 
 // SHA512 hash function
+ESTREAM_CLONES
 static void
 sha512_hash(struct sha512_context *ctx, const uint8_t buffer[128])
 {
@@ -313,6 +320,8 @@ sha512_update(struct sha512_context *ctx, const void *message, uint32_t msglen)
 {
 	int n, len;
 
+	HASH_TRACE_ENTRY(update, HASH_TRACE_SHA512, msglen, ctx);
+
 	n = ctx->nbits[0] & 0x7F;
 
 	len = 128 - n;
@@ -324,28 +333,31 @@ sha512_update(struct sha512_context *ctx, const void *message, uint32_t msglen)
 	if(ctx->nbits[0] < msglen)
 		++ctx->nbits[1];
 
-	if(msglen >= len) {
-	
-		// Calculate hash
+	// Fill and hash the partial block left by the previous call
+	if((n > 0) && (msglen >= len)) {
 		memcpy(ctx->buffer + n, message, len);
 		message += len;
 		msglen -= len;
 
 		sha512_hash(ctx, ctx->buffer);
 
-		// Calculate hash of the remaining messages
+		n = 0;
+	}
+
+	// Calculate hash of the full blocks directly from the message
+	if(n == 0) {
 		while(msglen >= 128) {
 			sha512_hash(ctx, message);
 			message += 128;
 			msglen -= 128;
 		}
-
-		n = 0;
 	}
 
 	// Save message remaining bytes of the buffer
-	if(msglen >= 0)
+	if(msglen > 0)
 		memcpy(ctx->buffer + n, message, msglen);
+
+	HASH_TRACE_RETURN(update, HASH_TRACE_SHA512, ctx);
 }
 
 // Get the SHA512 hash of the message
@@ -357,6 +369,8 @@ sha512_final(struct sha512_context *ctx, uint8_t digest[64])
 	uint8_t nb[16];
 	int n, npad;
 
+	HASH_TRACE_ENTRY(final, HASH_TRACE_SHA512, 64, ctx);
+
 	n = ctx->nbits[0] & 0x7F;
 	npad = ((n < 112) ? 112 : 240) - n;
 
@@ -373,5 +387,37 @@ sha512_final(struct sha512_context *ctx, uint8_t digest[64])
 	sha512_update(ctx, nb, 16);
 
 	uint64_to_bytes(digest, ctx->state, 8);
+
+	HASH_TRACE_RETURN(final, HASH_TRACE_SHA512, ctx);
 }
 
+// Export the state of the incomplete message
+void
+sha512_export_state(const struct sha512_context *ctx, uint8_t state[SHA512_STATE_SIZE])
+{
+	uint8_t *p = state;
+
+	HASH_STATE_PUT_HEADER(p, "S512");
+	HASH_STATE_PUT32(p, ctx->nbits, 2);
+	HASH_STATE_PUT64(p, ctx->state, 8);
+	HASH_STATE_PUT_BYTES(p, ctx->buffer, 128);
+}
+
+// Import the state exported by sha512_export_state
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+sha512_import_state(struct sha512_context *ctx, const uint8_t state[SHA512_STATE_SIZE])
+{
+	const uint8_t *p = state;
+
+	if(!HASH_STATE_CHECK_HEADER(p, "S512"))
+		return -1;
+
+	p += HASH_STATE_HEADER;
+
+	HASH_STATE_GET32(p, ctx->nbits, 2);
+	HASH_STATE_GET64(p, ctx->state, 8);
+	HASH_STATE_GET_BYTES(p, ctx->buffer, 128);
+
+	return 0;
+}
@@ -7,6 +7,9 @@
 #ifndef SHA512_H
 #define SHA512_H
 
+// Size in bytes of the exported state
+#define SHA512_STATE_SIZE	208
+
 /*
  * SHA512 algorithm context
  * nbits - number bit of the input message
@@ -25,4 +28,11 @@ void sha512_update(struct sha512_context *ctx, const void *message, uint32_t msg
 
 void sha512_final(struct sha512_context *ctx, uint8_t digest[64]);
 
+// Export the state of the incomplete message (the context is not changed)
+void sha512_export_state(const struct sha512_context *ctx, uint8_t state[SHA512_STATE_SIZE]);
+
+// Import the state exported by sha512_export_state, then the message may be continued
+// Return value: 0 (if all is well), -1 (if the state is not SHA512 or the version is unknown)
+int sha512_import_state(struct sha512_context *ctx, const uint8_t state[SHA512_STATE_SIZE]);
+
 #endif /* SHA512_H */
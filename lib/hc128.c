@@ -17,6 +17,8 @@
 
 #include "hc128.h"
 #include "macro.h"
+#include "estream_stats.h"
+#include "estream_trace.h"
 
 #define HC128		16
 
@@ -176,20 +178,27 @@ hc128_initialization_process(struct hc128_context *ctx)
 
 // Fill the HC128 context (key and iv)
 // Return value: 0 (if all is well), -1 id all bad
-int
+ESTREAM_API int
 hc128_set_key_and_iv(struct hc128_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[16], const int ivlen)
 {
+	ESTREAM_TRACE_ENTRY(set_key, ESTREAM_STATS_HC128, keylen, ctx);
+	ESTREAM_STATS_BEGIN_SETUP(probe);
+
 	hc128_init(ctx);
 
 	if(keylen <= HC128)
 		ctx->keylen = keylen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_HC128, ctx, -1);
 		return -1;
+	}
 	
 	if((ivlen > 0) && (ivlen <= 16))
 		ctx->ivlen = ivlen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_HC128, ctx, -1);
 		return -1;
+	}
 	
 	memcpy(ctx->key, key, ctx->keylen);
 	memcpy(ctx->iv, iv, ctx->ivlen);
@@ -197,6 +206,9 @@ hc128_set_key_and_iv(struct hc128_context *ctx, const uint8_t *key, const int ke
 
 	hc128_initialization_process(ctx);
 
+	ESTREAM_STATS_SETUP(probe, ESTREAM_STATS_HC128);
+	ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_HC128, ctx, 0);
+
 	return 0;
 }
 
@@ -254,31 +266,35 @@ hc128_generate_keystream(struct hc128_context *ctx, uint32_t *keystream)
  * buflen - length the data buffer
  * out - pointer on output array
 */
-void
+ESTREAM_CLONES
+ESTREAM_API void
 hc128_crypt(struct hc128_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out)
 {
 	uint32_t keystream[16];
 	uint32_t i;
 
+	ESTREAM_TRACE_ENTRY(crypt, ESTREAM_STATS_HC128, buflen, ctx);
+	ESTREAM_STATS_BEGIN(probe, buflen);
+
 	for(; buflen >= 64; buflen -= 64, buf += 64, out += 64) {
 		hc128_generate_keystream(ctx, keystream);
 
-		*(uint32_t *)(out +  0) = *(uint32_t *)(buf +  0) ^ keystream[ 0];
-		*(uint32_t *)(out +  4) = *(uint32_t *)(buf +  4) ^ keystream[ 1];
-		*(uint32_t *)(out +  8) = *(uint32_t *)(buf +  8) ^ keystream[ 2];
-		*(uint32_t *)(out + 12) = *(uint32_t *)(buf + 12) ^ keystream[ 3];
-		*(uint32_t *)(out + 16) = *(uint32_t *)(buf + 16) ^ keystream[ 4];
-		*(uint32_t *)(out + 20) = *(uint32_t *)(buf + 20) ^ keystream[ 5];
-		*(uint32_t *)(out + 24) = *(uint32_t *)(buf + 24) ^ keystream[ 6];
-		*(uint32_t *)(out + 28) = *(uint32_t *)(buf + 28) ^ keystream[ 7];
-		*(uint32_t *)(out + 32) = *(uint32_t *)(buf + 32) ^ keystream[ 8];
-		*(uint32_t *)(out + 36) = *(uint32_t *)(buf + 36) ^ keystream[ 9];
-		*(uint32_t *)(out + 40) = *(uint32_t *)(buf + 40) ^ keystream[10];
-		*(uint32_t *)(out + 44) = *(uint32_t *)(buf + 44) ^ keystream[11];
-		*(uint32_t *)(out + 48) = *(uint32_t *)(buf + 48) ^ keystream[12];
-		*(uint32_t *)(out + 52) = *(uint32_t *)(buf + 52) ^ keystream[13];
-		*(uint32_t *)(out + 56) = *(uint32_t *)(buf + 56) ^ keystream[14];
-		*(uint32_t *)(out + 60) = *(uint32_t *)(buf + 60) ^ keystream[15];
+		STORE32(out +  0, LOAD32(buf +  0) ^ keystream[ 0]);
+		STORE32(out +  4, LOAD32(buf +  4) ^ keystream[ 1]);
+		STORE32(out +  8, LOAD32(buf +  8) ^ keystream[ 2]);
+		STORE32(out + 12, LOAD32(buf + 12) ^ keystream[ 3]);
+		STORE32(out + 16, LOAD32(buf + 16) ^ keystream[ 4]);
+		STORE32(out + 20, LOAD32(buf + 20) ^ keystream[ 5]);
+		STORE32(out + 24, LOAD32(buf + 24) ^ keystream[ 6]);
+		STORE32(out + 28, LOAD32(buf + 28) ^ keystream[ 7]);
+		STORE32(out + 32, LOAD32(buf + 32) ^ keystream[ 8]);
+		STORE32(out + 36, LOAD32(buf + 36) ^ keystream[ 9]);
+		STORE32(out + 40, LOAD32(buf + 40) ^ keystream[10]);
+		STORE32(out + 44, LOAD32(buf + 44) ^ keystream[11]);
+		STORE32(out + 48, LOAD32(buf + 48) ^ keystream[12]);
+		STORE32(out + 52, LOAD32(buf + 52) ^ keystream[13]);
+		STORE32(out + 56, LOAD32(buf + 56) ^ keystream[14]);
+		STORE32(out + 60, LOAD32(buf + 60) ^ keystream[15]);
 	}
 	
 	if(buflen) {
@@ -287,10 +303,13 @@ hc128_crypt(struct hc128_context *ctx, const uint8_t *buf, uint32_t buflen, uint
 		for(i = 0; i < buflen; i++)
 			out[i] = buf[i] ^ ((uint8_t *)keystream)[i];
 	}
+
+	ESTREAM_STATS_CRYPT(probe, ESTREAM_STATS_HC128, 64);
+	ESTREAM_TRACE_RETURN(crypt, ESTREAM_STATS_HC128, ctx, 0);
 }
 
 // Test vectors print
-void
+ESTREAM_API void
 hc128_test_vectors(struct hc128_context *ctx)
 {
 	uint32_t keystream[16];
@@ -7,6 +7,8 @@
 #ifndef HC128_H
 #define HC128_H
 
+#include "estream_inline.h"
+
 /* 
  * HC128 context
  * keylen - chiper key length in bytes
@@ -29,10 +31,14 @@ struct hc128_context {
 	uint32_t counter;
 };
 
-int hc128_set_key_and_iv(struct hc128_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[16], const int ivlen);
+ESTREAM_API int hc128_set_key_and_iv(struct hc128_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[16], const int ivlen);
+
+ESTREAM_API void hc128_crypt(struct hc128_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
 
-void hc128_crypt(struct hc128_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
+ESTREAM_API void hc128_test_vectors(struct hc128_context *ctx);
 
-void hc128_test_vectors(struct hc128_context *ctx);
+#ifdef ESTREAM_INLINE
+#include "hc128.c"
+#endif
 
 #endif
@@ -86,7 +86,10 @@
 }
 
 // Selecting byte order 4-bytes
-#if __BYTE_ORDER == __BIG_ENDIAN
+// GCC 4.3 and later: one bswap (wsbh and rotr of the MIPS32r2) instead of the shifts and masks
+#if (__BYTE_ORDER == __BIG_ENDIAN) && defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 3)))
+#define U32TO32(x)	__builtin_bswap32(x)
+#elif __BYTE_ORDER == __BIG_ENDIAN
 #define U32TO32(x) \
 	((x << 24) | ((x << 8) & 0xFF0000) | ((x >> 8) & 0xFF00) | (x >> 24))
 #elif __BYTE_ORDER == __LITTLE_ENDIAN
@@ -95,6 +98,17 @@
 #error unsupported byte order
 #endif
 
+// 32-bit word of the unaligned buffer in the byte order of the processor:
+// one load (store) on x86, lwl/lwr (swl/swr) on MIPS instead of the trap of the misaligned address
+#ifdef __GNUC__
+typedef uint32_t u32_unaligned __attribute__((aligned(1), may_alias));
+#define LOAD32(p)	(*(const u32_unaligned *)(p))
+#define STORE32(p, x)	(*(u32_unaligned *)(p) = (x))
+#else
+#define LOAD32(p)	(*(const uint32_t *)(p))
+#define STORE32(p, x)	(*(uint32_t *)(p) = (x))
+#endif
+
 // Print 32-bit
 #if __BYTE_ORDER == __BIG_ENDIAN
 #define PRINT_U32TO32(x) \
@@ -116,4 +130,21 @@
 #define SHL(v, n)	((v) << n)
 #define SHR(v, n)	((v) >> n)
 
+// Table of the constants on the cache line boundary: the lookups of the table do not cross the lines.
+// The tables are static const (.rodata): the pages are shared by the processes and never written
+#ifdef __GNUC__
+#define CACHE_ALIGNED	__attribute__((aligned(64)))
+#else
+#define CACHE_ALIGNED
+#endif
+
+// Hot kernel compiled for the every x86-64 level (ESTREAM_MULTIVERSION, CMake build),
+// the version of the processor is selected by the dynamic loader (ifunc).
+// The inline mode (ESTREAM_INLINE) has no clones: the kernel is inlined to the caller
+#if defined(ESTREAM_MULTIVERSION) && !defined(ESTREAM_INLINE) && defined(__GNUC__) && defined(__x86_64__)
+#define ESTREAM_CLONES	__attribute__((target_clones("default", "arch=x86-64-v2", "arch=x86-64-v3", "arch=x86-64-v4")))
+#else
+#define ESTREAM_CLONES
+#endif
+
 #endif
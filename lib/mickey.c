@@ -16,29 +16,32 @@
 #include <string.h>
 
 #include "mickey.h"
+#include "macro.h"
+#include "estream_stats.h"
+#include "estream_trace.h"
 
 // MICKEY 2.0 key length in bytes
 #define MICKEY		10
 
 // Feedback mask associated with the register R
-uint32_t R_MASK[4] = { 0x1279327B, 0xB5546660,
-		       0xDF87818F, 0x00000003 };
+static const uint32_t R_MASK[4] = { 0x1279327B, 0xB5546660,
+				    0xDF87818F, 0x00000003 };
 
 // Input mask associated with register S
-uint32_t COMP0[4] = { 0x6AA97A30, 0x7942A809, 
-		      0x057EBFEA, 0x00000006 };
+static const uint32_t COMP0[4] = { 0x6AA97A30, 0x7942A809,
+				   0x057EBFEA, 0x00000006 };
 
 // Second input mask associated with register S
-uint32_t COMP1[4] = { 0xDD629E9A, 0xE3A21D63, 
-		      0x91C23DD7, 0x00000001 };
+static const uint32_t COMP1[4] = { 0xDD629E9A, 0xE3A21D63,
+				   0x91C23DD7, 0x00000001 };
 
 // Feedback mask associated with the register S for clock control_bit = 0
-uint32_t S_MASK0[4] = { 0x9FFA7FAF, 0xAF4A9381,
-			0x9CEC5802, 0x00000001 };
+static const uint32_t S_MASK0[4] = { 0x9FFA7FAF, 0xAF4A9381,
+				     0x9CEC5802, 0x00000001 };
 
 // Feedback mask associated with the register S for clock control_bit = 1
-uint32_t S_MASK1[4] = { 0x4C8CB877, 0x4911B063,
-			0x40FBC52B, 0x00000008 };
+static const uint32_t S_MASK1[4] = { 0x4C8CB877, 0x4911B063,
+				     0x40FBC52B, 0x00000008 };
 
 
 // Mickey initialization function
@@ -155,27 +158,37 @@ mickey_key_setup(struct mickey_context *ctx)
 
 // Fill the mickey_context (key and iv)
 // Return value: 0 (if all is well), -1 (is all bad)
-int
+ESTREAM_API int
 mickey_set_key_and_iv(struct mickey_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[10], const int ivlen)
 {
+	ESTREAM_TRACE_ENTRY(set_key, ESTREAM_STATS_MICKEY, keylen, ctx);
+	ESTREAM_STATS_BEGIN_SETUP(probe);
+
 	mickey_init(ctx);
 
 	if((keylen > 0) && (keylen <= MICKEY))
 		
 		ctx->keylen = keylen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_MICKEY, ctx, -1);
 		return -1;
+	}
 	
 	if((ivlen > 0) && (ivlen <= 10))
 		ctx->ivlen = ivlen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_MICKEY, ctx, -1);
 		return -1;
+	}
 	
 	memcpy(ctx->key, key, keylen);
 	memcpy(ctx->iv, iv, 10);
 
 	mickey_key_setup(ctx);
 
+	ESTREAM_STATS_SETUP(probe, ESTREAM_STATS_MICKEY);
+	ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_MICKEY, ctx, 0);
+
 	return 0;
 }
 
@@ -186,12 +199,16 @@ mickey_set_key_and_iv(struct mickey_context *ctx, const uint8_t *key, const int
  * buflen - length the data buffer
  * out - pointer on output 
 */
-void
+ESTREAM_CLONES
+ESTREAM_API void
 mickey_crypt(struct mickey_context *ctx, const uint8_t *buf, const uint32_t buflen, uint8_t *out)
 {
 	uint32_t i, j;
 	int keystream;
 
+	ESTREAM_TRACE_ENTRY(crypt, ESTREAM_STATS_MICKEY, buflen, ctx);
+	ESTREAM_STATS_BEGIN(probe, buflen);
+
 	for(i = 0; i < buflen; i++) {
 		out[i] = buf[i];
 
@@ -201,10 +218,13 @@ mickey_crypt(struct mickey_context *ctx, const uint8_t *buf, const uint32_t bufl
 			out[i] ^= keystream;
 		}
 	}
+
+	ESTREAM_STATS_CRYPT(probe, ESTREAM_STATS_MICKEY, 1);
+	ESTREAM_TRACE_RETURN(crypt, ESTREAM_STATS_MICKEY, ctx, 0);
 }
 
 // Test vectors print
-void
+ESTREAM_API void
 mickey_test_vectors(struct mickey_context *ctx)
 {
 	uint32_t i, j;
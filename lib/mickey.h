@@ -7,6 +7,8 @@
 #ifndef MICKEY_H
 #define MICKEY_H
 
+#include "estream_inline.h"
+
 /*
  * MICKEY 2.0 context
  * keylen - chiper key length in bytes
@@ -25,10 +27,14 @@ struct mickey_context {
 	uint32_t s[4];
 };
 
-int mickey_set_key_and_iv(struct mickey_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[10], const int ivlen);
+ESTREAM_API int mickey_set_key_and_iv(struct mickey_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[10], const int ivlen);
+
+ESTREAM_API void mickey_crypt(struct mickey_context *ctx, const uint8_t *buf, const uint32_t buflen, uint8_t *out);
 
-void mickey_crypt(struct mickey_context *ctx, const uint8_t *buf, const uint32_t buflen, uint8_t *out);
+ESTREAM_API void mickey_test_vectors(struct mickey_context *ctx);
 
-void mickey_test_vectors(struct mickey_context *ctx);
+#ifdef ESTREAM_INLINE
+#include "mickey.c"
+#endif
 
 #endif
@@ -18,6 +18,9 @@
 
 #include "rabbit.h"
 #include "macro.h"
+#include "estream_simd.h"
+#include "estream_stats.h"
+#include "estream_trace.h"
 
 #define RABBIT	16
 
@@ -66,6 +69,25 @@ rabbit_next_state(struct rabbit_context *ctx)
 	ctx->c[7] = ctx->c[7] + A7 + (ctx->c[6] < c_old[6]);
 	ctx->carry = (ctx->c[7] < c_old[7]);
 	
+#ifdef ESTREAM_SIMD
+	if(estream_simd()) {
+		v4u32 x[2], c[2], a, b, h;
+
+		// G-func of the 8 words: 2 vectors of the 4 lanes
+		memcpy(x, ctx->x, sizeof(x));
+		memcpy(c, ctx->c, sizeof(c));
+
+		for(i = 0; i < 2; i++) {
+			x[i] += c[i];
+			a = x[i] & 0xFFFF;
+			b = x[i] >> 16;
+			h = ((((a * a) >> 17) + (a * b)) >> 15) + b * b;
+			x[i] = h ^ (x[i] * x[i]);
+		}
+
+		memcpy(g, x, sizeof(g));
+	} else
+#endif
 	for(i = 0; i < 8; i++)
 		G_FUNC((ctx->x[i] + ctx->c[i]), g[i]);
 
@@ -105,10 +127,10 @@ rabbit_key_setup(struct rabbit_context *ctx)
 	ctx->c[2] = (k3 << 16) | (k3 >> 16);
 	ctx->c[4] = (k0 << 16) | (k0 >> 16);
 	ctx->c[6] = (k1 << 16) | (k1 >> 16);
-	ctx->c[1] = (k0 >> 16) | (k1 << 16);
-	ctx->c[3] = (k1 >> 16) | (k2 << 16);
-	ctx->c[5] = (k2 >> 16) | (k3 << 16);
-	ctx->c[7] = (k3 >> 16) | (k0 << 16);
+	ctx->c[1] = (k0 & 0xFFFF0000) | (k1 & 0xFFFF);
+	ctx->c[3] = (k1 & 0xFFFF0000) | (k2 & 0xFFFF);
+	ctx->c[5] = (k2 & 0xFFFF0000) | (k3 & 0xFFFF);
+	ctx->c[7] = (k3 & 0xFFFF0000) | (k0 & 0xFFFF);
 	
 	ctx->carry = 0;
 
@@ -147,20 +169,27 @@ rabbit_iv_setup(struct rabbit_context *ctx)
 
 // Fill the rabbit context (key and iv)
 // Return value: 0 (if all is well), -1 (if all bad) 
-int
+ESTREAM_API int
 rabbit_set_key_and_iv(struct rabbit_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[8], const int ivlen)
 {
+	ESTREAM_TRACE_ENTRY(set_key, ESTREAM_STATS_RABBIT, keylen, ctx);
+	ESTREAM_STATS_BEGIN_SETUP(probe);
+
 	rabbit_init(ctx);
 	
 	if((keylen > 0) && (keylen <= RABBIT))
 		ctx->keylen = keylen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_RABBIT, ctx, -1);
 		return -1;
+	}
 	
 	if((ivlen > 0) && (ivlen <= 8))
 		ctx->ivlen = ivlen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_RABBIT, ctx, -1);
 		return -1;
+	}
 	
 	memcpy(ctx->key, key, ctx->keylen);
 	memcpy(ctx->iv, iv, ctx->ivlen);
@@ -169,6 +198,9 @@ rabbit_set_key_and_iv(struct rabbit_context *ctx, const uint8_t *key, const int
 	rabbit_key_setup(ctx);
 	rabbit_iv_setup(ctx);
 
+	ESTREAM_STATS_SETUP(probe, ESTREAM_STATS_RABBIT);
+	ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_RABBIT, ctx, 0);
+
 	return 0;
 }
 
@@ -179,23 +211,27 @@ rabbit_set_key_and_iv(struct rabbit_context *ctx, const uint8_t *key, const int
  * buflen - length the data buffer
  * out - pointer on output array
 */
-void
+ESTREAM_CLONES
+ESTREAM_API void
 rabbit_crypt(struct rabbit_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out)
 {
 	uint32_t keystream[4];
 	uint32_t i;
 	
+	ESTREAM_TRACE_ENTRY(crypt, ESTREAM_STATS_RABBIT, buflen, ctx);
+	ESTREAM_STATS_BEGIN(probe, buflen);
+
 	for(; buflen >= 16; buflen -= 16, buf += 16, out += 16) {
 		rabbit_next_state(ctx);
 
-		*(uint32_t *)(out +  0) = *(uint32_t *)(buf +  0) ^ U32TO32((ctx->x[0] ^
-			(ctx->x[5] >> 16) ^ (ctx->x[3] << 16)));
-		*(uint32_t *)(out +  4) = *(uint32_t *)(buf +  4) ^ U32TO32((ctx->x[2] ^
-			(ctx->x[7] >> 16) ^ (ctx->x[5] << 16)));
-		*(uint32_t *)(out +  8) = *(uint32_t *)(buf +  8) ^ U32TO32((ctx->x[4] ^
-			(ctx->x[1] >> 16) ^ (ctx->x[7] << 16)));
-		*(uint32_t *)(out + 12) = *(uint32_t *)(buf + 12) ^ U32TO32((ctx->x[6] ^ 
-			(ctx->x[3] >> 16) ^ (ctx->x[1] << 16)));
+		STORE32(out +  0, LOAD32(buf +  0) ^ U32TO32((ctx->x[0] ^
+			(ctx->x[5] >> 16) ^ (ctx->x[3] << 16))));
+		STORE32(out +  4, LOAD32(buf +  4) ^ U32TO32((ctx->x[2] ^
+			(ctx->x[7] >> 16) ^ (ctx->x[5] << 16))));
+		STORE32(out +  8, LOAD32(buf +  8) ^ U32TO32((ctx->x[4] ^
+			(ctx->x[1] >> 16) ^ (ctx->x[7] << 16))));
+		STORE32(out + 12, LOAD32(buf + 12) ^ U32TO32((ctx->x[6] ^ 
+			(ctx->x[3] >> 16) ^ (ctx->x[1] << 16))));
 	}
 	
 	if(buflen) {
@@ -209,10 +245,13 @@ rabbit_crypt(struct rabbit_context *ctx, const uint8_t *buf, uint32_t buflen, ui
 		for(i = 0; i < buflen; i++)
 			out[i] = buf[i] ^ ((uint8_t *)keystream)[i];	
 	}
+
+	ESTREAM_STATS_CRYPT(probe, ESTREAM_STATS_RABBIT, 16);
+	ESTREAM_TRACE_RETURN(crypt, ESTREAM_STATS_RABBIT, ctx, 0);
 }
 
 // Test vectors print
-void
+ESTREAM_API void
 rabbit_test_vectors(struct rabbit_context *ctx)
 {
 	uint32_t keystream[4];
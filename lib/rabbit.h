@@ -8,6 +8,8 @@
 #ifndef RABBIT_H
 #define RABBIT_H
 
+#include "estream_inline.h"
+
 /* 
  * RABBIT-128 context
  * keylen - chiper key length in bytes
@@ -28,10 +30,14 @@ struct rabbit_context {
 	uint32_t carry;
 };
 
-int rabbit_set_key_and_iv(struct rabbit_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[8], const int ivlen);
+ESTREAM_API int rabbit_set_key_and_iv(struct rabbit_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[8], const int ivlen);
+
+ESTREAM_API void rabbit_crypt(struct rabbit_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
 
-void rabbit_crypt(struct rabbit_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
+ESTREAM_API void rabbit_test_vectors(struct rabbit_context *ctx);
 
-void rabbit_test_vectors(struct rabbit_context *ctx);
+#ifdef ESTREAM_INLINE
+#include "rabbit.c"
+#endif
 
 #endif
@@ -20,6 +20,9 @@
 
 #include "salsa.h"
 #include "macro.h"
+#include "estream_simd.h"
+#include "estream_stats.h"
+#include "estream_trace.h"
 
 #define SALSA16		16
 #define	SALSA32		32
@@ -33,7 +36,7 @@ salsa_init(struct salsa_context *ctx)
 
 // Fill the salsa context (key and iv)
 // Return value: 0 (if all is well), -1 (if all bad)
-int
+ESTREAM_API int
 salsa_set_key_and_iv(struct salsa_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[8], const int ivlen)
 {
 	int i, j;
@@ -53,6 +56,9 @@ salsa_set_key_and_iv(struct salsa_context *ctx, const uint8_t *key, const int ke
 		't', 'e', ' ', 'k'
 	};
 
+	ESTREAM_TRACE_ENTRY(set_key, ESTREAM_STATS_SALSA, keylen, ctx);
+	ESTREAM_STATS_BEGIN_SETUP(probe);
+
 	salsa_init(ctx);
 
 	if(keylen == SALSA32) {
@@ -65,13 +71,17 @@ salsa_set_key_and_iv(struct salsa_context *ctx, const uint8_t *key, const int ke
 		expand = (uint8_t *)key_expand_16;
 		j = 0;
 	}
-	else
-	     	return -1;
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_SALSA, ctx, -1);
+		return -1;
+	}
 
 	if((ivlen > 0) && (ivlen <= 8))
 		ctx->ivlen = ivlen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_SALSA, ctx, -1);
 		return -1;
+	}
 
 	memcpy(ctx->key, key, ctx->keylen);
 
@@ -89,6 +99,9 @@ salsa_set_key_and_iv(struct salsa_context *ctx, const uint8_t *key, const int ke
 		ctx->x[i + 11] = U8TO32_LITTLE((ctx->key + ((j + i) * 4)));
 	}
 
+	ESTREAM_STATS_SETUP(probe, ESTREAM_STATS_SALSA);
+	ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_SALSA, ctx, 0);
+
 	return 0;
 }
 
@@ -148,18 +161,94 @@ salsa20(struct salsa_context *ctx, uint32_t *keystream)
 		keystream[i] = U32TO32((z[i] + ctx->x[i]));
 }
 
+#ifdef ESTREAM_SIMD
+// Quarter-round of the 4 blocks in the lanes
+#define VQUARTER(a, b, c, d) {			\
+	z[b] ^= VROTL32((z[a] + z[d]), 7);	\
+	z[c] ^= VROTL32((z[b] + z[a]), 9);	\
+	z[d] ^= VROTL32((z[c] + z[b]), 13);	\
+	z[a] ^= VROTL32((z[d] + z[c]), 18);	\
+}
+
+// Salsa hash function of the 4 blocks (counters x[8], x[9] + 0, 1, 2, 3), the lane is the block
+// keystream - 4 blocks one after another
+static void
+salsa20_x4(struct salsa_context *ctx, uint32_t keystream[64])
+{
+	v4u32 x[16], z[16], t[4], r[4];
+	uint32_t lo = ctx->x[8], hi = ctx->x[9];
+	int i, j;
+
+	for(i = 0; i < 16; i++)
+		x[i] = (v4u32){ ctx->x[i], ctx->x[i], ctx->x[i], ctx->x[i] };
+
+	x[8] = (v4u32){ lo, lo + 1, lo + 2, lo + 3 };
+	x[9] = (v4u32){ hi, hi + (lo + 1 < lo), hi + (lo + 2 < lo), hi + (lo + 3 < lo) };
+
+	for(i = 0; i < 16; i++)
+		z[i] = x[i];
+
+	for(i = 0; i < 10; i++) {
+		VQUARTER( 0,  4,  8, 12);
+		VQUARTER( 5,  9, 13,  1);
+		VQUARTER(10, 14,  2,  6);
+		VQUARTER(15,  3,  7, 11);
+
+		VQUARTER( 0,  1,  2,  3);
+		VQUARTER( 5,  6,  7,  4);
+		VQUARTER(10, 11,  8,  9);
+		VQUARTER(15, 12, 13, 14);
+	}
+
+	// Transpose of the 4 words of the 4 blocks: r[j] - the words i..i+3 of the block j
+	for(i = 0; i < 16; i += 4) {
+		t[0] = __builtin_shuffle(z[i] + x[i], z[i + 1] + x[i + 1], (v4u32){ 0, 4, 1, 5 });
+		t[1] = __builtin_shuffle(z[i] + x[i], z[i + 1] + x[i + 1], (v4u32){ 2, 6, 3, 7 });
+		t[2] = __builtin_shuffle(z[i + 2] + x[i + 2], z[i + 3] + x[i + 3], (v4u32){ 0, 4, 1, 5 });
+		t[3] = __builtin_shuffle(z[i + 2] + x[i + 2], z[i + 3] + x[i + 3], (v4u32){ 2, 6, 3, 7 });
+
+		r[0] = __builtin_shuffle(t[0], t[2], (v4u32){ 0, 1, 4, 5 });
+		r[1] = __builtin_shuffle(t[0], t[2], (v4u32){ 2, 3, 6, 7 });
+		r[2] = __builtin_shuffle(t[1], t[3], (v4u32){ 0, 1, 4, 5 });
+		r[3] = __builtin_shuffle(t[1], t[3], (v4u32){ 2, 3, 6, 7 });
+
+		for(j = 0; j < 4; j++)
+			memcpy(keystream + 16 * j + i, &r[j], 16);
+	}
+
+	ctx->x[8] = lo + 4;
+
+	if(ctx->x[8] < lo)
+		ctx->x[9] += 1;
+}
+#endif /* ESTREAM_SIMD */
+
 /* 
  * Salsa encrypt algorithm.
  * ctx - pointer on salsa context
  * buf - pointer on buffer data
  * buflen - length the data buffer
 */
-void
+ESTREAM_CLONES
+ESTREAM_API void
 salsa_crypt(struct salsa_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out)
 {
-	uint32_t keystream[16];
+	uint32_t keystream[64];
 	uint32_t i;
 	
+	ESTREAM_TRACE_ENTRY(crypt, ESTREAM_STATS_SALSA, buflen, ctx);
+	ESTREAM_STATS_BEGIN(probe, buflen);
+
+#ifdef ESTREAM_SIMD
+	// 4 blocks at a time in the vector lanes
+	if((buflen >= 256) && estream_simd()) {
+		for(; buflen >= 256; buflen -= 256, buf += 256, out += 256) {
+			salsa20_x4(ctx, keystream);
+			estream_xor(out, buf, (uint8_t *)keystream, 256);
+		}
+	}
+#endif
+
 	for(; buflen >= 64; buflen -= 64, buf += 64, out += 64) {
 		salsa20(ctx, keystream);
 		
@@ -168,22 +257,22 @@ salsa_crypt(struct salsa_context *ctx, const uint8_t *buf, uint32_t buflen, uint
 		if(!ctx->x[8])
 			ctx->x[9] += 1;
 
-		*(uint32_t *)(out +  0) = *(uint32_t *)(buf +  0) ^ keystream[ 0];
-		*(uint32_t *)(out +  4) = *(uint32_t *)(buf +  4) ^ keystream[ 1];
-		*(uint32_t *)(out +  8) = *(uint32_t *)(buf +  8) ^ keystream[ 2];
-		*(uint32_t *)(out + 12) = *(uint32_t *)(buf + 12) ^ keystream[ 3];
-		*(uint32_t *)(out + 16) = *(uint32_t *)(buf + 16) ^ keystream[ 4];
-		*(uint32_t *)(out + 20) = *(uint32_t *)(buf + 20) ^ keystream[ 5];
-		*(uint32_t *)(out + 24) = *(uint32_t *)(buf + 24) ^ keystream[ 6];
-		*(uint32_t *)(out + 28) = *(uint32_t *)(buf + 28) ^ keystream[ 7];
-		*(uint32_t *)(out + 32) = *(uint32_t *)(buf + 32) ^ keystream[ 8];
-		*(uint32_t *)(out + 36) = *(uint32_t *)(buf + 36) ^ keystream[ 9];
-		*(uint32_t *)(out + 40) = *(uint32_t *)(buf + 40) ^ keystream[10];
-		*(uint32_t *)(out + 44) = *(uint32_t *)(buf + 44) ^ keystream[11];
-		*(uint32_t *)(out + 48) = *(uint32_t *)(buf + 48) ^ keystream[12];
-		*(uint32_t *)(out + 52) = *(uint32_t *)(buf + 52) ^ keystream[13];
-		*(uint32_t *)(out + 56) = *(uint32_t *)(buf + 56) ^ keystream[14];
-		*(uint32_t *)(out + 60) = *(uint32_t *)(buf + 60) ^ keystream[15];
+		STORE32(out +  0, LOAD32(buf +  0) ^ keystream[ 0]);
+		STORE32(out +  4, LOAD32(buf +  4) ^ keystream[ 1]);
+		STORE32(out +  8, LOAD32(buf +  8) ^ keystream[ 2]);
+		STORE32(out + 12, LOAD32(buf + 12) ^ keystream[ 3]);
+		STORE32(out + 16, LOAD32(buf + 16) ^ keystream[ 4]);
+		STORE32(out + 20, LOAD32(buf + 20) ^ keystream[ 5]);
+		STORE32(out + 24, LOAD32(buf + 24) ^ keystream[ 6]);
+		STORE32(out + 28, LOAD32(buf + 28) ^ keystream[ 7]);
+		STORE32(out + 32, LOAD32(buf + 32) ^ keystream[ 8]);
+		STORE32(out + 36, LOAD32(buf + 36) ^ keystream[ 9]);
+		STORE32(out + 40, LOAD32(buf + 40) ^ keystream[10]);
+		STORE32(out + 44, LOAD32(buf + 44) ^ keystream[11]);
+		STORE32(out + 48, LOAD32(buf + 48) ^ keystream[12]);
+		STORE32(out + 52, LOAD32(buf + 52) ^ keystream[13]);
+		STORE32(out + 56, LOAD32(buf + 56) ^ keystream[14]);
+		STORE32(out + 60, LOAD32(buf + 60) ^ keystream[15]);
 	}
 
 	if(buflen > 0) {
@@ -198,10 +287,12 @@ salsa_crypt(struct salsa_context *ctx, const uint8_t *buf, uint32_t buflen, uint
 			out[i] = buf[i] ^ ((uint8_t *)keystream)[i];
 	}
 
+	ESTREAM_STATS_CRYPT(probe, ESTREAM_STATS_SALSA, 64);
+	ESTREAM_TRACE_RETURN(crypt, ESTREAM_STATS_SALSA, ctx, 0);
 }
 
 // Salsa test vectors
-void
+ESTREAM_API void
 salsa_test_vectors(struct salsa_context *ctx)
 {
 	uint32_t keystream[16];
@@ -7,6 +7,8 @@
 #ifndef SALSA_H
 #define SALSA_H
 
+#include "estream_inline.h"
+
 /* 
  * Salsa context
  * keylen - chiper key length in bytes
@@ -23,10 +25,14 @@ struct salsa_context {
 	uint32_t x[16];
 };
 
-int salsa_set_key_and_iv(struct salsa_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[8], const int ivlen);
+ESTREAM_API int salsa_set_key_and_iv(struct salsa_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[8], const int ivlen);
+
+ESTREAM_API void salsa_crypt(struct salsa_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
 
-void salsa_crypt(struct salsa_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
+ESTREAM_API void salsa_test_vectors(struct salsa_context *ctx);
 
-void salsa_test_vectors(struct salsa_context *ctx);
+#ifdef ESTREAM_INLINE
+#include "salsa.c"
+#endif
 
 #endif
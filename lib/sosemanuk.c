@@ -18,6 +18,8 @@
 
 #include "sosemanuk.h"
 #include "macro.h"
+#include "estream_stats.h"
+#include "estream_trace.h"
 
 // Maximum Sosemanuk key length in bytes
 #define SOSEMANUK	32
@@ -254,7 +256,7 @@
 }
 
 // Multiplication by alpha: alpha * x = (x << 8) ^ mul_a[x >> 24]
-uint32_t mul_a[] = {
+static const uint32_t mul_a[] CACHE_ALIGNED = {
 	0x00000000, 0xE19FCF13, 0x6B973726, 0x8A08F835,
 	0xD6876E4C, 0x3718A15F, 0xBD10596A, 0x5C8F9679,
 	0x05A7DC98, 0xE438138B, 0x6E30EBBE, 0x8FAF24AD,
@@ -322,7 +324,7 @@ uint32_t mul_a[] = {
 };
 
 // Multiplication by 1/alpha: 1/alpha * x = (x >> 8) ^ mul_ia[x & 0xFF]
-uint32_t mul_ia[] = {
+static const uint32_t mul_ia[] CACHE_ALIGNED = {
 	0x00000000, 0x180F40CD, 0x301E8033, 0x2811C0FE,
 	0x603CA966, 0x7833E9AB, 0x50222955, 0x482D6998,
 	0xC078FBCC, 0xD877BB01, 0xF0667BFF, 0xE8693B32,
@@ -499,26 +501,40 @@ sosemanuk_keysetup(struct sosemanuk_context *ctx)
 
 // Fill the sosemanuk_context (key and iv)
 // Return value: 0 (if all is well), -1 (is all bad)
-int
+ESTREAM_API int
 sosemanuk_set_key_and_iv(struct sosemanuk_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[16], const int ivlen)
 {
+	ESTREAM_TRACE_ENTRY(set_key, ESTREAM_STATS_SOSEMANUK, keylen, ctx);
+	ESTREAM_STATS_BEGIN_SETUP(probe);
+
 	sosemanuk_init(ctx);
 
 	if((keylen > 0) && (keylen <= SOSEMANUK))
 		ctx->keylen = keylen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_SOSEMANUK, ctx, -1);
 		return -1;
+	}
 	
 	if((ivlen > 0) && (ivlen <= 16))
 		ctx->ivlen = ivlen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_SOSEMANUK, ctx, -1);
 		return -1;
+	}
 	
 	memcpy(ctx->key, key, ctx->keylen);
 	memcpy(ctx->iv, iv, ctx->ivlen);
+
+	// The key shorter than 256 bits is padded as the key of the Serpent: the bit 1, then zeros
+	if(ctx->keylen < SOSEMANUK)
+		ctx->key[ctx->keylen] = 0x01;
 	
 	sosemanuk_keysetup(ctx);
 
+	ESTREAM_STATS_SETUP(probe, ESTREAM_STATS_SOSEMANUK);
+	ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_SOSEMANUK, ctx, 0);
+
 	return 0;
 }
 
@@ -598,35 +614,39 @@ sosemanuk_generate_keystream(struct sosemanuk_context *ctx, uint32_t *keystream)
  * buflen - length the data buffer
  * out - pointer on output
 */
-void
+ESTREAM_CLONES
+ESTREAM_API void
 sosemanuk_crypt(struct sosemanuk_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out)
 {
 	uint32_t keystream[20];
 	uint32_t i;
 
+	ESTREAM_TRACE_ENTRY(crypt, ESTREAM_STATS_SOSEMANUK, buflen, ctx);
+	ESTREAM_STATS_BEGIN(probe, buflen);
+
 	for(; buflen >= 80; buflen -= 80, buf += 80, out += 80) {
 		sosemanuk_generate_keystream(ctx, keystream);
 		
-		*(uint32_t *)(out +  0) = *(uint32_t *)(buf +  0) ^ keystream[ 0];
-		*(uint32_t *)(out +  4) = *(uint32_t *)(buf +  4) ^ keystream[ 1];
-		*(uint32_t *)(out +  8) = *(uint32_t *)(buf +  8) ^ keystream[ 2];
-		*(uint32_t *)(out + 12) = *(uint32_t *)(buf + 12) ^ keystream[ 3];
-		*(uint32_t *)(out + 16) = *(uint32_t *)(buf + 16) ^ keystream[ 4];
-		*(uint32_t *)(out + 20) = *(uint32_t *)(buf + 20) ^ keystream[ 5];
-		*(uint32_t *)(out + 24) = *(uint32_t *)(buf + 24) ^ keystream[ 6];
-		*(uint32_t *)(out + 28) = *(uint32_t *)(buf + 28) ^ keystream[ 7];
-		*(uint32_t *)(out + 32) = *(uint32_t *)(buf + 32) ^ keystream[ 8];
-		*(uint32_t *)(out + 36) = *(uint32_t *)(buf + 36) ^ keystream[ 9];
-		*(uint32_t *)(out + 40) = *(uint32_t *)(buf + 40) ^ keystream[10];
-		*(uint32_t *)(out + 44) = *(uint32_t *)(buf + 44) ^ keystream[11];
-		*(uint32_t *)(out + 48) = *(uint32_t *)(buf + 48) ^ keystream[12];
-		*(uint32_t *)(out + 52) = *(uint32_t *)(buf + 52) ^ keystream[13];
-		*(uint32_t *)(out + 56) = *(uint32_t *)(buf + 56) ^ keystream[14];
-		*(uint32_t *)(out + 60) = *(uint32_t *)(buf + 60) ^ keystream[15];
-		*(uint32_t *)(out + 64) = *(uint32_t *)(buf + 64) ^ keystream[16];
-		*(uint32_t *)(out + 68) = *(uint32_t *)(buf + 68) ^ keystream[17];
-		*(uint32_t *)(out + 72) = *(uint32_t *)(buf + 72) ^ keystream[18];
-		*(uint32_t *)(out + 76) = *(uint32_t *)(buf + 76) ^ keystream[19];
+		STORE32(out +  0, LOAD32(buf +  0) ^ keystream[ 0]);
+		STORE32(out +  4, LOAD32(buf +  4) ^ keystream[ 1]);
+		STORE32(out +  8, LOAD32(buf +  8) ^ keystream[ 2]);
+		STORE32(out + 12, LOAD32(buf + 12) ^ keystream[ 3]);
+		STORE32(out + 16, LOAD32(buf + 16) ^ keystream[ 4]);
+		STORE32(out + 20, LOAD32(buf + 20) ^ keystream[ 5]);
+		STORE32(out + 24, LOAD32(buf + 24) ^ keystream[ 6]);
+		STORE32(out + 28, LOAD32(buf + 28) ^ keystream[ 7]);
+		STORE32(out + 32, LOAD32(buf + 32) ^ keystream[ 8]);
+		STORE32(out + 36, LOAD32(buf + 36) ^ keystream[ 9]);
+		STORE32(out + 40, LOAD32(buf + 40) ^ keystream[10]);
+		STORE32(out + 44, LOAD32(buf + 44) ^ keystream[11]);
+		STORE32(out + 48, LOAD32(buf + 48) ^ keystream[12]);
+		STORE32(out + 52, LOAD32(buf + 52) ^ keystream[13]);
+		STORE32(out + 56, LOAD32(buf + 56) ^ keystream[14]);
+		STORE32(out + 60, LOAD32(buf + 60) ^ keystream[15]);
+		STORE32(out + 64, LOAD32(buf + 64) ^ keystream[16]);
+		STORE32(out + 68, LOAD32(buf + 68) ^ keystream[17]);
+		STORE32(out + 72, LOAD32(buf + 72) ^ keystream[18]);
+		STORE32(out + 76, LOAD32(buf + 76) ^ keystream[19]);
 	}
 
 	if(buflen > 0) {
@@ -635,10 +655,13 @@ sosemanuk_crypt(struct sosemanuk_context *ctx, const uint8_t *buf, uint32_t bufl
 		for(i = 0; i < buflen; i++)
 			out[i] = buf[i] ^ ((uint8_t *)keystream)[i];
 	}
+
+	ESTREAM_STATS_CRYPT(probe, ESTREAM_STATS_SOSEMANUK, 80);
+	ESTREAM_TRACE_RETURN(crypt, ESTREAM_STATS_SOSEMANUK, ctx, 0);
 }
 
 // Sosemanuk test vectors
-void
+ESTREAM_API void
 sosemanuk_test_vectors(struct sosemanuk_context *ctx)
 {
 	uint32_t keystream[20];
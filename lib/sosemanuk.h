@@ -8,6 +8,8 @@
 #ifndef SOSEMANUK_H
 #define SOSEMANUK_H
 
+#include "estream_inline.h"
+
 /*
  * Sosemanuk context
  * keylen - chipher key length in bytes
@@ -30,10 +32,14 @@ struct sosemanuk_context {
 	uint32_t r2;
 };
 
-int sosemanuk_set_key_and_iv(struct sosemanuk_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[16], const int ivlen);
+ESTREAM_API int sosemanuk_set_key_and_iv(struct sosemanuk_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[16], const int ivlen);
+
+ESTREAM_API void sosemanuk_crypt(struct sosemanuk_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
 
-void sosemanuk_crypt(struct sosemanuk_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
+ESTREAM_API void sosemanuk_test_vectors(struct sosemanuk_context *ctx);
 
-void sosemanuk_test_vectors(struct sosemanuk_context *ctx);
+#ifdef ESTREAM_INLINE
+#include "sosemanuk.c"
+#endif
 
 #endif
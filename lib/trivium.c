@@ -17,6 +17,8 @@
 
 #include "trivium.h"
 #include "macro.h"
+#include "estream_stats.h"
+#include "estream_trace.h"
 
 #define TRIVIUM		10
 
@@ -24,6 +26,31 @@
 #define S64(a, b, c)	((a << (96 - c))  | (b >> (c - 64)))
 #define S96(a, b, c)	((a << (128 - c)) | (b >> (c - 96)))
 
+// Reverse the bits of the 32-bit word. The bit 31 of the word of the state is the first bit of the 32 steps,
+// the keystream and the key of the eSTREAM reference are the bits from the least significant bit of the first byte
+#define REVERSE32(x) {								\
+	x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);			\
+	x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);			\
+	x = ((x >> 4) & 0x0F0F0F0F) | ((x & 0x0F0F0F0F) << 4);			\
+	x = (x >> 24) | ((x >> 8) & 0xFF00) | ((x << 8) & 0xFF0000) | (x << 24);	\
+}
+
+// Keystream word in the byte order of the processor (the bytes of the REVERSE32 in the memory).
+// Big-endian: the byte swap of the REVERSE32 and of the U32TO32 cancel each other,
+// only the bits of the every byte are reversed
+#if __BYTE_ORDER == __BIG_ENDIAN
+#define KEYSTREAM32(x) {							\
+	x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);			\
+	x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);			\
+	x = ((x >> 4) & 0x0F0F0F0F) | ((x & 0x0F0F0F0F) << 4);			\
+}
+#else
+#define KEYSTREAM32(x)	REVERSE32(x)
+#endif
+
+// Reverse the bits of the byte
+#define REVERSE8(x)	((uint8_t)((((x) * 0x0802LU & 0x22110LU) | ((x) * 0x8020LU & 0x88440LU)) * 0x10101LU >> 16))
+
 // Macros update the keystream
 #define T(w) { 							\
 	t1 = S64(w[2], w[1], 66) ^ S64(w[2], w[1], 93); 	\
@@ -82,11 +109,13 @@ trivium_keysetup(struct trivium_context *ctx)
 
 	memset(s, 0, sizeof(s));
 
+	// The bits K1 ... K80 (IV1 ... IV80) are the bits of the key (IV) from the last bit:
+	// the first byte is the last byte of the state of the register, the bits are reversed
 	for(i = 0; i < ctx->keylen; i++)
-		s[i] = ctx->key[i];
+		s[9 - i] = REVERSE8(ctx->key[i]);
 	
 	for(i = 0; i < ctx->ivlen; i++)
-		s[i + 12] = ctx->iv[i];
+		s[21 - i] = REVERSE8(ctx->iv[i]);
 
 	s[37] = 0x70;
 	
@@ -109,26 +138,36 @@ trivium_keysetup(struct trivium_context *ctx)
 
 // Fill the trivium context (key and iv)
 // Return value: 0 (if all is well), -1 is all bad
-int
+ESTREAM_API int
 trivium_set_key_and_iv(struct trivium_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[10], const int ivlen)
 {
+	ESTREAM_TRACE_ENTRY(set_key, ESTREAM_STATS_TRIVIUM, keylen, ctx);
+	ESTREAM_STATS_BEGIN_SETUP(probe);
+
 	trivium_init(ctx);
 	
 	if((keylen > 0) && (keylen <= TRIVIUM))
 		ctx->keylen = keylen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_TRIVIUM, ctx, -1);
 		return -1;
+	}
 	
 	if((ivlen > 0) && (ivlen <= 10))
 		ctx->ivlen = ivlen;
-	else
+	else {
+		ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_TRIVIUM, ctx, -1);
 		return -1;
+	}
 	
 	memcpy(ctx->key, key, keylen);
 	memcpy(ctx->iv, iv, 10);
 	
 	trivium_keysetup(ctx);
 	
+	ESTREAM_STATS_SETUP(probe, ESTREAM_STATS_TRIVIUM);
+	ESTREAM_TRACE_RETURN(set_key, ESTREAM_STATS_TRIVIUM, ctx, 0);
+
 	return 0;
 }
 
@@ -139,31 +178,40 @@ trivium_set_key_and_iv(struct trivium_context *ctx, const uint8_t *key, const in
  * buflen - length the data buffer
  * out - pointer on output array
 */
-void
+ESTREAM_CLONES
+ESTREAM_API void
 trivium_crypt(struct trivium_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out)
 {
 	uint32_t z, w[10], i;
 
+	ESTREAM_TRACE_ENTRY(crypt, ESTREAM_STATS_TRIVIUM, buflen, ctx);
+	ESTREAM_STATS_BEGIN(probe, buflen);
+
 	memcpy(w, ctx->w, sizeof(w));
 
 	for(; buflen >= 4; buflen -= 4, buf += 4, out += 4) {
 		WORK_2(w, z);
-		
-		*(uint32_t *)(out + 0) = *(uint32_t *)(buf + 0) ^ U32TO32(z);
+		KEYSTREAM32(z);
+
+		STORE32(out + 0, LOAD32(buf + 0) ^ z);
 	}
 
 	if(buflen) {
 		WORK_2(w, z);
+		REVERSE32(z);
 		
 		for(i = 0; i < buflen; i++, z >>= 8)
 			out[i] = buf[i] ^ (uint8_t)(z);
 	}
 	
 	memcpy(ctx->w, w, sizeof(w));
+
+	ESTREAM_STATS_CRYPT(probe, ESTREAM_STATS_TRIVIUM, 4);
+	ESTREAM_TRACE_RETURN(crypt, ESTREAM_STATS_TRIVIUM, ctx, 0);
 }
 
 // Test vectors print
-void
+ESTREAM_API void
 trivium_test_vectors(struct trivium_context *ctx)
 {
 	uint32_t z, w[10], i;
@@ -186,6 +234,7 @@ trivium_test_vectors(struct trivium_context *ctx)
 
 	for(i = 0; i < 10; i++) {
 		WORK_2(w, z);
+		REVERSE32(z);
 		PRINT_U32TO32(U32TO32(z));
 	}
 	
@@ -7,6 +7,8 @@
 #ifndef TRIVIUM_H
 #define TRIVIUM_H
 
+#include "estream_inline.h"
+
 /* 
  * Trivium context 
  * keylen - chiper key length in bytes
@@ -23,10 +25,14 @@ struct trivium_context {
 	uint32_t w[10];
 };
 
-int trivium_set_key_and_iv(struct trivium_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[10], const int ivlen);
+ESTREAM_API int trivium_set_key_and_iv(struct trivium_context *ctx, const uint8_t *key, const int keylen, const uint8_t iv[10], const int ivlen);
+
+ESTREAM_API void trivium_crypt(struct trivium_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
 
-void trivium_crypt(struct trivium_context *ctx, const uint8_t *buf, uint32_t buflen, uint8_t *out);
+ESTREAM_API void trivium_test_vectors(struct trivium_context *ctx);
 
-void trivium_test_vectors(struct trivium_context *ctx);
+#ifdef ESTREAM_INLINE
+#include "trivium.c"
+#endif
 
 #endif
@@ -39,7 +39,7 @@
 }
 
 // Well-known Sbox used by Central Bank of Russia
-uint8_t sbox[] = {
+static const uint8_t sbox[] CACHE_ALIGNED = {
 	4, 10, 9, 2, 13, 8, 0, 14, 6, 11, 1, 12, 7, 15, 5, 3,
 	14, 11, 4, 12, 6, 13, 15, 10, 2, 3, 8, 1, 0, 7, 5, 9,
 	5, 8, 1, 13, 10, 3, 4, 2, 14, 15, 12, 7, 6, 0, 9, 11,
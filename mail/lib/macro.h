@@ -39,4 +39,11 @@
 // Cyclic rigtht shift
 #define ROTR32(v, n)	((v >> n) | (v << (32 - n)))
 
+// Alignment of the tables of the constants on the cache line (64 bytes)
+#ifdef __GNUC__
+#define CACHE_ALIGNED	__attribute__((aligned(64)))
+#else
+#define CACHE_ALIGNED
+#endif
+
 #endif
@@ -0,0 +1,696 @@
+/*
+ * This program implements the common part of the speed tests.
+ * The time is CLOCK_MONOTONIC, the cycles are the time stamp counter (reference cycles, rdtsc).
+ * The number of the iterations of the sample is calibrated so that the sample is not shorter than
+ * BENCH_SAMPLE_NS, the calibration is the warm-up too (caches, pages of the buffers, frequency).
+ * Scaling test: every thread is pinned before its buffers are allocated and touched (the memory
+ * of the NUMA node of the thread), the threads start together and run for the same time.
+ * Hardware counters: the events of the thread (user space) are counted only in the samples,
+ * every event is the separate counter, so the events of the processor are counted without the others.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "bench.h"
+
+// Student's t of the 95% two-sided interval, degrees of freedom 1 - 30
+static const double student_t[30] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+				       2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+				       2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+
+// Monotonic time, ns
+uint64_t
+bench_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Time stamp counter
+uint64_t
+bench_cycles(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// 1 if the time stamp counter is available
+int
+bench_has_cycles(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+// Measure the function
+// Return value: number of the samples
+int
+bench_run(bench_func_t func, void *arg, int samples, double budget, double *ns, double *cycles, uint64_t *iters,
+	  struct bench_perf *perf)
+{
+	uint64_t n, t, c, start;
+	int i;
+
+	// Calibration: the sample is not shorter than BENCH_SAMPLE_NS
+	for(n = 1; ; ) {
+		t = bench_ns();
+		func(arg, n);
+		t = bench_ns() - t;
+
+		if(t >= BENCH_SAMPLE_NS)
+			break;
+
+		// Next try - a little longer than the minimum time
+		n = (t > 0) ? n * (BENCH_SAMPLE_NS * 1.2 / t) + 1 : n * 16;
+	}
+
+	*iters = n;
+	start = bench_ns();
+
+	if(perf != NULL)
+		bench_perf_reset(perf);
+
+	for(i = 0; i < samples; i++) {
+		if((i >= 2) && (bench_ns() - start > budget * 1e9))
+			break;
+
+		if(perf != NULL)
+			bench_perf_start(perf);
+
+		c = bench_cycles();
+		t = bench_ns();
+		func(arg, n);
+		t = bench_ns() - t;
+		c = bench_cycles() - c;
+
+		if(perf != NULL)
+			bench_perf_stop(perf, n);
+
+		ns[i] = (double)t / n;
+		cycles[i] = (double)c / n;
+	}
+
+	return i;
+}
+
+// Type and configuration of the events
+static const uint32_t perf_type[BENCH_PERF_EVENTS] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+							PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE };
+
+static const uint64_t perf_config[BENCH_PERF_EVENTS] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_BRANCH_MISSES,
+	PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+	PERF_COUNT_HW_CACHE_MISSES
+};
+
+// Open the counters of the hardware events of the thread
+// Return value: number of the available events
+int
+bench_perf_open(struct bench_perf *perf)
+{
+	struct perf_event_attr attr;
+	int i, n = 0;
+
+	for(i = 0; i < BENCH_PERF_EVENTS; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = perf_type[i];
+		attr.config = perf_config[i];
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		perf->fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+		if(perf->fd[i] >= 0)
+			n++;
+	}
+
+	bench_perf_reset(perf);
+
+	return n;
+}
+
+// Close the counters
+void
+bench_perf_close(struct bench_perf *perf)
+{
+	int i;
+
+	for(i = 0; i < BENCH_PERF_EVENTS; i++) {
+		if(perf->fd[i] >= 0)
+			close(perf->fd[i]);
+
+		perf->fd[i] = -1;
+	}
+}
+
+// Clear the counts of the events
+void
+bench_perf_reset(struct bench_perf *perf)
+{
+	memset(perf->count, 0, sizeof(perf->count));
+	perf->iters = 0;
+}
+
+// Start of the counted region
+void
+bench_perf_start(struct bench_perf *perf)
+{
+	int i;
+
+	for(i = 0; i < BENCH_PERF_EVENTS; i++) {
+		if(perf->fd[i] >= 0) {
+			ioctl(perf->fd[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(perf->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+// Stop of the counted region: the value, the time enabled and the time running of every event
+void
+bench_perf_stop(struct bench_perf *perf, uint64_t iters)
+{
+	uint64_t value[3];
+	int i;
+
+	for(i = 0; i < BENCH_PERF_EVENTS; i++) {
+		if(perf->fd[i] >= 0)
+			ioctl(perf->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+	}
+
+	for(i = 0; i < BENCH_PERF_EVENTS; i++) {
+		if((perf->fd[i] < 0) || (read(perf->fd[i], value, sizeof(value)) != sizeof(value)))
+			continue;
+
+		// The counter was multiplexed with the other events
+		if((value[2] > 0) && (value[2] < value[1]))
+			value[0] = (double)value[0] * value[1] / value[2];
+
+		perf->count[i] += value[0];
+	}
+
+	perf->iters += iters;
+}
+
+// Events of the one iteration
+// Return value: number of the events, -1 (if the event is not available)
+double
+bench_perf_value(const struct bench_perf *perf, int event)
+{
+	if((perf->fd[event] < 0) || (perf->iters == 0))
+		return -1;
+
+	return (double)perf->count[event] / perf->iters;
+}
+
+// Field of the counters, "n/a" if the events are not available
+static void
+bench_perf_field(struct bench_field *field, const char *name, double a, double b, int prec)
+{
+	if((a < 0) || (b <= 0))
+		bench_str(field, name, "n/a");
+	else
+		bench_num(field, name, a / b, prec);
+}
+
+// Fields of the counters: IPC, instructions and misses per byte (per iteration if bytes is 0)
+// Return value: number of the fields
+int
+bench_perf_fields(struct bench_field *field, const struct bench_perf *perf, double bytes)
+{
+	double per = (bytes > 0) ? bytes : 1;
+	int k = 0;
+
+	bench_perf_field(&field[k++], "IPC", bench_perf_value(perf, BENCH_PERF_INSTRUCTIONS),
+			 bench_perf_value(perf, BENCH_PERF_CYCLES), 2);
+	bench_perf_field(&field[k++], "instructions/byte", bench_perf_value(perf, BENCH_PERF_INSTRUCTIONS), per, 2);
+	bench_perf_field(&field[k++], "branch-misses/byte", bench_perf_value(perf, BENCH_PERF_BRANCH_MISSES), per, 4);
+	bench_perf_field(&field[k++], "L1D-misses/byte", bench_perf_value(perf, BENCH_PERF_L1D_MISSES), per, 4);
+	bench_perf_field(&field[k++], "LLC-misses/byte", bench_perf_value(perf, BENCH_PERF_LLC_MISSES), per, 4);
+
+	return k;
+}
+
+/*
+ * Thread of the scaling test
+ * setup, func, arg - preparation and the measured function
+ * bytes - bytes of the one iteration
+ * cpu - processor of the thread, -1 - no pinning
+ * barrier - start of the threads after the setup
+ * stop - end of the test
+ * res - result of the setup
+ * total - processed bytes
+ * ns - time of the thread
+*/
+struct bench_thread {
+	bench_setup_t setup;
+	bench_func_t func;
+	void *arg;
+	uint64_t bytes;
+	int cpu;
+	pthread_barrier_t *barrier;
+	volatile int *stop;
+	int res;
+	uint64_t total;
+	uint64_t ns;
+};
+
+// Thread of the scaling test
+static void *
+bench_thread_run(void *arg)
+{
+	struct bench_thread *t = arg;
+	cpu_set_t set;
+	uint64_t start;
+
+	if(t->cpu >= 0) {
+		CPU_ZERO(&set);
+		CPU_SET(t->cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+
+	t->res = (t->setup != NULL) ? t->setup(t->arg) : 0;
+
+	// One iteration before the start: warm-up
+	if(t->res == 0)
+		t->func(t->arg, 1);
+
+	pthread_barrier_wait(t->barrier);
+
+	start = bench_ns();
+
+	for(t->total = 0; (t->res == 0) && !*t->stop; t->total += t->bytes)
+		t->func(t->arg, 1);
+
+	t->ns = bench_ns() - start;
+
+	return NULL;
+}
+
+// Scaling test
+// Return value: total speed of the threads, GB/s, -1 (if all bad)
+double
+bench_scaling(bench_setup_t setup, bench_func_t func, void *arg[], uint64_t bytes, int n,
+	      const int *cpu, int ncpus, double seconds)
+{
+	struct bench_thread t[n];
+	pthread_t thread[n];
+	pthread_barrier_t barrier;
+	volatile int stop = 0;
+	double speed = 0;
+	int i, created;
+
+	if(pthread_barrier_init(&barrier, NULL, n + 1))
+		return -1;
+
+	for(created = 0; created < n; created++) {
+		t[created].setup = setup;
+		t[created].func = func;
+		t[created].arg = arg[created];
+		t[created].bytes = bytes;
+		t[created].cpu = (ncpus > 0) ? cpu[created % ncpus] : -1;
+		t[created].barrier = &barrier;
+		t[created].stop = &stop;
+
+		if(pthread_create(&thread[created], NULL, bench_thread_run, &t[created]))
+			break;
+	}
+
+	// The threads wait for all n + 1 parties: the missing threads are replaced by this thread
+	for(i = created; i < n; i++)
+		pthread_barrier_wait(&barrier);
+
+	pthread_barrier_wait(&barrier);
+
+	usleep(seconds * 1e6);
+	stop = 1;
+
+	for(i = 0; i < created; i++) {
+		pthread_join(thread[i], NULL);
+
+		if(t[i].res)
+			speed = -1;
+		else if((speed >= 0) && (t[i].ns > 0))
+			speed += (double)t[i].total / t[i].ns;
+	}
+
+	pthread_barrier_destroy(&barrier);
+
+	return (created < n) ? -1 : speed;
+}
+
+/*
+ * Buffers of the memcpy thread
+ * bytes - size of the buffers
+ * src, dst - buffers
+*/
+struct bench_copy {
+	uint64_t bytes;
+	uint8_t *src;
+	uint8_t *dst;
+};
+
+// Buffers of the memcpy thread, touched by the thread
+static int
+bench_copy_setup(void *arg)
+{
+	struct bench_copy *c = arg;
+
+	if(posix_memalign((void **)&c->src, 64, c->bytes))
+		return -1;
+
+	if(posix_memalign((void **)&c->dst, 64, c->bytes)) {
+		free(c->src);
+		c->src = NULL;
+		return -1;
+	}
+
+	memset(c->src, 1, c->bytes);
+	memset(c->dst, 0, c->bytes);
+
+	return 0;
+}
+
+// memcpy of the buffers
+static void
+bench_copy(void *arg, uint64_t iters)
+{
+	struct bench_copy *c = arg;
+	uint64_t i;
+
+	for(i = 0; i < iters; i++)
+		memcpy(c->dst, c->src, c->bytes);
+}
+
+// memcpy of the n threads
+// Return value: GB/s, -1 (if all bad)
+double
+bench_memcpy(uint64_t bytes, int n, const int *cpu, int ncpus, double seconds)
+{
+	struct bench_copy c[n];
+	void *arg[n];
+	double speed;
+	int i;
+
+	for(i = 0; i < n; i++) {
+		c[i].bytes = bytes;
+		c[i].src = c[i].dst = NULL;
+		arg[i] = &c[i];
+	}
+
+	speed = bench_scaling(bench_copy_setup, bench_copy, arg, bytes, n, cpu, ncpus, seconds);
+
+	for(i = 0; i < n; i++) {
+		free(c[i].src);
+		free(c[i].dst);
+	}
+
+	return speed;
+}
+
+// Default numbers of the threads of the scaling test
+// Return value: number of the numbers
+int
+bench_threads(int *list, int max)
+{
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int n = 0, i;
+
+	ncpus = (ncpus < 1) ? 1 : (ncpus > BENCH_MAX_THREADS) ? BENCH_MAX_THREADS : ncpus;
+
+	for(i = 1; (i < ncpus) && (n < max - 1); i *= 2)
+		list[n++] = i;
+
+	list[n++] = ncpus;
+
+	return n;
+}
+
+// List of the numbers separated by the comma, "a-b" - range
+// Return value: number of the numbers, -1 (if the list is bad)
+int
+bench_list(const char *str, int *list, int max)
+{
+	long a, b;
+	char *end;
+	int n = 0;
+
+	for(;;) {
+		a = b = strtol(str, &end, 10);
+
+		if(end == str)
+			return -1;
+
+		if(*end == '-') {
+			str = end + 1;
+			b = strtol(str, &end, 10);
+
+			if((end == str) || (b < a))
+				return -1;
+		}
+
+		for(; a <= b; a++) {
+			if(n == max)
+				return -1;
+
+			list[n++] = a;
+		}
+
+		if(*end == '\0')
+			return n;
+
+		if(*end != ',')
+			return -1;
+
+		str = end + 1;
+	}
+}
+
+// Statistics of the n samples
+void
+bench_stat(const double *x, int n, struct bench_stat *s)
+{
+	double sum = 0, var = 0;
+	int i;
+
+	memset(s, 0, sizeof(*s));
+
+	if(n <= 0)
+		return;
+
+	s->min = s->max = x[0];
+
+	for(i = 0; i < n; i++) {
+		sum += x[i];
+
+		if(x[i] < s->min)
+			s->min = x[i];
+
+		if(x[i] > s->max)
+			s->max = x[i];
+	}
+
+	s->mean = sum / n;
+
+	if(n < 2)
+		return;
+
+	for(i = 0; i < n; i++)
+		var += (x[i] - s->mean) * (x[i] - s->mean);
+
+	var /= n - 1;
+
+	s->ci = ((n - 1 <= 30) ? student_t[n - 2] : 1.960) * sqrt(var / n);
+}
+
+// Compare function of the sort
+static int
+bench_compare(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+// Percentile p of the n samples (nearest rank), the samples are sorted
+double
+bench_percentile(double *x, int n, double p)
+{
+	int k;
+
+	if(n <= 0)
+		return 0;
+
+	qsort(x, n, sizeof(*x), bench_compare);
+
+	k = (int)ceil(p / 100 * n) - 1;
+
+	if(k < 0)
+		k = 0;
+
+	return x[(k < n) ? k : n - 1];
+}
+
+// Size with the suffix K, M or G
+// Return value: size in bytes, 0 (if the string is bad)
+uint64_t
+bench_size(const char *str)
+{
+	uint64_t size;
+	char *end;
+
+	size = strtoull(str, &end, 10);
+
+	switch(*end) {
+	case 'k' :
+	case 'K' : size <<= 10;
+		   end++;
+		   break;
+	case 'm' :
+	case 'M' : size <<= 20;
+		   end++;
+		   break;
+	case 'g' :
+	case 'G' : size <<= 30;
+		   end++;
+		   break;
+	}
+
+	return (*end == '\0') ? size : 0;
+}
+
+// Format by the name
+// Return value: format, -1 (if the name is bad)
+int
+bench_format(const char *name)
+{
+	if(!strcmp(name, "text"))
+		return BENCH_TEXT;
+
+	if(!strcmp(name, "json"))
+		return BENCH_JSON;
+
+	if(!strcmp(name, "csv"))
+		return BENCH_CSV;
+
+	return -1;
+}
+
+// Number field of the record
+void
+bench_num(struct bench_field *field, const char *name, double num, int prec)
+{
+	field->name = name;
+	field->str = NULL;
+	field->num = num;
+	field->prec = prec;
+}
+
+// String field of the record
+void
+bench_str(struct bench_field *field, const char *name, const char *str)
+{
+	field->name = name;
+	field->str = str;
+	field->num = 0;
+	field->prec = 0;
+}
+
+// Begin of the output
+void
+bench_begin(struct bench_output *out, FILE *fp, int format)
+{
+	out->fp = fp;
+	out->format = format;
+	out->nrows = 0;
+
+	if(format == BENCH_JSON)
+		fprintf(fp, "[");
+}
+
+// Write the record: the header (names of the fields) is written before the first record
+void
+bench_row(struct bench_output *out, const struct bench_field *field, int n)
+{
+	int i;
+
+	switch(out->format) {
+	case BENCH_JSON :
+		fprintf(out->fp, "%s\n  {", (out->nrows > 0) ? "," : "");
+
+		for(i = 0; i < n; i++) {
+			if(field[i].str != NULL)
+				fprintf(out->fp, "%s\"%s\": \"%s\"", i ? ", " : "", field[i].name, field[i].str);
+			else
+				fprintf(out->fp, "%s\"%s\": %.*f", i ? ", " : "", field[i].name, field[i].prec, field[i].num);
+		}
+
+		fprintf(out->fp, "}");
+		break;
+
+	case BENCH_CSV :
+		for(i = 0; (out->nrows == 0) && (i < n); i++)
+			fprintf(out->fp, "%s%c", field[i].name, (i < n - 1) ? ',' : '\n');
+
+		for(i = 0; i < n; i++) {
+			if(field[i].str != NULL)
+				fprintf(out->fp, "%s", field[i].str);
+			else
+				fprintf(out->fp, "%.*f", field[i].prec, field[i].num);
+
+			fprintf(out->fp, "%c", (i < n - 1) ? ',' : '\n');
+		}
+		break;
+
+	default :
+		for(i = 0; (out->nrows == 0) && (i < n); i++)
+			fprintf(out->fp, "%12s%s", field[i].name, (i < n - 1) ? " " : "\n");
+
+		for(i = 0; i < n; i++) {
+			if(field[i].str != NULL)
+				fprintf(out->fp, "%12s", field[i].str);
+			else
+				fprintf(out->fp, "%12.*f", field[i].prec, field[i].num);
+
+			fprintf(out->fp, "%s", (i < n - 1) ? " " : "\n");
+		}
+		break;
+	}
+
+	fflush(out->fp);
+	out->nrows++;
+}
+
+// End of the output
+void
+bench_end(struct bench_output *out)
+{
+	if(out->format == BENCH_JSON)
+		fprintf(out->fp, "%s]\n", (out->nrows > 0) ? "\n" : "");
+}
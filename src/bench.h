@@ -0,0 +1,184 @@
+/*
+ * Common part of the speed tests: time, calibrated measurements, statistics
+ * and output of the results (text table, JSON or CSV).
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Minimum time of the one sample, ns (the number of the iterations is calibrated)
+#define BENCH_SAMPLE_NS		10000000
+
+// Formats of the output
+#define BENCH_TEXT	0
+#define BENCH_JSON	1
+#define BENCH_CSV	2
+
+// Maximum number of the fields of the record
+#define BENCH_MAX_FIELDS	32
+
+// Function of the measurement: iters iterations of the measured operation
+typedef void (*bench_func_t)(void *arg, uint64_t iters);
+
+// Preparation of the thread of the scaling test (buffers are touched by the pinned thread)
+// Return value: 0 (if all is well), -1 (if all bad)
+typedef int (*bench_setup_t)(void *arg);
+
+// Maximum number of the threads of the scaling test
+#define BENCH_MAX_THREADS	1024
+
+// Maximum number of the processor of the pinning (CPU_SETSIZE)
+#define BENCH_MAX_CPUS		1024
+
+// Hardware events of the perf_event_open counters
+#define BENCH_PERF_CYCLES		0
+#define BENCH_PERF_INSTRUCTIONS		1
+#define BENCH_PERF_BRANCH_MISSES	2
+#define BENCH_PERF_L1D_MISSES		3
+#define BENCH_PERF_LLC_MISSES		4
+
+// Number of the events
+#define BENCH_PERF_EVENTS		5
+
+/*
+ * Statistics of the samples
+ * mean - mean value
+ * ci - half-width of the 95% confidence interval of the mean (Student's t)
+ * min, max - minimum and maximum value
+*/
+struct bench_stat {
+	double mean;
+	double ci;
+	double min;
+	double max;
+};
+
+/*
+ * Field of the record of the results
+ * name - name of the field (column)
+ * str - value of the string field, NULL if the field is the number
+ * num - value of the number field
+ * prec - number of the digits after the point
+*/
+struct bench_field {
+	const char *name;
+	const char *str;
+	double num;
+	int prec;
+};
+
+/*
+ * Hardware counters of the measured regions (perf_event_open, the thread of the test, user space)
+ * fd - file descriptors of the events, -1 if the event is not available
+ * count - events of the counted regions (scaled if the counters are multiplexed)
+ * iters - iterations of the counted regions
+*/
+struct bench_perf {
+	int fd[BENCH_PERF_EVENTS];
+	uint64_t count[BENCH_PERF_EVENTS];
+	uint64_t iters;
+};
+
+/*
+ * Output of the results
+ * fp - output file
+ * format - BENCH_TEXT, BENCH_JSON or BENCH_CSV
+ * nrows - number of the written records
+*/
+struct bench_output {
+	FILE *fp;
+	int format;
+	int nrows;
+};
+
+// Monotonic time, ns
+uint64_t bench_ns(void);
+
+// Time stamp counter (reference cycles), 0 if the processor has no counter
+uint64_t bench_cycles(void);
+
+// 1 if the time stamp counter is available, else 0
+int bench_has_cycles(void);
+
+// Measure the function: warm-up and calibration of the iterations, then the samples
+// samples - maximum number of the samples (at least 2 are taken)
+// budget - time in seconds after which no more samples are taken
+// ns, cycles - time and cycles of the one iteration of every sample
+// iters - number of the iterations of the one sample
+// perf - counters of the samples (NULL - no counters), the counts of the previous run are cleared
+// Return value: number of the samples
+int bench_run(bench_func_t func, void *arg, int samples, double budget, double *ns, double *cycles, uint64_t *iters,
+	      struct bench_perf *perf);
+
+// Open the counters of the hardware events of the thread
+// Return value: number of the available events (0 - no counters, e.g. the virtual machine or perf_event_paranoid)
+int bench_perf_open(struct bench_perf *perf);
+
+// Close the counters
+void bench_perf_close(struct bench_perf *perf);
+
+// Clear the counts of the events
+void bench_perf_reset(struct bench_perf *perf);
+
+// Start and stop of the counted region, iters - iterations of the region
+void bench_perf_start(struct bench_perf *perf);
+void bench_perf_stop(struct bench_perf *perf, uint64_t iters);
+
+// Events of the one iteration
+// Return value: number of the events, -1 (if the event is not available)
+double bench_perf_value(const struct bench_perf *perf, int event);
+
+// Fields of the counters: IPC, instructions and misses per byte (per iteration if bytes is 0),
+// "n/a" if the event is not available
+// Return value: number of the fields
+int bench_perf_fields(struct bench_field *field, const struct bench_perf *perf, double bytes);
+
+// Scaling test: n threads, every thread with its own argument, pinned to the processor cpu[i % ncpus]
+// (no pinning if ncpus is 0), setup in the thread, then the iterations of the bytes bytes for the seconds
+// Return value: total speed of the threads, bytes per ns (GB/s), -1 (if all bad)
+double bench_scaling(bench_setup_t setup, bench_func_t func, void *arg[], uint64_t bytes, int n,
+		     const int *cpu, int ncpus, double seconds);
+
+// memcpy of the bytes bytes by the n threads as in the bench_scaling (roofline of the memory)
+// Return value: total copied bytes per ns (GB/s), -1 (if all bad)
+double bench_memcpy(uint64_t bytes, int n, const int *cpu, int ncpus, double seconds);
+
+// Default numbers of the threads of the scaling test: 1, 2, 4, ... and the number of the processors
+// Return value: number of the numbers
+int bench_threads(int *list, int max);
+
+// List of the numbers separated by the comma, "a-b" - range
+// Return value: number of the numbers, -1 (if the list is bad)
+int bench_list(const char *str, int *list, int max);
+
+// Statistics of the n samples
+void bench_stat(const double *x, int n, struct bench_stat *s);
+
+// Percentile p (0 - 100) of the n samples, the samples are sorted
+double bench_percentile(double *x, int n, double p);
+
+// Size with the suffix K, M or G (1024 multiples)
+// Return value: size in bytes, 0 (if the string is bad)
+uint64_t bench_size(const char *str);
+
+// Format by the name: text, json or csv
+// Return value: format, -1 (if the name is bad)
+int bench_format(const char *name);
+
+// Number field and string field of the record
+void bench_num(struct bench_field *field, const char *name, double num, int prec);
+void bench_str(struct bench_field *field, const char *name, const char *str);
+
+// Begin of the output
+void bench_begin(struct bench_output *out, FILE *fp, int format);
+
+// Write the record of the n fields
+void bench_row(struct bench_output *out, const struct bench_field *field, int n);
+
+// End of the output
+void bench_end(struct bench_output *out);
+
+#endif /* BENCH_H */
@@ -13,6 +13,7 @@
 #include <getopt.h>
 
 #include "estream.h"
+#include "pbkdf2.h"
 
 #define MAX_FILE 	4096
 #define BLOCK		1000000
@@ -22,6 +23,7 @@ uint8_t key[32];
 uint8_t iv[16];
 int keylen;
 int ivlen;
+uint32_t iterations;
 
 // Union all structures eSTREAM project
 union context {
@@ -38,27 +40,32 @@ typedef int (*set_t)(void *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen
 typedef void (*crypt_t)(void *ctx, uint8_t *buf, uint32_t buflen, uint8_t *out);
 
 // Pointer of the function eSTREAM project
-set_t set[] = { (set_t)salsa_set_key_and_iv,
-		(set_t)rabbit_set_key_and_iv,
-		(set_t)hc128_set_key_and_iv,
-		(set_t)sosemanuk_set_key_and_iv,
-		(set_t)grain_set_key_and_iv,
-		(set_t)mickey_set_key_and_iv,
-		(set_t)trivium_set_key_and_iv };
-
-crypt_t crypt[] = { (crypt_t)salsa_crypt,
-		    (crypt_t)rabbit_crypt,
-		    (crypt_t)hc128_crypt,
-		    (crypt_t)sosemanuk_crypt,
-		    (crypt_t)grain_crypt,
-		    (crypt_t)mickey_crypt,
-		    (crypt_t)trivium_crypt };
+static const set_t set[] = { (set_t)salsa_set_key_and_iv,
+			     (set_t)rabbit_set_key_and_iv,
+			     (set_t)hc128_set_key_and_iv,
+			     (set_t)sosemanuk_set_key_and_iv,
+			     (set_t)grain_set_key_and_iv,
+			     (set_t)mickey_set_key_and_iv,
+			     (set_t)trivium_set_key_and_iv };
+
+static const crypt_t crypt[] = { (crypt_t)salsa_crypt,
+				 (crypt_t)rabbit_crypt,
+				 (crypt_t)hc128_crypt,
+				 (crypt_t)sosemanuk_crypt,
+				 (crypt_t)grain_crypt,
+				 (crypt_t)mickey_crypt,
+				 (crypt_t)trivium_crypt };
 
 // Copy key and IV
+// With PBKDF2 the key is derived from the password, the IV is the salt
 void
 get_key_and_iv(char *k, char *v)
 {
-	memcpy(key, k, keylen);
+	if(iterations > 0)
+		pbkdf2(PBKDF2_SHA256, (uint8_t *)k, strlen(k), (uint8_t *)v, ivlen, iterations, key, keylen);
+	else
+		memcpy(key, k, keylen);
+
 	memcpy(iv, v, ivlen);
 }
 
@@ -92,6 +99,7 @@ help(void)
 	printf("\t\t4 - Grain\n\t\t5 - Mickey\n\t\t6 - Trivium\n");
 	printf("\t--input(-i) - input file\n");
 	printf("\t--output(-o) - output file\n");
+	printf("\t--kdf(-k) - number of the iterations PBKDF2-HMAC-SHA256 of the secret key (0 - key as is)\n");
 	printf("\nExample: ./estream -h or ./estream -a 1 -i 1.tx -o 2.txt\n\n");
 }
 
@@ -109,6 +117,7 @@ main(int argc, char *argv[])
 		{"input",     1, NULL, 'i'},
 		{"output",    1, NULL, 'o'},
 		{"algorithm", 1, NULL, 'a'},
+		{"kdf",       1, NULL, 'k'},
 		{0,        0, NULL,  0 }
 	};
 
@@ -118,7 +127,7 @@ main(int argc, char *argv[])
 	}
 
 	// Parse arguments
-	while((res = getopt_long(argc, argv, "a:i:o:h", long_option, 0)) != -1) {
+	while((res = getopt_long(argc, argv, "a:i:o:k:h", long_option, 0)) != -1) {
 		switch(res) {
 		case 'h' : help();
 			   return 0;
@@ -128,6 +137,8 @@ main(int argc, char *argv[])
 			   break;
 		case 'a' : alg = atoi(optarg);
 			   break;
+		case 'k' : iterations = strtoul(optarg, NULL, 10);
+			   break;
 		}
 	}
 	
@@ -147,6 +158,10 @@ main(int argc, char *argv[])
 	printf("Enter secret key - ");
 	scanf("%s", k);
 	keylen = strlen(k);
+
+	// The derived key has the maximum length of the algorithm
+	if(iterations > 0)
+		keylen = sizeof(key);
 	
 	// Enter the vector initialization
 	printf("Enter vector initialization - ");
@@ -0,0 +1,117 @@
+/*
+ * Known answer of the copies of the ciphers: lib/, Qt_project/lib/ and mail/lib/
+ * Makefile: Makefile_test_vectors (make -f Makefile_test_vectors copies)
+ * The program is compiled three times: by the C compiler with the sources of the lib and by the C++ compiler
+ * with the sources of the Qt_project/lib and of the mail/lib. The keystream of the one vector
+ * of the Rabbit, Sosemanuk and Trivium (the ciphers fixed by the known answer tests) is compared
+ * with the same expected keystream, so the CLI and the applications crypt the same ciphertext.
+ * The Sosemanuk keystream is made by the lib, it is the consistency of the copies with the lib.
+ * The exit code is 1 if any keystream differs.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rabbit.h"
+#include "sosemanuk.h"
+#include "trivium.h"
+
+// Size of the compared keystream
+#define KEYSTREAM	64
+
+// Key and IV of the vector
+static const uint8_t key[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+				 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF };
+
+static const uint8_t iv[16] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF,
+				0xFE, 0xDC, 0xBA, 0x98, 0x76, 0x54, 0x32, 0x10 };
+
+// Keystream of the Rabbit (128-bit key, 64-bit IV)
+static const uint8_t rabbit_keystream[KEYSTREAM] = {
+	0x8C, 0x74, 0x92, 0x6C, 0xCA, 0xFD, 0x70, 0x52,
+	0xF2, 0x8D, 0x48, 0xBA, 0x0F, 0xD5, 0x54, 0x50,
+	0x9E, 0x8F, 0xFC, 0x1E, 0xA3, 0x67, 0x25, 0x1B,
+	0x8D, 0xFD, 0x70, 0x6B, 0xFA, 0x47, 0x1B, 0x6D,
+	0x45, 0x03, 0x77, 0x0C, 0x07, 0x51, 0xC0, 0x69,
+	0x43, 0x35, 0x0D, 0x90, 0xE9, 0x54, 0xE9, 0x77,
+	0x2B, 0x29, 0x2D, 0x51, 0x11, 0x19, 0xA9, 0x1E,
+	0x73, 0x33, 0x32, 0x83, 0xA6, 0x4E, 0x26, 0x58
+};
+
+// Keystream of the Sosemanuk (128-bit key padded to 256 bits, 128-bit IV) of the lib: the check of the copies
+// against the lib, not of the conformance (the published vectors are test_vectors/sosemanuk.test-vectors)
+static const uint8_t sosemanuk_keystream[KEYSTREAM] = {
+	0xF5, 0x09, 0xF8, 0xC7, 0xA6, 0x46, 0x9F, 0xCB,
+	0x45, 0xEF, 0xB7, 0x77, 0xD7, 0x46, 0x02, 0x62,
+	0x62, 0xE3, 0x4E, 0x72, 0x59, 0x62, 0x75, 0xE3,
+	0xBC, 0x6E, 0xC7, 0x5E, 0x0C, 0xE7, 0x64, 0x79,
+	0x40, 0xBF, 0x5B, 0x79, 0x1C, 0x5B, 0xE0, 0x48,
+	0x40, 0x8B, 0x09, 0xC4, 0x36, 0x42, 0xD5, 0x52,
+	0x75, 0xF5, 0xCF, 0x32, 0x10, 0x56, 0x10, 0x45,
+	0x33, 0x75, 0x7A, 0x64, 0xB0, 0x97, 0x60, 0x0D
+};
+
+// Keystream of the Trivium (80-bit key, 80-bit IV)
+static const uint8_t trivium_keystream[KEYSTREAM] = {
+	0x54, 0x30, 0x50, 0xBA, 0xAD, 0x99, 0xE2, 0x51,
+	0x9F, 0x3D, 0xF6, 0x3D, 0xF1, 0x3D, 0x37, 0xD1,
+	0x22, 0x54, 0x1D, 0x2A, 0x98, 0xDF, 0x46, 0x73,
+	0x53, 0x95, 0x44, 0xED, 0xF1, 0x70, 0xD2, 0x29,
+	0x95, 0x6F, 0xAB, 0x45, 0x50, 0xF7, 0x22, 0x4F,
+	0x38, 0x57, 0x2E, 0x54, 0xC8, 0x72, 0x75, 0xE4,
+	0x15, 0xF0, 0x0E, 0xD7, 0xD1, 0xBE, 0x24, 0xA8,
+	0xBC, 0x42, 0x43, 0x0E, 0xFA, 0x09, 0x58, 0xA1
+};
+
+// Compare the keystream with the expected keystream
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+check(const char *name, const uint8_t *keystream, const uint8_t *expected)
+{
+	int i;
+
+	for(i = 0; i < KEYSTREAM; i++)
+		if(keystream[i] != expected[i])
+			break;
+
+	if(i == KEYSTREAM) {
+		printf("%s: ok\n", name);
+		return 0;
+	}
+
+	printf("%s: MISMATCH at byte %d: %02x, expected %02x\n", name, i, keystream[i], expected[i]);
+
+	return -1;
+}
+
+int
+main(void)
+{
+	struct rabbit_context rabbit;
+	struct sosemanuk_context sosemanuk;
+	struct trivium_context trivium;
+	uint8_t zero[KEYSTREAM], keystream[KEYSTREAM];
+	int result = 0;
+
+	memset(zero, 0, sizeof(zero));
+
+	if(rabbit_set_key_and_iv(&rabbit, key, 16, iv, 8) ||
+	   sosemanuk_set_key_and_iv(&sosemanuk, key, 16, iv, 16) ||
+	   trivium_set_key_and_iv(&trivium, key, 10, iv, 10)) {
+		printf("Key and IV are not set!\n");
+		return 1;
+	}
+
+	rabbit_crypt(&rabbit, zero, KEYSTREAM, keystream);
+	result |= check("Rabbit", keystream, rabbit_keystream);
+
+	sosemanuk_crypt(&sosemanuk, zero, KEYSTREAM, keystream);
+	result |= check("Sosemanuk", keystream, sosemanuk_keystream);
+
+	trivium_crypt(&trivium, zero, KEYSTREAM, keystream);
+	result |= check("Trivium", keystream, trivium_keystream);
+
+	return (result == 0) ? 0 : 1;
+}
@@ -0,0 +1,935 @@
+/*
+ * Differential fuzz test of the ciphers and the HASH functions
+ * Makefile: Makefile_fuzz
+ * Compile: make -f Makefile_fuzz (standalone driver) or make -f Makefile_fuzz libfuzzer (clang, libFuzzer and ASan)
+ * Example: ./estream_fuzz -n 100000 or ./estream_fuzz -s 42 -M 1M or ./estream_fuzz crash-file
+ * or ./estream_fuzz_libfuzzer -max_len=300000 corpus/
+ * The input is: the number of the target, the parameters, the seed of the chunk boundaries,
+ * the key, the IV and the message. Every target compares the fast paths with the reference:
+ *	ciphers - the keystream of the one block per call (XOR the message) against the one-shot crypt,
+ *		  the random chunks (multiples of the block and the tail), the unaligned in-place crypt
+ *		  and the decryption of the ciphertext, the keystream of the scalar code (Salsa, Rabbit:
+ *		  estream_fuzz_ref.c is compiled with the ESTREAM_NO_SIMD) against the vector kernels
+ *	hashes - init, update of the whole message, final (scalar kernel, one thread) against the random chunks,
+ *		 the export and the import of the state at the random point, every SIMD kernel of the processor
+ *		 (BLAKE3, SHA3x), the threads (BLAKE3, KangarooTwelve)
+ *	HMAC - hmac and the chunks of hmac_update against the HMAC by the hash functions (RFC 2104)
+ *	PBKDF2 - pbkdf2 and pbkdf2_many (SIMD lanes) against the PBKDF2 by the hmac (RFC 8018)
+ * Any difference is printed (target, variant, size, offset) and the program is aborted,
+ * the standalone driver writes the input to the file fuzz-crash.bin (./estream_fuzz fuzz-crash.bin replays it).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "estream.h"
+#include "md5.h"
+#include "sha1.h"
+#include "sha224.h"
+#include "sha256.h"
+#include "sha384.h"
+#include "sha512.h"
+#include "sha3.h"
+#include "sha3x.h"
+#include "k12.h"
+#include "blake3.h"
+#include "hmac.h"
+#include "pbkdf2.h"
+#include "estream_fuzz_ref.h"
+
+// Number of the ciphers, the HASH functions and all targets (ciphers, hashes, HMAC, PBKDF2)
+#define NCIPHERS	8
+#define NHASHES		12
+#define NTARGETS	(NCIPHERS + NHASHES + 2)
+
+// Size of the header of the input: target, parameters, seed of the chunks, key, IV
+#define PARAMS		7
+#define HEADER		(1 + PARAMS + 8 + 32 + 16)
+
+// Maximum size of the message (larger inputs are truncated)
+#define MAX_MESSAGE	(1 << 20)
+
+// Offset of the unaligned buffer
+#define UNALIGNED	3
+
+// Byte of the untouched output (unwritten bytes of the output are found)
+#define POISON		0xA5
+
+// Standalone driver: default number of the inputs, maximum size of the message, file of the crash
+#define ITERATIONS	10000
+#define MAX_BYTES	(1 << 18)
+#define CRASH_FILE	"fuzz-crash.bin"
+
+// Union all structures eSTREAM project
+union context {
+	struct salsa_context salsa;
+	struct rabbit_context rabbit;
+	struct hc128_context hc128;
+	struct sosemanuk_context sosemanuk;
+	struct grain_context grain;
+	struct mickey_context mickey;
+	struct trivium_context trivium;
+	struct gost89_context gost89;
+};
+
+// Union all structures HASH functions
+union hash_context {
+	struct md5_context md5;
+	struct sha1_context sha1;
+	struct sha224_context sha224;
+	struct sha256_context sha256;
+	struct sha384_context sha384;
+	struct sha512_context sha512;
+	struct sha3_context sha3;
+	struct k12_context k12;
+	struct blake3_context blake3;
+};
+
+// Union all exported states of the HASH functions
+union hash_state {
+	uint8_t md5[MD5_STATE_SIZE];
+	uint8_t sha1[SHA1_STATE_SIZE];
+	uint8_t sha224[SHA224_STATE_SIZE];
+	uint8_t sha256[SHA256_STATE_SIZE];
+	uint8_t sha384[SHA384_STATE_SIZE];
+	uint8_t sha512[SHA512_STATE_SIZE];
+	uint8_t sha3[SHA3_STATE_SIZE];
+	uint8_t k12[K12_STATE_SIZE];
+	uint8_t blake3[BLAKE3_STATE_SIZE];
+};
+
+typedef int (*set_t)(void *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen);
+typedef void (*crypt_t)(void *ctx, uint8_t *buf, uint32_t buflen, uint8_t *out);
+
+// GOST 28147-89 in the gamma mode: the IV is the gamma
+static int
+gost89_set_key_and_iv(struct gost89_context *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen)
+{
+	return gost89_set_key_and_gamma(ctx, key, keylen, iv);
+}
+
+// Pointer of the function eSTREAM project
+static const set_t set[] = { (set_t)salsa_set_key_and_iv,
+			     (set_t)rabbit_set_key_and_iv,
+			     (set_t)hc128_set_key_and_iv,
+			     (set_t)sosemanuk_set_key_and_iv,
+			     (set_t)grain_set_key_and_iv,
+			     (set_t)mickey_set_key_and_iv,
+			     (set_t)trivium_set_key_and_iv,
+			     (set_t)gost89_set_key_and_iv };
+
+static const crypt_t crypt[] = { (crypt_t)salsa_crypt,
+				 (crypt_t)rabbit_crypt,
+				 (crypt_t)hc128_crypt,
+				 (crypt_t)sosemanuk_crypt,
+				 (crypt_t)grain_crypt,
+				 (crypt_t)mickey_crypt,
+				 (crypt_t)trivium_crypt,
+				 (crypt_t)gost89_gamma_crypt };
+
+// Maximum length secret key and IV, the size of the block of the crypt (the keystream goes on after the full blocks)
+static const int keylen[NCIPHERS] = { 32, 16, 16, 32, 16, 10, 10, 32 };
+static const int ivlen[NCIPHERS] =  {  8,  8, 16, 16, 12, 10, 10,  8 };
+static const int block[NCIPHERS] =  { 64, 16, 64, 80,  1,  1,  4,  8 };
+
+typedef int (*ref_crypt_t)(const uint8_t *key, int keylen, const uint8_t *iv, int ivlen, const uint8_t *buf, uint32_t len, uint8_t *out);
+
+// Scalar code of the ciphers with the vector kernels (ESTREAM_NO_SIMD), NULL - no vector kernel
+static const ref_crypt_t ref_crypt[NCIPHERS] = { salsa_ref_crypt, rabbit_ref_crypt, NULL, NULL, NULL, NULL, NULL, NULL };
+
+static const char *cipher_name[NCIPHERS] = { "Salsa", "Rabbit", "HC128", "Sosemanuk", "Grain", "Mickey", "Trivium", "GOST89" };
+
+static const char *hash_name[NHASHES] = { "MD5", "SHA1", "SHA224", "SHA256", "SHA384", "SHA512",
+					  "SHA3-224", "SHA3-256", "SHA3-384", "SHA3-512", "K12", "BLAKE3" };
+
+// Size of the hash in bytes
+static const int hash_size[NHASHES] = { 16, 20, 28, 32, 48, 64, 28, 32, 48, 64, 32, 32 };
+
+// Size of the block of the HASH functions of the HMAC (key longer than the block is hashed)
+static const int hmac_block[HMAC_SHA3_512 + 1] = { 64, 64, 64, 64, 128, 128, 144, 136, 104, 72 };
+
+// Kernels of the SIMD lanes (limit of the lanes, the first is the scalar reference)
+const int blake3_kernel[] = { 1, 4, 8, 16 };
+const int sha3x_kernel[] = { 1, 4, 8 };
+
+/*
+ * Input of the fuzz test
+ * target - number of the target (ciphers, hashes, HMAC, PBKDF2)
+ * param - parameters of the target
+ * seed - state of the generator of the chunk boundaries
+ * key, iv - secret key and IV of the ciphers (salt of the PBKDF2)
+ * message - the message, msglen - size in bytes of the message
+*/
+struct input {
+	int target;
+	uint8_t param[PARAMS];
+	uint64_t seed;
+	uint8_t key[32];
+	uint8_t iv[16];
+	const uint8_t *message;
+	uint32_t msglen;
+};
+
+// Input of the standalone driver (written to the file of the crash)
+static const uint8_t *fuzz_data;
+static size_t fuzz_size;
+static int save_crash;
+
+// Generator of the chunk boundaries (xorshift64*)
+static uint64_t
+next(uint64_t *seed)
+{
+	*seed ^= *seed >> 12;
+	*seed ^= *seed << 25;
+	*seed ^= *seed >> 27;
+
+	return *seed * 0x2545F4914F6CDD1DULL;
+}
+
+// Size of the next chunk: zero, small, around the blocks or large (up to the rest of the message)
+// unit - the chunk is the multiple of the unit (except the last chunk)
+static uint32_t
+chunk(uint64_t *seed, uint32_t rest, int unit)
+{
+	uint64_t r = next(seed);
+	uint32_t len;
+
+	switch(r & 3) {
+	case 0 : len = (r >> 8) % 4;
+		 break;
+	case 1 : len = (r >> 8) % 300;
+		 break;
+	case 2 : len = (r >> 8) % 20000;
+		 break;
+	default : len = rest;
+		  break;
+	}
+
+	if(len >= rest)
+		return rest;
+
+	return len - len % unit;
+}
+
+// Write the input of the crash
+static void
+crash_write(void)
+{
+	FILE *fp;
+
+	if((!save_crash) || ((fp = fopen(CRASH_FILE, "wb")) == NULL))
+		return;
+
+	fwrite(fuzz_data, 1, fuzz_size, fp);
+	fclose(fp);
+
+	fprintf(stderr, "Input is written to the %s\n", CRASH_FILE);
+}
+
+// Compare the result of the variant with the reference, abort if different
+static void
+check(const char *name, const char *variant, const struct input *in, const uint8_t *ref, const uint8_t *res, uint32_t len)
+{
+	uint32_t i;
+
+	for(i = 0; i < len; i++)
+		if(ref[i] != res[i])
+			break;
+
+	if(i == len)
+		return;
+
+	fprintf(stderr, "MISMATCH: %s, %s, message %u bytes, param %02x%02x%02x%02x%02x%02x%02x, offset %u: %02x, expected %02x\n",
+		name, variant, in->msglen, in->param[0], in->param[1], in->param[2], in->param[3],
+		in->param[4], in->param[5], in->param[6], i, res[i], ref[i]);
+
+	crash_write();
+	abort();
+}
+
+// Abort if the function is failed
+static void
+require(int ok, const char *name, const char *what)
+{
+	if(ok)
+		return;
+
+	fprintf(stderr, "FAILED: %s, %s\n", name, what);
+
+	crash_write();
+	abort();
+}
+
+// Set the key and the IV of the cipher
+static void
+cipher_set(int alg, union context *ctx, struct input *in)
+{
+	require(set[alg](ctx, in->key, keylen[alg], in->iv, ivlen[alg]) == 0, cipher_name[alg], "set key and IV");
+}
+
+// Ciphers: the reference is the keystream of the one block per call
+static void
+cipher_test(int alg, struct input *in)
+{
+	union context ctx;
+	uint32_t len = in->msglen, pos, n;
+	uint8_t *ref, *ks, *out, *buf;
+	uint64_t seed = in->seed;
+	const char *name = cipher_name[alg];
+
+	ref = malloc(len + 1);
+	ks = malloc(len + 1);
+	out = malloc(len + 1);
+	buf = malloc(len + UNALIGNED + 1);
+	require((ref != NULL) && (ks != NULL) && (out != NULL) && (buf != NULL), name, "malloc");
+
+	// Reference: keystream block by block, the tail is the last call
+	memset(ks, 0, len);
+	cipher_set(alg, &ctx, in);
+
+	for(pos = 0; pos < len; pos += n) {
+		n = (len - pos < block[alg]) ? len - pos : block[alg];
+		crypt[alg](&ctx, ks + pos, n, ks + pos);
+	}
+
+	for(pos = 0; pos < len; pos++)
+		ref[pos] = in->message[pos] ^ ks[pos];
+
+	// Scalar code against the vector kernels of the library (the reference is the scalar one)
+	if(ref_crypt[alg] != NULL) {
+		memset(out, POISON, len);
+		require(ref_crypt[alg](in->key, keylen[alg], in->iv, ivlen[alg], in->message, len, out) == 0, name, "set key and IV (scalar)");
+		check(name, "scalar (ESTREAM_NO_SIMD)", in, out, ref, len);
+	}
+
+	// One-shot crypt, the poison finds the unwritten bytes
+	memset(out, POISON, len);
+	cipher_set(alg, &ctx, in);
+	crypt[alg](&ctx, (uint8_t *)in->message, len, out);
+	check(name, "oneshot", in, ref, out, len);
+
+	// Random chunks: multiples of the block, the tail is the last chunk
+	memset(out, POISON, len);
+	cipher_set(alg, &ctx, in);
+
+	for(pos = 0; pos < len; pos += n) {
+		n = chunk(&seed, len - pos, block[alg]);
+		crypt[alg](&ctx, (uint8_t *)in->message + pos, n, out + pos);
+	}
+
+	check(name, "chunks", in, ref, out, len);
+
+	// Unaligned in-place crypt
+	memcpy(buf + UNALIGNED, in->message, len);
+	cipher_set(alg, &ctx, in);
+	crypt[alg](&ctx, buf + UNALIGNED, len, buf + UNALIGNED);
+	check(name, "unaligned in-place", in, ref, buf + UNALIGNED, len);
+
+	// Decryption of the ciphertext is the message
+	memset(out, POISON, len);
+	cipher_set(alg, &ctx, in);
+	crypt[alg](&ctx, ref, len, out);
+	check(name, "decrypt", in, in->message, out, len);
+
+	free(ref);
+	free(ks);
+	free(out);
+	free(buf);
+}
+
+// Initialization of the HASH function, threads - number of the threads (K12, BLAKE3)
+// lanes - limit of the SIMD lanes of the one thread (BLAKE3), 0 - all lanes of the processor
+static void
+hash_init(int alg, union hash_context *ctx, int threads, int lanes)
+{
+	switch(alg) {
+	case 0 : md5_init(&ctx->md5);
+		 break;
+	case 1 : sha1_init(&ctx->sha1);
+		 break;
+	case 2 : sha224_init(&ctx->sha224);
+		 break;
+	case 3 : sha256_init(&ctx->sha256);
+		 break;
+	case 4 : sha384_init(&ctx->sha384);
+		 break;
+	case 5 : sha512_init(&ctx->sha512);
+		 break;
+	case 10 : require(k12_init(&ctx->k12, threads) == 0, hash_name[alg], "init");
+		  break;
+	case 11 : if(threads > 1)
+			require(blake3_init_threads(&ctx->blake3, threads) == 0, hash_name[alg], "init");
+		  else
+			blake3_init_lanes(&ctx->blake3, lanes);
+		  break;
+	default : sha3_init(&ctx->sha3, hash_size[alg] * 8);
+		  break;
+	}
+}
+
+static void
+hash_update(int alg, union hash_context *ctx, const uint8_t *message, uint32_t msglen)
+{
+	switch(alg) {
+	case 0 : md5_update(&ctx->md5, message, msglen);
+		 break;
+	case 1 : sha1_update(&ctx->sha1, message, msglen);
+		 break;
+	case 2 : sha224_update(&ctx->sha224, message, msglen);
+		 break;
+	case 3 : sha256_update(&ctx->sha256, message, msglen);
+		 break;
+	case 4 : sha384_update(&ctx->sha384, message, msglen);
+		 break;
+	case 5 : sha512_update(&ctx->sha512, message, msglen);
+		 break;
+	case 10 : k12_update(&ctx->k12, message, msglen);
+		  break;
+	case 11 : blake3_update(&ctx->blake3, message, msglen);
+		  break;
+	default : sha3_update(&ctx->sha3, (void *)message, msglen);
+		  break;
+	}
+}
+
+static void
+hash_final(int alg, union hash_context *ctx, uint8_t *digest)
+{
+	switch(alg) {
+	case 0 : md5_final(&ctx->md5, digest);
+		 break;
+	case 1 : sha1_final(&ctx->sha1, digest);
+		 break;
+	case 2 : sha224_final(&ctx->sha224, digest);
+		 break;
+	case 3 : sha256_final(&ctx->sha256, digest);
+		 break;
+	case 4 : sha384_final(&ctx->sha384, digest);
+		 break;
+	case 5 : sha512_final(&ctx->sha512, digest);
+		 break;
+	case 10 : k12_final(&ctx->k12, digest);
+		  break;
+	case 11 : blake3_final(&ctx->blake3, digest);
+		  break;
+	default : sha3_final(&ctx->sha3, digest);
+		  break;
+	}
+}
+
+static void
+hash_export(int alg, union hash_context *ctx, union hash_state *state)
+{
+	switch(alg) {
+	case 0 : md5_export_state(&ctx->md5, state->md5);
+		 break;
+	case 1 : sha1_export_state(&ctx->sha1, state->sha1);
+		 break;
+	case 2 : sha224_export_state(&ctx->sha224, state->sha224);
+		 break;
+	case 3 : sha256_export_state(&ctx->sha256, state->sha256);
+		 break;
+	case 4 : sha384_export_state(&ctx->sha384, state->sha384);
+		 break;
+	case 5 : sha512_export_state(&ctx->sha512, state->sha512);
+		 break;
+	case 10 : k12_export_state(&ctx->k12, state->k12);
+		  break;
+	case 11 : blake3_export_state(&ctx->blake3, state->blake3);
+		  break;
+	default : sha3_export_state(&ctx->sha3, state->sha3);
+		  break;
+	}
+}
+
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+hash_import(int alg, union hash_context *ctx, const union hash_state *state)
+{
+	switch(alg) {
+	case 0 : return md5_import_state(&ctx->md5, state->md5);
+	case 1 : return sha1_import_state(&ctx->sha1, state->sha1);
+	case 2 : return sha224_import_state(&ctx->sha224, state->sha224);
+	case 3 : return sha256_import_state(&ctx->sha256, state->sha256);
+	case 4 : return sha384_import_state(&ctx->sha384, state->sha384);
+	case 5 : return sha512_import_state(&ctx->sha512, state->sha512);
+	case 10 : return k12_import_state(&ctx->k12, state->k12);
+	case 11 : return blake3_import_state(&ctx->blake3, state->blake3);
+	default : return sha3_import_state(&ctx->sha3, state->sha3);
+	}
+}
+
+// Hash of the message by the random chunks
+static void
+hash_chunks(int alg, int threads, int lanes, const struct input *in, uint64_t *seed, uint8_t *digest)
+{
+	union hash_context ctx;
+	uint32_t pos, n;
+
+	hash_init(alg, &ctx, threads, lanes);
+
+	for(pos = 0; pos < in->msglen; pos += n) {
+		n = chunk(seed, in->msglen - pos, 1);
+		hash_update(alg, &ctx, in->message + pos, n);
+	}
+
+	hash_final(alg, &ctx, digest);
+}
+
+// SHA3x: the messages are the random parts of the message, every hash is compared with the scalar SHA3
+static void
+sha3x_test(int alg, const struct input *in, uint64_t *seed)
+{
+	union hash_context ctx;
+	const void *message[SHA3X_MAX_LANES * 2 + 1];
+	uint32_t msglen[SHA3X_MAX_LANES * 2 + 1];
+	uint8_t digest[SHA3X_MAX_LANES * 2 + 1][64], ref[64];
+	uint8_t *out[SHA3X_MAX_LANES * 2 + 1];
+	uint32_t start;
+	int i, k, n = in->param[2] % (SHA3X_MAX_LANES * 2 + 1) + 1;
+	char variant[32];
+
+	for(i = 0; i < n; i++) {
+		start = (in->msglen > 0) ? next(seed) % in->msglen : 0;
+		message[i] = in->message + start;
+		msglen[i] = (in->msglen > start) ? next(seed) % (in->msglen - start + 1) : 0;
+		out[i] = digest[i];
+	}
+
+	for(k = 0; k < (int)(sizeof(sha3x_kernel) / sizeof(int)); k++) {
+		memset(digest, POISON, sizeof(digest));
+		sha3x_hash_lanes(hash_size[alg] * 8, n, message, msglen, out, sha3x_kernel[k]);
+
+		for(i = 0; i < n; i++) {
+			hash_init(alg, &ctx, 1, 1);
+			hash_update(alg, &ctx, message[i], msglen[i]);
+			hash_final(alg, &ctx, ref);
+
+			snprintf(variant, sizeof(variant), "sha3x %d lanes, message %d", sha3x_kernel[k], i);
+			check(hash_name[alg], variant, in, ref, digest[i], hash_size[alg]);
+		}
+	}
+}
+
+// HASH functions: the reference is the one update of the scalar kernel by the one thread
+static void
+hash_test(int alg, struct input *in)
+{
+	union hash_context ctx;
+	union hash_state *state;
+	uint8_t ref[64], digest[64];
+	uint64_t seed = in->seed;
+	uint32_t split;
+	int k, threads = (in->param[1] & 1) ? 4 : 2;
+	const char *name = hash_name[alg];
+	char variant[32];
+
+	hash_init(alg, &ctx, 1, 1);
+	hash_update(alg, &ctx, in->message, in->msglen);
+	hash_final(alg, &ctx, ref);
+
+	// Random chunks
+	hash_chunks(alg, 1, 1, in, &seed, digest);
+	check(name, "chunks", in, ref, digest, hash_size[alg]);
+
+	// Export of the state at the random point, import to the new context
+	state = malloc(sizeof(union hash_state));
+	require(state != NULL, name, "malloc");
+
+	split = (in->msglen > 0) ? next(&seed) % (in->msglen + 1) : 0;
+
+	hash_init(alg, &ctx, 1, 1);
+	hash_update(alg, &ctx, in->message, split);
+	hash_export(alg, &ctx, state);
+	hash_final(alg, &ctx, digest);
+
+	hash_init(alg, &ctx, 1, 1);
+	require(hash_import(alg, &ctx, state) == 0, name, "import of the state");
+	hash_update(alg, &ctx, in->message + split, in->msglen - split);
+	hash_final(alg, &ctx, digest);
+	check(name, "export and import", in, ref, digest, hash_size[alg]);
+
+	free(state);
+
+	// SIMD kernels and threads
+	if(alg == 11) {
+		for(k = 1; k < (int)(sizeof(blake3_kernel) / sizeof(int)); k++) {
+			hash_chunks(alg, 1, blake3_kernel[k], in, &seed, digest);
+
+			snprintf(variant, sizeof(variant), "%d lanes", blake3_kernel[k]);
+			check(name, variant, in, ref, digest, hash_size[alg]);
+		}
+	}
+
+	if((alg >= 6) && (alg <= 9))
+		sha3x_test(alg, in, &seed);
+
+	// Threads of the large messages (the parts of the update are hashed by the thread pool)
+	if(((alg == 10) || (alg == 11)) && (in->param[1] & 2)) {
+		hash_chunks(alg, threads, 0, in, &seed, digest);
+
+		snprintf(variant, sizeof(variant), "%d threads", threads);
+		check(name, variant, in, ref, digest, hash_size[alg]);
+	}
+}
+
+// Hash of the message by the HMAC hash function (the hashes of the HMAC are the hashes 0 - 9)
+static void
+hmac_hash(int alg, const uint8_t *a, uint32_t alen, const uint8_t *b, uint32_t blen, uint8_t *digest)
+{
+	union hash_context ctx;
+
+	hash_init(alg, &ctx, 1, 0);
+	hash_update(alg, &ctx, a, alen);
+	hash_update(alg, &ctx, b, blen);
+	hash_final(alg, &ctx, digest);
+}
+
+// Reference HMAC (RFC 2104): H((K ^ opad) || H((K ^ ipad) || message))
+static void
+hmac_ref(int alg, const uint8_t *k, uint32_t keylen, const uint8_t *message, uint32_t msglen, uint8_t *digest)
+{
+	uint8_t key[HMAC_MAX_BLOCK], pad[HMAC_MAX_BLOCK], inner[HMAC_MAX_SIZE];
+	int i;
+
+	memset(key, 0, sizeof(key));
+
+	if(keylen > hmac_block[alg])
+		hmac_hash(alg, k, keylen, k, 0, key);
+	else
+		memcpy(key, k, keylen);
+
+	for(i = 0; i < hmac_block[alg]; i++)
+		pad[i] = key[i] ^ 0x36;
+
+	hmac_hash(alg, pad, hmac_block[alg], message, msglen, inner);
+
+	for(i = 0; i < hmac_block[alg]; i++)
+		pad[i] = key[i] ^ 0x5C;
+
+	hmac_hash(alg, pad, hmac_block[alg], inner, hash_size[alg], digest);
+}
+
+// HMAC: the key is the beginning of the message, the message is the rest
+static void
+hmac_test(struct input *in)
+{
+	struct hmac_key key;
+	struct hmac_context ctx;
+	uint8_t ref[HMAC_MAX_SIZE], digest[HMAC_MAX_SIZE];
+	uint64_t seed = in->seed;
+	uint32_t keylen, pos, n;
+	int alg = in->param[0] % (HMAC_SHA3_512 + 1);
+	const uint8_t *message;
+	uint32_t msglen;
+
+	keylen = (in->param[1] < in->msglen) ? in->param[1] : in->msglen;
+	message = in->message + keylen;
+	msglen = in->msglen - keylen;
+
+	hmac_ref(alg, in->message, keylen, message, msglen, ref);
+
+	require(hmac_set_key(&key, alg, in->message, keylen) == 0, hash_name[alg], "HMAC key");
+
+	memset(digest, POISON, sizeof(digest));
+	hmac(&key, message, msglen, digest);
+	check(hash_name[alg], "HMAC oneshot", in, ref, digest, hash_size[alg]);
+
+	memset(digest, POISON, sizeof(digest));
+	hmac_init(&ctx, &key);
+
+	for(pos = 0; pos < msglen; pos += n) {
+		n = chunk(&seed, msglen - pos, 1);
+		hmac_update(&ctx, message + pos, n);
+	}
+
+	hmac_final(&ctx, digest);
+	check(hash_name[alg], "HMAC chunks", in, ref, digest, hash_size[alg]);
+}
+
+// Reference PBKDF2 (RFC 8018) by the hmac
+static void
+pbkdf2_ref(int alg, const uint8_t *password, uint32_t passlen, const uint8_t *salt, uint32_t saltlen,
+	   uint32_t iterations, uint8_t *out, uint32_t outlen)
+{
+	struct hmac_key key;
+	uint8_t s[sizeof(((struct input *)0)->key) + 4], u[HMAC_MAX_SIZE], t[HMAC_MAX_SIZE];
+	uint32_t i, j, c, n, size = hash_size[alg];
+
+	require(hmac_set_key(&key, alg, password, passlen) == 0, "PBKDF2", "HMAC key");
+
+	memcpy(s, salt, saltlen);
+
+	for(i = 1; outlen > 0; i++, out += n, outlen -= n) {
+		s[saltlen + 0] = i >> 24;
+		s[saltlen + 1] = i >> 16;
+		s[saltlen + 2] = i >> 8;
+		s[saltlen + 3] = i;
+		hmac(&key, s, saltlen + 4, u);
+		memcpy(t, u, size);
+
+		for(c = 1; c < iterations; c++) {
+			hmac(&key, u, size, u);
+
+			for(j = 0; j < size; j++)
+				t[j] ^= u[j];
+		}
+
+		n = (outlen < size) ? outlen : size;
+		memcpy(out, t, n);
+	}
+}
+
+// PBKDF2: the passwords are the parts of the message, the salt is the key
+static void
+pbkdf2_test(struct input *in)
+{
+	int alg = (in->param[0] & 1) ? PBKDF2_SHA512 : PBKDF2_SHA256;
+	int i, n = in->param[2] % 33 + 1;
+	uint32_t iterations = in->param[3] % 8 + 1;
+	uint32_t saltlen = in->param[4] % (sizeof(in->key) + 1);
+	uint32_t outlen = in->param[5] % (3 * hash_size[alg]) + 1;
+	const uint8_t *password[33];
+	uint32_t passlen[33], pos, size;
+	uint8_t *out[33], *ref, *buf;
+	char variant[32];
+
+	ref = malloc(outlen);
+	buf = malloc(n * outlen);
+	require((ref != NULL) && (buf != NULL), "PBKDF2", "malloc");
+
+	for(i = 0, pos = 0; i < n; i++, pos += size) {
+		size = (in->msglen > pos) ? (in->msglen - pos) / (n - i) : 0;
+		password[i] = in->message + pos;
+		passlen[i] = size;
+		out[i] = buf + i * outlen;
+	}
+
+	memset(buf, POISON, n * outlen);
+	require(pbkdf2_many(alg, n, password, passlen, in->key, saltlen, iterations, out, outlen) == 0, "PBKDF2", "pbkdf2_many");
+
+	for(i = 0; i < n; i++) {
+		pbkdf2_ref(alg, password[i], passlen[i], in->key, saltlen, iterations, ref, outlen);
+
+		snprintf(variant, sizeof(variant), "pbkdf2_many, password %d", i);
+		check(hash_name[alg], variant, in, ref, out[i], outlen);
+
+		if(i == 0) {
+			memset(out[0], POISON, outlen);
+			require(pbkdf2(alg, password[0], passlen[0], in->key, saltlen, iterations, out[0], outlen) == 0, "PBKDF2", "pbkdf2");
+			check(hash_name[alg], "pbkdf2", in, ref, out[0], outlen);
+		}
+	}
+
+	free(ref);
+	free(buf);
+}
+
+// Entry of the fuzz test (libFuzzer)
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct input in;
+	uint8_t header[HEADER];
+	int i;
+
+	// Short input is padded by the zeros
+	memset(header, 0, sizeof(header));
+	memcpy(header, data, (size < HEADER) ? size : HEADER);
+
+	in.target = header[0] % NTARGETS;
+	memcpy(in.param, header + 1, PARAMS);
+
+	for(i = 0, in.seed = 0; i < 8; i++)
+		in.seed = (in.seed << 8) | header[1 + PARAMS + i];
+
+	// The generator does not go out of the zero
+	in.seed ^= 0x9E3779B97F4A7C15ULL;
+
+	memcpy(in.key, header + 1 + PARAMS + 8, sizeof(in.key));
+	memcpy(in.iv, header + 1 + PARAMS + 8 + sizeof(in.key), sizeof(in.iv));
+
+	in.message = data + HEADER;
+	in.msglen = (size > HEADER) ? size - HEADER : 0;
+
+	if(in.msglen > MAX_MESSAGE)
+		in.msglen = MAX_MESSAGE;
+
+	if(in.target < NCIPHERS)
+		cipher_test(in.target, &in);
+	else if(in.target < NCIPHERS + NHASHES)
+		hash_test(in.target - NCIPHERS, &in);
+	else if(in.target == NCIPHERS + NHASHES)
+		hmac_test(&in);
+	else
+		pbkdf2_test(&in);
+
+	return 0;
+}
+
+#ifndef ESTREAM_LIBFUZZER
+
+// Manual
+static void
+help(void)
+{
+	printf("\nThis program compares the fast paths of the ciphers and the HASH functions with the reference code!\n");
+	printf("\nOptions:\n");
+	printf("\t--help(-h) - reference manual\n");
+	printf("\t--iterations(-n) - number of the random inputs (10000 by default)\n");
+	printf("\t--seed(-s) - seed of the random inputs (the time by default)\n");
+	printf("\t--max(-M) - maximum size of the message (256K by default), suffix K, M\n");
+	printf("\t--target(-t) - only the target: 0 - 7 ciphers, 8 - 19 hashes, 20 - HMAC, 21 - PBKDF2\n");
+	printf("\nThe files of the arguments are the inputs (the replay of the crash or of the corpus of the libFuzzer).\n");
+	printf("\nExample: ./estream_fuzz -n 100000 or ./estream_fuzz -s 42 -M 1M or ./estream_fuzz fuzz-crash.bin\n\n");
+}
+
+// Size with the suffix K or M
+static uint32_t
+parse_size(const char *str)
+{
+	char *end;
+	unsigned long size = strtoul(str, &end, 10);
+
+	if((*end == 'K') || (*end == 'k'))
+		size <<= 10;
+	else if((*end == 'M') || (*end == 'm'))
+		size <<= 20;
+
+	return (size > MAX_MESSAGE) ? MAX_MESSAGE : size;
+}
+
+// Replay of the input file
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+replay(const char *path)
+{
+	FILE *fp;
+	uint8_t *data;
+	long size;
+
+	if((fp = fopen(path, "rb")) == NULL) {
+		fprintf(stderr, "File %s is not opened!\n", path);
+		return -1;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if((size < 0) || ((data = malloc(size + 1)) == NULL) || (fread(data, 1, size, fp) != size)) {
+		fprintf(stderr, "File %s is not read!\n", path);
+		fclose(fp);
+		return -1;
+	}
+
+	fclose(fp);
+
+	printf("%s: %ld bytes, target %d\n", path, size, (size > 0) ? data[0] % NTARGETS : 0);
+
+	LLVMFuzzerTestOneInput(data, size);
+
+	free(data);
+
+	return 0;
+}
+
+// Random inputs: the size of the message is spread over the orders (the tails and the multi-chunk sizes)
+static void
+random_inputs(uint64_t seed, uint64_t iterations, uint32_t max, int target)
+{
+	uint8_t *data;
+	uint64_t it, r;
+	uint32_t size, i;
+
+	data = malloc(HEADER + max + 8);
+	require(data != NULL, "estream_fuzz", "malloc");
+
+	seed ^= 0x9E3779B97F4A7C15ULL;
+
+	for(it = 0; it < iterations; it++) {
+		r = next(&seed);
+		size = (uint32_t)((r >> 32) % (max + 1)) >> ((r >> 8) % 20);
+
+		for(i = 0; i < HEADER + size; i += 8) {
+			r = next(&seed);
+			memcpy(data + i, &r, 8);
+		}
+
+		if(target >= 0)
+			data[0] = target;
+
+		fuzz_data = data;
+		fuzz_size = HEADER + size;
+
+		LLVMFuzzerTestOneInput(data, HEADER + size);
+
+		if((it + 1) % 1000 == 0) {
+			printf("%llu inputs\r", (unsigned long long)(it + 1));
+			fflush(stdout);
+		}
+	}
+
+	printf("%llu inputs are passed\n", (unsigned long long)iterations);
+
+	free(data);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int result, option_index = 0, target = -1, i;
+	uint64_t iterations = ITERATIONS, seed = time(NULL);
+	uint32_t max = MAX_BYTES;
+
+	const struct option long_option[] = {
+		{"help",	no_argument,		NULL,	'h'},
+		{"iterations",	required_argument,	NULL,	'n'},
+		{"seed",	required_argument,	NULL,	's'},
+		{"max",		required_argument,	NULL,	'M'},
+		{"target",	required_argument,	NULL,	't'},
+		{NULL,		0,			NULL,	0}
+	};
+
+	while((result = getopt_long(argc, argv, "hn:s:M:t:", long_option, &option_index)) != -1) {
+		switch(result) {
+		case 'h' : help();
+			   return 0;
+		case 'n' : iterations = strtoull(optarg, NULL, 10);
+			   break;
+		case 's' : seed = strtoull(optarg, NULL, 10);
+			   break;
+		case 'M' : max = parse_size(optarg);
+			   break;
+		case 't' : target = atoi(optarg);
+			   if((target < 0) || (target >= NTARGETS)) {
+				fprintf(stderr, "Target is bad!\n");
+				return 1;
+			   }
+			   break;
+		default : help();
+			  return 1;
+		}
+	}
+
+	if(optind < argc) {
+		for(i = optind; i < argc; i++)
+			if(replay(argv[i]) < 0)
+				return 1;
+
+		return 0;
+	}
+
+	printf("Seed %llu, maximum message %u bytes\n", (unsigned long long)seed, max);
+
+	save_crash = 1;
+	random_inputs(seed, iterations, max, target);
+
+	return 0;
+}
+
+#endif /* ESTREAM_LIBFUZZER */
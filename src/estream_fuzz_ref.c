@@ -0,0 +1,52 @@
+/*
+ * Scalar reference of the vector kernels for the fuzz test (estream_fuzz.c)
+ * The ciphers are included by the header-only inline mode (ESTREAM_INLINE): the static copies
+ * of this file are compiled with the ESTREAM_NO_SIMD, the Rabbit next-state is the G_FUNC loop
+ * and the Salsa20 is one block at a time (no salsa20_x4).
+*/
+
+#define ESTREAM_INLINE
+#define ESTREAM_NO_SIMD
+
+#include <stdint.h>
+
+#include "salsa.h"
+#include "rabbit.h"
+#include "estream_fuzz_ref.h"
+
+#define SALSA_BLOCK	64
+#define RABBIT_BLOCK	16
+
+int
+salsa_ref_crypt(const uint8_t *key, int keylen, const uint8_t *iv, int ivlen, const uint8_t *buf, uint32_t len, uint8_t *out)
+{
+	struct salsa_context ctx;
+	uint32_t n;
+
+	if(salsa_set_key_and_iv(&ctx, key, keylen, iv, ivlen))
+		return -1;
+
+	for(; len > 0; len -= n, buf += n, out += n) {
+		n = (len < SALSA_BLOCK) ? len : SALSA_BLOCK;
+		salsa_crypt(&ctx, buf, n, out);
+	}
+
+	return 0;
+}
+
+int
+rabbit_ref_crypt(const uint8_t *key, int keylen, const uint8_t *iv, int ivlen, const uint8_t *buf, uint32_t len, uint8_t *out)
+{
+	struct rabbit_context ctx;
+	uint32_t n;
+
+	if(rabbit_set_key_and_iv(&ctx, key, keylen, iv, ivlen))
+		return -1;
+
+	for(; len > 0; len -= n, buf += n, out += n) {
+		n = (len < RABBIT_BLOCK) ? len : RABBIT_BLOCK;
+		rabbit_crypt(&ctx, buf, n, out);
+	}
+
+	return 0;
+}
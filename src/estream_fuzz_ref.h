@@ -0,0 +1,17 @@
+/*
+ * Scalar reference of the vector kernels of the ciphers (estream_fuzz_ref.c)
+ * The ciphers are compiled with the ESTREAM_NO_SIMD (estream_simd() is 0), the fuzz test
+ * compares the keystream of the library (vector kernels) with the keystream of the scalar code.
+*/
+
+#ifndef ESTREAM_FUZZ_REF_H
+#define ESTREAM_FUZZ_REF_H
+
+#include <stdint.h>
+
+// out = buf ^ keystream of the scalar code, the keystream is made one block per call
+// Return value: 0 or -1 (bad key or IV)
+int salsa_ref_crypt(const uint8_t *key, int keylen, const uint8_t *iv, int ivlen, const uint8_t *buf, uint32_t len, uint8_t *out);
+int rabbit_ref_crypt(const uint8_t *key, int keylen, const uint8_t *iv, int ivlen, const uint8_t *buf, uint32_t len, uint8_t *out);
+
+#endif /* ESTREAM_FUZZ_REF_H */
@@ -2,25 +2,50 @@
  * This program tests the algorithms eSTREAM project to speed perfomance
  * Makefile: Makefile_speed
  * Compile: make -f Makefile_speed
- * Example: ./estream_speed_test -h ./estream_speed_test -a 1 
+ * Example: ./estream_speed_test -h or ./estream_speed_test -a 1 or ./estream_speed_test -M 1M -F csv -o speed.csv
+ * or ./estream_speed_test -l -p 64,1500 or ./estream_speed_test -a 0,1 -j 1,2,4,8 -c 0-7
+ * Every cipher is measured on the messages from 16 bytes to 1 GB (every size is 4 times larger),
+ * the setup of the key and IV is measured separately.
+ * Every size: warm-up, then the samples, the result is the mean and the 95% confidence interval.
+ * Latency mode (-l): every message is the setup of the key and IV and the crypt of the short payload
+ * (the messages of the client-server application), the result is the percentiles of the time of the message.
+ * Scaling mode (-j): N threads, every thread has its own context and buffer and is pinned to the processor,
+ * the result is the total speed, the efficiency against the first number of the threads and the part
+ * of the memcpy speed of the same threads (the cipher is memory-bound if it is near the memcpy).
+ * The efficiency falling before the memcpy roofline is the contention of the shared tables and caches.
+ * Hardware counters (-P): the samples are counted by the perf_event_open (cycles, instructions, branch misses,
+ * L1D and LLC misses), the result is the IPC and the events per byte (branch-bound or cache-bound kernels).
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <getopt.h>
-#include <sys/time.h>
 
 #include "estream.h"
+#include "bench.h"
 
-#define BUFLEN		100000000
+// Number of the algorithms
+#define NALGS		8
 
-// Struct for time value
-struct timeval t1, t2;
+// Default sizes of the messages, bytes
+#define MIN_BYTES	16
+#define MAX_BYTES	(1 << 30)
 
-uint8_t buf[BUFLEN];
-uint8_t out1[BUFLEN];
-uint8_t out2[BUFLEN];
+// Default number of the samples and the time of the one size, s
+#define SAMPLES		10
+#define BUDGET		2.0
+
+// Latency mode: maximum number of the payload sizes, default number of the messages,
+// minimum number of the messages (p99.9), number of the warm-up messages
+#define MAX_PAYLOADS	16
+#define MESSAGES	100000
+#define MIN_MESSAGES	1000
+#define WARMUP_MESSAGES	100
+
+// Scaling mode: default size of the buffer of the thread, bytes (larger than the caches)
+#define THREAD_BYTES	(64 << 20)
 
 // Secret key
 uint8_t key[32] = { 0x00, 0x11, 0x22, 0x33,
@@ -38,30 +63,6 @@ uint8_t iv[16] = { 0x01, 0x23, 0x45, 0x67,
 		   0x01, 0x23, 0x45, 0x67,
 		   0x89, 0xAB, 0xCD, 0xEF };
 
-// Time start
-static void
-time_start(void)
-{
-	gettimeofday(&t1, NULL);
-}
-
-// Time stop
-static uint32_t
-time_stop(void)
-{
-	gettimeofday(&t2, NULL);
-
-	t2.tv_sec -= t1.tv_sec;
-	t2.tv_usec -= t1.tv_usec;
-
-	if(t2.tv_usec < 0) {
-		t2.tv_sec--;
-		t2.tv_usec += 1000000;
-	}
-	
-	return (t2.tv_sec * 1000 + t2.tv_usec/1000);
-}
-
 // Manual
 static void
 help(void)
@@ -69,10 +70,33 @@ help(void)
 	printf("\nThis program provides the user interface for testing algorithms project eSTREAM on speed test!\n");
 	printf("\nOptions:\n");
 	printf("\t--help(-h) - reference manual\n");
-	printf("\t--algorithm(-a) - selection algorithm:\n");
+	printf("\t--algorithm(-a) - selection algorithm, the list (-a 0,2,4), all by default:\n");
 	printf("\t\t0 - Salsa\n\t\t1 - Rabbit\n\t\t2 - HC128\n\t\t3 - Sosemanuk\n");
-	printf("\t\t4 - Grain\n\t\t5 - Mickey\n\t\t6 - Trivium\n");
-	printf("\nExample: ./estream_testvectors -h or ./estream_testvectors -a 1\n\n");
+	printf("\t\t4 - Grain\n\t\t5 - Mickey\n\t\t6 - Trivium\n\t\t7 - GOST 28147-89 (gamma)\n");
+	printf("\t--min(-m) - minimum size of the message (16 by default), suffix K, M, G\n");
+	printf("\t--max(-M) - maximum size of the message (1G by default)\n");
+	printf("\t--samples(-r) - number of the samples of the one size (10 by default)\n");
+	printf("\t--budget(-b) - time in seconds of the samples of the one size (2 by default)\n");
+	printf("\t--latency(-l) - latency mode: setup of the key and IV and crypt of every message\n");
+	printf("\t--payload(-p) - sizes of the payloads of the latency mode (64,128,256,512,1024,1500 by default)\n");
+	printf("\t--messages(-n) - number of the messages of the one size (100000 by default, the budget may stop earlier)\n");
+	printf("\t--threads(-j) - scaling mode: the numbers of the threads (-j 1,2,4 or -j 1-8, -j auto - 1,2,4,... processors)\n");
+	printf("\t--cpus(-c) - processors of the threads of the scaling mode (-c 0,2,4,6 or -c 0-15), no pinning by default\n");
+	printf("\t--size(-s) - size of the buffer of the one thread of the scaling mode (64M by default)\n");
+	printf("\t--format(-F) - format of the results: text, json, csv\n");
+	printf("\t--output(-o) - file of the results (stdout by default)\n");
+	printf("\t--perf(-P) - hardware counters of the samples (perf_event_open)\n");
+	printf("\nColumns: ns and cycles - time and cycles (time stamp counter) of the one operation,\n");
+	printf("GB/s and cycles/byte of the crypt, *_ci - half-width of the 95%% confidence interval.\n");
+	printf("Latency mode: percentiles of the time of the message in ns (the time includes the clock_gettime),\n");
+	printf("setup_%% - part of the setup of the key and IV of the mean time.\n");
+	printf("Scaling mode: GB/s - total speed of the threads (the budget is the time of the one number of the threads),\n");
+	printf("efficiency_%% - speed of the one thread against the first number of the threads,\n");
+	printf("memcpy_GB/s - copied bytes of the same threads and buffers, roofline_%% - part of the memcpy speed.\n");
+	printf("Hardware counters: IPC - instructions per cycle, instructions, branch misses, L1D and LLC misses\n");
+	printf("per byte (per setup of the key and IV), n/a - the event is not available.\n");
+	printf("\nExample: ./estream_speed_test -h or ./estream_speed_test -a 1 or ./estream_speed_test -M 1M -F csv or ./estream_speed_test -l -p 64,1500\n");
+	printf("or ./estream_speed_test -a 0,1 -j 1,2,4,8 -c 0-7\n\n");
 }
 
 // Union all structures eSTREAM project
@@ -84,109 +108,476 @@ union context {
 	struct grain_context grain;
 	struct mickey_context mickey;
 	struct trivium_context trivium;
+	struct gost89_context gost89;
 };
 
 typedef int (*set_t)(void *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen);
 typedef void (*crypt_t)(void *ctx, uint8_t *buf, uint32_t buflen, uint8_t *out);
 
+// GOST 28147-89 in the gamma mode: the IV is the gamma
+static int
+gost89_set_key_and_iv(struct gost89_context *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen)
+{
+	return gost89_set_key_and_gamma(ctx, key, keylen, iv);
+}
+
 // Pointer of the function eSTREAM project
-set_t set[] = { (set_t)salsa_set_key_and_iv,
-		(set_t)rabbit_set_key_and_iv,
-		(set_t)hc128_set_key_and_iv,
-		(set_t)sosemanuk_set_key_and_iv,
-		(set_t)grain_set_key_and_iv,
-		(set_t)mickey_set_key_and_iv,
-		(set_t)trivium_set_key_and_iv };
-
-crypt_t crypt[] = { (crypt_t)salsa_crypt,
-		    (crypt_t)rabbit_crypt,
-		    (crypt_t)hc128_crypt,
-		    (crypt_t)sosemanuk_crypt,
-		    (crypt_t)grain_crypt,
-		    (crypt_t)mickey_crypt,
-		    (crypt_t)trivium_crypt };
+static const set_t set[] = { (set_t)salsa_set_key_and_iv,
+			     (set_t)rabbit_set_key_and_iv,
+			     (set_t)hc128_set_key_and_iv,
+			     (set_t)sosemanuk_set_key_and_iv,
+			     (set_t)grain_set_key_and_iv,
+			     (set_t)mickey_set_key_and_iv,
+			     (set_t)trivium_set_key_and_iv,
+			     (set_t)gost89_set_key_and_iv };
+
+static const crypt_t crypt[] = { (crypt_t)salsa_crypt,
+				 (crypt_t)rabbit_crypt,
+				 (crypt_t)hc128_crypt,
+				 (crypt_t)sosemanuk_crypt,
+				 (crypt_t)grain_crypt,
+				 (crypt_t)mickey_crypt,
+				 (crypt_t)trivium_crypt,
+				 (crypt_t)gost89_gamma_crypt };
 
 // Maximum length secret key and IV
-const int keylen[7] = { 32, 16, 16, 32, 16, 10, 10 };
-const int ivlen[7] =  {  8,  8, 16, 16, 12, 10, 10 };
+static const int keylen[NALGS] = { 32, 16, 16, 32, 16, 10, 10, 32 };
+static const int ivlen[NALGS] =  {  8,  8, 16, 16, 12, 10, 10,  8 };
+
+// Name of the algorithm
+static const char *alg_name[NALGS] = { "Salsa", "Rabbit", "HC128", "Sosemanuk", "Grain", "Mickey", "Trivium", "GOST89" };
+
+/*
+ * Measured operation
+ * ctx - context of the cipher
+ * alg - algorithm
+ * buf - message, encrypted in place
+ * len - size of the message
+*/
+struct speed_arg {
+	union context ctx;
+	int alg;
+	uint8_t *buf;
+	uint32_t len;
+};
+
+// Setup of the key and IV
+static void
+speed_setup(void *arg, uint64_t iters)
+{
+	struct speed_arg *a = arg;
+	uint64_t i;
 
-// Speed test
+	for(i = 0; i < iters; i++)
+		set[a->alg](&a->ctx, key, keylen[a->alg], iv, ivlen[a->alg]);
+}
+
+// Crypt of the message: the keystream is continued
 static void
-speed_test(void *ctx, int alg)
+speed_crypt(void *arg, uint64_t iters)
 {
-	time_start();
+	struct speed_arg *a = arg;
+	uint64_t i;
+
+	for(i = 0; i < iters; i++)
+		crypt[a->alg](&a->ctx, a->buf, a->len, a->buf);
+}
+
+// Measure the operation and write the record of the results
+// len - size of the message, 0 - setup of the key and IV
+// perf - hardware counters of the samples, NULL - no counters
+static void
+speed_test(struct bench_output *out, struct speed_arg *a, int samples, double budget, struct bench_perf *perf)
+{
+	struct bench_field field[BENCH_MAX_FIELDS];
+	struct bench_stat ns, cycles, gbps, cpb;
+	double t[samples], c[samples], x[samples];
+	uint64_t iters;
+	int n, i, k = 0;
+
+	n = bench_run((a->len > 0) ? speed_crypt : speed_setup, a, samples, budget, t, c, &iters, perf);
+
+	bench_stat(t, n, &ns);
+	bench_stat(c, n, &cycles);
+
+	// Bytes per ns = GB/s
+	for(i = 0; i < n; i++)
+		x[i] = a->len / t[i];
+
+	bench_stat(x, n, &gbps);
+
+	for(i = 0; i < n; i++)
+		x[i] = (a->len > 0) ? c[i] / a->len : 0;
+
+	bench_stat(x, n, &cpb);
+
+	bench_str(&field[k++], "cipher", alg_name[a->alg]);
+	bench_str(&field[k++], "op", (a->len > 0) ? "crypt" : "setup");
+	bench_num(&field[k++], "bytes", a->len, 0);
+	bench_num(&field[k++], "samples", n, 0);
+	bench_num(&field[k++], "iters", iters, 0);
+	bench_num(&field[k++], "ns", ns.mean, 1);
+	bench_num(&field[k++], "ns_ci", ns.ci, 1);
+	bench_num(&field[k++], "cycles", cycles.mean, 1);
+	bench_num(&field[k++], "cycles_ci", cycles.ci, 1);
+	bench_num(&field[k++], "GB/s", gbps.mean, 3);
+	bench_num(&field[k++], "GB/s_ci", gbps.ci, 3);
+	bench_num(&field[k++], "cycles/byte", cpb.mean, 2);
+	bench_num(&field[k++], "cpb_ci", cpb.ci, 2);
 
-	if(set[alg](ctx, key, keylen[alg], iv, ivlen[alg])) {
-		printf("Context filling error!\n");
-		exit(1);
+	if(perf != NULL)
+		k += bench_perf_fields(&field[k], perf, a->len);
+
+	bench_row(out, field, k);
+}
+
+// Latency of the messages: the new IV (number of the message) and the crypt of the payload
+// messages - maximum number of the messages, at least MIN_MESSAGES
+static int
+latency_test(struct bench_output *out, struct speed_arg *a, int messages, double budget)
+{
+	struct bench_field field[BENCH_MAX_FIELDS];
+	struct bench_stat total, setup;
+	double *t, *c;
+	uint64_t t0, t1, t2, start;
+	uint8_t msg_iv[16];
+	int i, n, k = 0;
+
+	if(((t = malloc(messages * sizeof(*t))) == NULL) || ((c = malloc(messages * sizeof(*c))) == NULL)) {
+		free(t);
+		return -1;
 	}
 
-	crypt[alg](ctx, buf, BUFLEN, out1);
+	memcpy(msg_iv, iv, sizeof(msg_iv));
 
-	if(set[alg](ctx, key, keylen[alg], iv, ivlen[alg])) {
-		printf("Context filling error!\n");
-		exit(1);
+	for(i = -WARMUP_MESSAGES, n = 0, start = bench_ns(); i < messages; i++) {
+		if((i >= MIN_MESSAGES) && (bench_ns() - start > budget * 1e9))
+			break;
+
+		U32TO8_LITTLE(msg_iv, i);
+
+		t0 = bench_ns();
+		set[a->alg](&a->ctx, key, keylen[a->alg], msg_iv, ivlen[a->alg]);
+		t1 = bench_ns();
+		crypt[a->alg](&a->ctx, a->buf, a->len, a->buf);
+		t2 = bench_ns();
+
+		if(i >= 0) {
+			t[n] = t2 - t0;
+			c[n++] = t1 - t0;
+		}
 	}
 
-	crypt[alg](ctx, out1, BUFLEN, out2);
+	bench_stat(t, n, &total);
+	bench_stat(c, n, &setup);
+
+	bench_str(&field[k++], "cipher", alg_name[a->alg]);
+	bench_num(&field[k++], "bytes", a->len, 0);
+	bench_num(&field[k++], "messages", n, 0);
+	bench_num(&field[k++], "p50_ns", bench_percentile(t, n, 50), 0);
+	bench_num(&field[k++], "p99_ns", bench_percentile(t, n, 99), 0);
+	bench_num(&field[k++], "p99.9_ns", bench_percentile(t, n, 99.9), 0);
+	bench_num(&field[k++], "max_ns", total.max, 0);
+	bench_num(&field[k++], "mean_ns", total.mean, 1);
+	bench_num(&field[k++], "setup_p50_ns", bench_percentile(c, n, 50), 0);
+	bench_num(&field[k++], "setup_%", 100 * setup.mean / total.mean, 1);
+
+	bench_row(out, field, k);
+
+	free(t);
+	free(c);
+
+	return 0;
+}
+
+// Thread of the scaling mode: own buffer (touched by the pinned thread) and context
+static int
+scaling_setup(void *arg)
+{
+	struct speed_arg *a = arg;
+
+	if(posix_memalign((void **)&a->buf, 64, a->len))
+		return -1;
+
+	memset(a->buf, 0, a->len);
+
+	return set[a->alg](&a->ctx, key, keylen[a->alg], iv, ivlen[a->alg]) ? -1 : 0;
+}
+
+// Write the record of the scaling mode
+// name - cipher, base - speed of the one thread of the first number of the threads, roofline - memcpy speed
+static void
+scaling_row(struct bench_output *out, const char *name, uint32_t len, int threads, double speed, double base, double roofline)
+{
+	struct bench_field field[BENCH_MAX_FIELDS];
+	int k = 0;
+
+	bench_str(&field[k++], "cipher", name);
+	bench_num(&field[k++], "threads", threads, 0);
+	bench_num(&field[k++], "bytes", len, 0);
+	bench_num(&field[k++], "GB/s", speed, 3);
+	bench_num(&field[k++], "GB/s/thread", speed / threads, 3);
+	bench_num(&field[k++], "efficiency_%", 100 * speed / (threads * base), 1);
+	bench_num(&field[k++], "memcpy_GB/s", roofline, 3);
+	bench_num(&field[k++], "roofline_%", 100 * speed / roofline, 1);
+
+	bench_row(out, field, k);
+}
+
+// Scaling of the cipher by the numbers of the threads
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+scaling_test(struct bench_output *out, int alg, uint32_t len, const int *threads, int nthreads,
+	     const int *cpu, int ncpus, double budget, const double *roofline)
+{
+	struct speed_arg *arg[BENCH_MAX_THREADS];
+	double speed, base = 0;
+	int i, j, n;
+
+	for(j = 0; j < nthreads; j++) {
+		// Own cache lines of the every context: no false sharing of the contexts
+		for(n = 0; n < threads[j]; n++) {
+			if(posix_memalign((void **)&arg[n], 64, sizeof(*arg[n])))
+				break;
+
+			arg[n]->alg = alg;
+			arg[n]->buf = NULL;
+			arg[n]->len = len;
+		}
+
+		speed = (n == threads[j]) ? bench_scaling(scaling_setup, speed_crypt, (void **)arg, len, n, cpu, ncpus, budget) : -1;
+
+		for(i = 0; i < n; i++) {
+			free(arg[i]->buf);
+			free(arg[i]);
+		}
+
+		if(speed <= 0)
+			return -1;
+
+		if(j == 0)
+			base = speed / threads[j];
 
-	printf("\nRun time of the %d bytes - %d\n\n", BUFLEN, time_stop());
+		scaling_row(out, alg_name[alg], len, threads[j], speed, base, roofline[j]);
+	}
+
+	return 0;
 }
 
 int
 main(int argc, char *argv[])
 {
-	union context context;
-	int res, alg = 0;
+	struct speed_arg *arg;
+	struct bench_output out;
+	struct bench_perf counters, *perf = NULL;
+	uint64_t min = MIN_BYTES, max = MAX_BYTES, len;
+	int res, i, j, nalgs = NALGS, samples = SAMPLES, format = BENCH_TEXT;
+	int latency = 0, messages = MESSAGES, npayloads = 6;
+	int nthreads = 0, ncpus = 0, threads[BENCH_MAX_THREADS], cpu[BENCH_MAX_THREADS];
+	double roofline[BENCH_MAX_THREADS];
+	uint64_t size = THREAD_BYTES;
+	uint64_t payload[MAX_PAYLOADS] = { 64, 128, 256, 512, 1024, 1500 };
+	int algs[NALGS] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	double budget = BUDGET;
+	char *p, *output = NULL;
+	FILE *fp = stdout;
 
 	const struct option long_option [] = {
 		{"algorithm", 1, NULL, 'a'},
+		{"min",       1, NULL, 'm'},
+		{"max",       1, NULL, 'M'},
+		{"samples",   1, NULL, 'r'},
+		{"budget",    1, NULL, 'b'},
+		{"latency",   0, NULL, 'l'},
+		{"payload",   1, NULL, 'p'},
+		{"messages",  1, NULL, 'n'},
+		{"threads",   1, NULL, 'j'},
+		{"cpus",      1, NULL, 'c'},
+		{"size",      1, NULL, 's'},
+		{"format",    1, NULL, 'F'},
+		{"output",    1, NULL, 'o'},
+		{"perf",      0, NULL, 'P'},
 		{"help",      0, NULL, 'h'},
 		{0, 	      0, NULL,  0 }
 	};
-	
-	if(argc < 2) {
-		help();
-		return 0;
-	}
-	
+
 	// Parse argument
-	while((res = getopt_long(argc, argv, "a:h", long_option, 0)) != -1) {
+	while((res = getopt_long(argc, argv, "a:m:M:r:b:lp:n:j:c:s:F:o:Ph", long_option, 0)) != -1) {
 		switch(res) {
 		case 'h' : help();
 			   return 0;
-		case 'a' : alg = atoi(optarg);
+		case 'a' : nalgs = 0;
+			   p = optarg;
+
+			   // List of the algorithms separated by the comma
+			   do {
+				   algs[nalgs++] = strtol(p, &p, 10);
+			   } while((*p++ == ',') && (nalgs < NALGS));
+			   break;
+		case 'm' : min = bench_size(optarg);
+			   break;
+		case 'M' : max = bench_size(optarg);
+			   break;
+		case 'r' : samples = atoi(optarg);
+			   break;
+		case 'b' : budget = atof(optarg);
+			   break;
+		case 'l' : latency = 1;
+			   break;
+		case 'p' : npayloads = 0;
+			   p = optarg;
+
+			   // List of the sizes separated by the comma
+			   do {
+				   payload[npayloads++] = strtoull(p, &p, 10);
+			   } while((*p++ == ',') && (npayloads < MAX_PAYLOADS));
+			   break;
+		case 'n' : messages = atoi(optarg);
+			   break;
+		case 'j' : nthreads = strcmp(optarg, "auto") ? bench_list(optarg, threads, BENCH_MAX_THREADS) :
+							       bench_threads(threads, BENCH_MAX_THREADS);
+			   break;
+		case 'c' : ncpus = bench_list(optarg, cpu, BENCH_MAX_THREADS);
+			   break;
+		case 's' : size = bench_size(optarg);
+			   break;
+		case 'F' : format = bench_format(optarg);
 			   break;
+		case 'o' : output = optarg;
+			   break;
+		case 'P' : perf = &counters;
+			   break;
+		}
+	}
+
+	for(i = 0; i < nalgs; i++) {
+		if((algs[i] < 0) || (algs[i] >= NALGS)) {
+			printf("\nNo such algorithm!\n");
+			return 0;
 		}
 	}
 
-	// Select algorithm
-	switch(alg) {
-	case 0 : printf("\nSalsa speed test!\n");
-		 speed_test(&(context.salsa), alg);
-		 break;
-	case 1 : printf("\nRabbit speed test!\n");
-		 speed_test(&(context.rabbit), alg);
-		 break;
-	case 2 : printf("\nHC128 speed test!\n");
-		 speed_test(&(context.hc128), alg);
-		 break;
-	case 3 : printf("\nSosemanuk speed test!\n");
-		 speed_test(&(context.sosemanuk), alg);
-		 break;
-	case 4 : printf("\nGrain speed test!\n");
-		 speed_test(&(context.grain), alg);
-		 break;
-	case 5 : printf("\nMickey speed test!\n");
-		 speed_test(&(context.mickey), alg);
-		 break;
-	case 6 : printf("\nTrivium speed test!\n");
-		 speed_test(&(context.trivium), alg);
-		 break;
-	default: printf("\nNo such algorithm!\n");
-		 break;
+	if((min == 0) || (max < min) || (max > 0xFFFFFFFF) || (samples < 2) || (format < 0)) {
+		printf("\nBad parameters of the test!\n");
+		return 0;
 	}
-	
+
+	// The latency mode buffer is the largest payload
+	if(latency) {
+		if(messages < MIN_MESSAGES)
+			messages = MIN_MESSAGES;
+
+		for(i = 0, max = 1; i < npayloads; i++) {
+			if((payload[i] == 0) || (payload[i] > 0xFFFFFFFF)) {
+				printf("\nBad parameters of the test!\n");
+				return 0;
+			}
+
+			max = (payload[i] > max) ? payload[i] : max;
+		}
+	}
+
+	for(i = 0; i < nthreads; i++) {
+		if((threads[i] < 1) || (threads[i] > BENCH_MAX_THREADS))
+			nthreads = -1;
+	}
+
+	for(i = 0; i < ncpus; i++) {
+		if((cpu[i] < 0) || (cpu[i] >= BENCH_MAX_CPUS))
+			ncpus = -1;
+	}
+
+	if((nthreads < 0) || (ncpus < 0) || (size == 0) || (size > 0xFFFFFFFF)) {
+		printf("\nBad parameters of the test!\n");
+		return 0;
+	}
+
+	if((output != NULL) && ((fp = fopen(output, "w")) == NULL)) {
+		printf("\nError openning the file - %s!\n", output);
+		return 0;
+	}
+
+	// Scaling mode: the memcpy roofline of the every number of the threads, then the ciphers
+	if(nthreads > 0) {
+		bench_begin(&out, fp, format);
+
+		for(j = 0; j < nthreads; j++) {
+			if((roofline[j] = bench_memcpy(size, threads[j], cpu, ncpus, budget)) <= 0) {
+				printf("\nError starting the threads!\n");
+				return 0;
+			}
+
+			scaling_row(&out, "memcpy", size, threads[j], roofline[j], roofline[0] / threads[0], roofline[j]);
+		}
+
+		for(i = 0; i < nalgs; i++) {
+			if(scaling_test(&out, algs[i], size, threads, nthreads, cpu, ncpus, budget, roofline)) {
+				printf("\nError starting the threads!\n");
+				return 0;
+			}
+		}
+
+		bench_end(&out);
+
+		if(fp != stdout)
+			fclose(fp);
+
+		return 0;
+	}
+
+	// The message is encrypted in place: one buffer of the maximum size
+	if(((arg = malloc(sizeof(*arg))) == NULL) || posix_memalign((void **)&arg->buf, 64, max)) {
+		printf("\nError allocating memory!\n");
+		return 0;
+	}
+
+	memset(arg->buf, 0, max);
+
+	if((perf != NULL) && (bench_perf_open(perf) == 0))
+		fprintf(stderr, "Hardware counters are not available (perf_event_paranoid or the virtual machine)!\n");
+
+	bench_begin(&out, fp, format);
+
+	for(i = 0; latency && (i < nalgs); i++) {
+		arg->alg = algs[i];
+
+		for(j = 0; j < npayloads; j++) {
+			arg->len = payload[j];
+
+			if(latency_test(&out, arg, messages, budget)) {
+				printf("\nError allocating memory!\n");
+				return 0;
+			}
+		}
+	}
+
+	for(i = 0; !latency && (i < nalgs); i++) {
+		arg->alg = algs[i];
+		arg->len = 0;
+
+		speed_test(&out, arg, samples, budget, perf);
+
+		if(set[arg->alg](&arg->ctx, key, keylen[arg->alg], iv, ivlen[arg->alg])) {
+			printf("Context filling error!\n");
+			return 1;
+		}
+
+		for(len = min; len <= max; len *= 4) {
+			arg->len = len;
+			speed_test(&out, arg, samples, budget, perf);
+		}
+	}
+
+	bench_end(&out);
+
+	if(perf != NULL)
+		bench_perf_close(perf);
+
+	if(fp != stdout)
+		fclose(fp);
+
+	free(arg->buf);
+	free(arg);
+
 	return 0;
 }
-
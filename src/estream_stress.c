@@ -0,0 +1,499 @@
+/*
+ * Multi-threaded stress test of the ciphers and the HASH functions
+ * Makefile: Makefile_stress
+ * Compile: make -f Makefile_stress (ThreadSanitizer) or make -f Makefile_stress test
+ * Example: ./estream_stress -j 8 -n 1000 or ./estream_stress -j 16 -s 42 -M 1M
+ * The library is reentrant: the context is the only state of the cipher (of the hash),
+ * the tables are static const. The jobs (the key, the IV, the message and the reference
+ * of the one-shot call) are made by the main thread, the threads are started together
+ * and every thread has its own contexts: the jobs are chosen at random, the message
+ * (shared by the threads, read only) is crypted (hashed) by the random chunks and compared
+ * with the reference. Any difference is printed (thread, target, job, offset) and the exit code is 1,
+ * the ThreadSanitizer of the Makefile_stress finds the data races of the library.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#include "estream.h"
+#include "md5.h"
+#include "sha1.h"
+#include "sha224.h"
+#include "sha256.h"
+#include "sha384.h"
+#include "sha512.h"
+#include "sha3.h"
+
+// Number of the ciphers, the HASH functions and all targets
+#define NCIPHERS	8
+#define NHASHES		10
+#define NTARGETS	(NCIPHERS + NHASHES)
+
+// Number of the jobs (the inputs) of the one target
+#define JOBS		4
+
+// Default number of the threads, of the operations of the one thread and maximum size of the message
+#define THREADS		8
+#define ITERATIONS	1000
+#define MAX_BYTES	(1 << 16)
+
+// Maximum size of the message and maximum number of the threads
+#define MAX_MESSAGE	(1 << 20)
+#define MAX_THREADS	256
+
+// Union all structures eSTREAM project
+union context {
+	struct salsa_context salsa;
+	struct rabbit_context rabbit;
+	struct hc128_context hc128;
+	struct sosemanuk_context sosemanuk;
+	struct grain_context grain;
+	struct mickey_context mickey;
+	struct trivium_context trivium;
+	struct gost89_context gost89;
+};
+
+// Union all structures HASH functions
+union hash_context {
+	struct md5_context md5;
+	struct sha1_context sha1;
+	struct sha224_context sha224;
+	struct sha256_context sha256;
+	struct sha384_context sha384;
+	struct sha512_context sha512;
+	struct sha3_context sha3;
+};
+
+typedef int (*set_t)(void *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen);
+typedef void (*crypt_t)(void *ctx, uint8_t *buf, uint32_t buflen, uint8_t *out);
+
+// GOST 28147-89 in the gamma mode: the IV is the gamma
+static int
+gost89_set_key_and_iv(struct gost89_context *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen)
+{
+	return gost89_set_key_and_gamma(ctx, key, keylen, iv);
+}
+
+// Pointer of the function eSTREAM project
+static const set_t set[] = { (set_t)salsa_set_key_and_iv,
+			     (set_t)rabbit_set_key_and_iv,
+			     (set_t)hc128_set_key_and_iv,
+			     (set_t)sosemanuk_set_key_and_iv,
+			     (set_t)grain_set_key_and_iv,
+			     (set_t)mickey_set_key_and_iv,
+			     (set_t)trivium_set_key_and_iv,
+			     (set_t)gost89_set_key_and_iv };
+
+static const crypt_t crypt[] = { (crypt_t)salsa_crypt,
+				 (crypt_t)rabbit_crypt,
+				 (crypt_t)hc128_crypt,
+				 (crypt_t)sosemanuk_crypt,
+				 (crypt_t)grain_crypt,
+				 (crypt_t)mickey_crypt,
+				 (crypt_t)trivium_crypt,
+				 (crypt_t)gost89_gamma_crypt };
+
+// Maximum length secret key and IV, the size of the block of the crypt (the keystream goes on after the full blocks)
+static const int keylen[NCIPHERS] = { 32, 16, 16, 32, 16, 10, 10, 32 };
+static const int ivlen[NCIPHERS] =  {  8,  8, 16, 16, 12, 10, 10,  8 };
+static const int block[NCIPHERS] =  { 64, 16, 64, 80,  1,  1,  4,  8 };
+
+static const char *target_name[NTARGETS] = { "Salsa", "Rabbit", "HC128", "Sosemanuk", "Grain", "Mickey", "Trivium", "GOST89",
+					     "MD5", "SHA1", "SHA224", "SHA256", "SHA384", "SHA512",
+					     "SHA3-224", "SHA3-256", "SHA3-384", "SHA3-512" };
+
+// Size of the hash in bytes
+static const int hash_size[NHASHES] = { 16, 20, 28, 32, 48, 64, 28, 32, 48, 64 };
+
+/*
+ * Job of the threads (made by the main thread, read only for the threads)
+ * key, iv - secret key and IV of the cipher
+ * message - the message, msglen - size in bytes of the message
+ * ref - the ciphertext (the hash) of the one-shot call
+*/
+struct job {
+	uint8_t key[32];
+	uint8_t iv[16];
+	uint8_t *message;
+	uint32_t msglen;
+	uint8_t *ref;
+};
+
+/*
+ * Argument of the thread
+ * id - number of the thread, seed - state of the generator of the thread
+ * errors - number of the differences found by the thread
+*/
+struct stress_arg {
+	int id;
+	uint64_t seed;
+	uint64_t errors;
+	pthread_t thread;
+};
+
+static struct job jobs[NTARGETS][JOBS];
+static uint64_t iterations = ITERATIONS;
+static pthread_barrier_t start;
+
+// Generator of the inputs and of the chunk boundaries (xorshift64*)
+static uint64_t
+next(uint64_t *seed)
+{
+	*seed ^= *seed >> 12;
+	*seed ^= *seed << 25;
+	*seed ^= *seed >> 27;
+
+	return *seed * 0x2545F4914F6CDD1DULL;
+}
+
+// Size of the next chunk: small, around the blocks or the rest of the message
+// unit - the chunk is the multiple of the unit (except the last chunk)
+static uint32_t
+chunk(uint64_t *seed, uint32_t rest, int unit)
+{
+	uint64_t r = next(seed);
+	uint32_t len;
+
+	switch(r & 3) {
+	case 0 : len = (r >> 8) % 300;
+		 break;
+	case 1 : len = (r >> 8) % 4096;
+		 break;
+	case 2 : len = (r >> 8) % 20000;
+		 break;
+	default : len = rest;
+		  break;
+	}
+
+	if(len >= rest)
+		return rest;
+
+	return len - len % unit;
+}
+
+// Initialization of the HASH function
+static void
+hash_init(int alg, union hash_context *ctx)
+{
+	switch(alg) {
+	case 0 : md5_init(&ctx->md5);
+		 break;
+	case 1 : sha1_init(&ctx->sha1);
+		 break;
+	case 2 : sha224_init(&ctx->sha224);
+		 break;
+	case 3 : sha256_init(&ctx->sha256);
+		 break;
+	case 4 : sha384_init(&ctx->sha384);
+		 break;
+	case 5 : sha512_init(&ctx->sha512);
+		 break;
+	default : sha3_init(&ctx->sha3, hash_size[alg] * 8);
+		  break;
+	}
+}
+
+static void
+hash_update(int alg, union hash_context *ctx, const uint8_t *message, uint32_t msglen)
+{
+	switch(alg) {
+	case 0 : md5_update(&ctx->md5, message, msglen);
+		 break;
+	case 1 : sha1_update(&ctx->sha1, message, msglen);
+		 break;
+	case 2 : sha224_update(&ctx->sha224, message, msglen);
+		 break;
+	case 3 : sha256_update(&ctx->sha256, message, msglen);
+		 break;
+	case 4 : sha384_update(&ctx->sha384, message, msglen);
+		 break;
+	case 5 : sha512_update(&ctx->sha512, message, msglen);
+		 break;
+	default : sha3_update(&ctx->sha3, (void *)message, msglen);
+		  break;
+	}
+}
+
+static void
+hash_final(int alg, union hash_context *ctx, uint8_t *digest)
+{
+	switch(alg) {
+	case 0 : md5_final(&ctx->md5, digest);
+		 break;
+	case 1 : sha1_final(&ctx->sha1, digest);
+		 break;
+	case 2 : sha224_final(&ctx->sha224, digest);
+		 break;
+	case 3 : sha256_final(&ctx->sha256, digest);
+		 break;
+	case 4 : sha384_final(&ctx->sha384, digest);
+		 break;
+	case 5 : sha512_final(&ctx->sha512, digest);
+		 break;
+	default : sha3_final(&ctx->sha3, digest);
+		  break;
+	}
+}
+
+// Result of the job: the ciphertext (the hash) of the message, the cipher (the hash) is
+// called by the chunks (seed != NULL) or once (seed == NULL, the reference)
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+job_run(int target, const struct job *job, uint64_t *seed, uint8_t *out)
+{
+	union context ctx;
+	union hash_context hash_ctx;
+	uint32_t pos, n;
+
+	if(target < NCIPHERS) {
+		if(set[target](&ctx, (uint8_t *)job->key, keylen[target], (uint8_t *)job->iv, ivlen[target]))
+			return -1;
+
+		for(pos = 0; pos < job->msglen; pos += n) {
+			n = (seed != NULL) ? chunk(seed, job->msglen - pos, block[target]) : job->msglen;
+			crypt[target](&ctx, job->message + pos, n, out + pos);
+		}
+
+		return 0;
+	}
+
+	hash_init(target - NCIPHERS, &hash_ctx);
+
+	for(pos = 0; pos < job->msglen; pos += n) {
+		n = (seed != NULL) ? chunk(seed, job->msglen - pos, 1) : job->msglen;
+		hash_update(target - NCIPHERS, &hash_ctx, job->message + pos, n);
+	}
+
+	hash_final(target - NCIPHERS, &hash_ctx, out);
+
+	return 0;
+}
+
+// Size of the result of the job
+static uint32_t
+job_size(int target, const struct job *job)
+{
+	return (target < NCIPHERS) ? job->msglen : hash_size[target - NCIPHERS];
+}
+
+// Jobs of the all targets: the random key, IV and message, the reference of the one-shot call
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+jobs_create(uint64_t seed, uint32_t max)
+{
+	struct job *job;
+	uint32_t i;
+	int target, k;
+
+	for(target = 0; target < NTARGETS; target++) {
+		for(k = 0; k < JOBS; k++) {
+			job = &jobs[target][k];
+
+			for(i = 0; i < sizeof(job->key); i++)
+				job->key[i] = next(&seed);
+
+			for(i = 0; i < sizeof(job->iv); i++)
+				job->iv[i] = next(&seed);
+
+			job->msglen = next(&seed) % (max + 1);
+			job->message = malloc(job->msglen + 1);
+			job->ref = malloc(job->msglen + 64);
+
+			if((job->message == NULL) || (job->ref == NULL)) {
+				fprintf(stderr, "Memory is not allocated!\n");
+				return -1;
+			}
+
+			for(i = 0; i < job->msglen; i++)
+				job->message[i] = next(&seed);
+
+			if(job_run(target, job, NULL, job->ref)) {
+				fprintf(stderr, "%s: key and IV are not set!\n", target_name[target]);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void
+jobs_free(void)
+{
+	int target, k;
+
+	for(target = 0; target < NTARGETS; target++) {
+		for(k = 0; k < JOBS; k++) {
+			free(jobs[target][k].message);
+			free(jobs[target][k].ref);
+		}
+	}
+}
+
+// Thread of the stress test: the random jobs by the own contexts
+static void *
+stress_thread(void *data)
+{
+	struct stress_arg *arg = data;
+	const struct job *job;
+	uint8_t *out;
+	uint64_t n;
+	uint32_t i, size;
+	int target, k;
+
+	if((out = malloc(MAX_MESSAGE + 64)) == NULL) {
+		fprintf(stderr, "Memory is not allocated!\n");
+		arg->errors++;
+		pthread_barrier_wait(&start);
+		return NULL;
+	}
+
+	pthread_barrier_wait(&start);
+
+	for(n = 0; n < iterations; n++) {
+		target = next(&arg->seed) % NTARGETS;
+		k = next(&arg->seed) % JOBS;
+		job = &jobs[target][k];
+		size = job_size(target, job);
+
+		if(job_run(target, job, &arg->seed, out)) {
+			fprintf(stderr, "MISMATCH: thread %d, %s, job %d: key and IV are not set\n", arg->id, target_name[target], k);
+			arg->errors++;
+			continue;
+		}
+
+		for(i = 0; i < size; i++)
+			if(out[i] != job->ref[i])
+				break;
+
+		if(i < size) {
+			fprintf(stderr, "MISMATCH: thread %d, %s, job %d, message %u bytes, offset %u: %02x, expected %02x\n",
+				arg->id, target_name[target], k, job->msglen, i, out[i], job->ref[i]);
+			arg->errors++;
+		}
+	}
+
+	free(out);
+
+	return NULL;
+}
+
+static void
+help(void)
+{
+	printf("\nThis program runs the ciphers and the HASH functions in the threads with the own contexts!\n");
+	printf("\nOptions:\n");
+	printf("\t--help(-h) - reference manual\n");
+	printf("\t--threads(-j) - number of the threads (8 by default)\n");
+	printf("\t--iterations(-n) - number of the operations of the one thread (1000 by default)\n");
+	printf("\t--seed(-s) - seed of the jobs and of the threads (the time by default)\n");
+	printf("\t--max(-M) - maximum size of the message (64K by default), suffix K, M\n");
+	printf("\nExample: ./estream_stress -j 8 -n 1000 or ./estream_stress -j 16 -s 42 -M 1M\n\n");
+}
+
+// Size with the suffix K or M
+static uint32_t
+parse_size(const char *str)
+{
+	char *end;
+	unsigned long size = strtoul(str, &end, 10);
+
+	if((*end == 'K') || (*end == 'k'))
+		size <<= 10;
+	else if((*end == 'M') || (*end == 'm'))
+		size <<= 20;
+
+	return (size > MAX_MESSAGE) ? MAX_MESSAGE : size;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct stress_arg *arg;
+	int result, option_index = 0, threads = THREADS, i;
+	uint64_t seed = time(NULL), errors = 0;
+	uint32_t max = MAX_BYTES;
+
+	const struct option long_option[] = {
+		{"help",	no_argument,		NULL,	'h'},
+		{"threads",	required_argument,	NULL,	'j'},
+		{"iterations",	required_argument,	NULL,	'n'},
+		{"seed",	required_argument,	NULL,	's'},
+		{"max",		required_argument,	NULL,	'M'},
+		{NULL,		0,			NULL,	0}
+	};
+
+	while((result = getopt_long(argc, argv, "hj:n:s:M:", long_option, &option_index)) != -1) {
+		switch(result) {
+		case 'h' : help();
+			   return 0;
+		case 'j' : threads = atoi(optarg);
+			   if((threads < 1) || (threads > MAX_THREADS)) {
+				fprintf(stderr, "Number of the threads is bad!\n");
+				return 1;
+			   }
+			   break;
+		case 'n' : iterations = strtoull(optarg, NULL, 10);
+			   break;
+		case 's' : seed = strtoull(optarg, NULL, 10);
+			   break;
+		case 'M' : max = parse_size(optarg);
+			   break;
+		default : help();
+			  return 1;
+		}
+	}
+
+	// Zero state of the xorshift is the fixed point
+	if(seed == 0)
+		seed = 1;
+
+	printf("Seed %llu, %d threads, %llu operations of the thread, maximum message %u bytes\n",
+		(unsigned long long)seed, threads, (unsigned long long)iterations, max);
+
+	if(jobs_create(seed, max)) {
+		jobs_free();
+		return 1;
+	}
+
+	if((arg = calloc(threads, sizeof(*arg))) == NULL) {
+		fprintf(stderr, "Memory is not allocated!\n");
+		jobs_free();
+		return 1;
+	}
+
+	pthread_barrier_init(&start, NULL, threads);
+
+	for(i = 0; i < threads; i++) {
+		arg[i].id = i;
+		arg[i].seed = seed + 0x9E3779B97F4A7C15ULL * (i + 1);
+
+		if(pthread_create(&arg[i].thread, NULL, stress_thread, &arg[i])) {
+			fprintf(stderr, "Thread is not created!\n");
+			exit(1);
+		}
+	}
+
+	for(i = 0; i < threads; i++) {
+		pthread_join(arg[i].thread, NULL);
+		errors += arg[i].errors;
+	}
+
+	pthread_barrier_destroy(&start);
+	free(arg);
+	jobs_free();
+
+	if(errors) {
+		printf("%llu errors\n", (unsigned long long)errors);
+		return 1;
+	}
+
+	printf("%llu operations are passed\n", (unsigned long long)threads * iterations);
+
+	return 0;
+}
@@ -2,17 +2,37 @@
  * This program tests the algorithms eSTREAM project to test vector perfomance
  * Makefile: Makefile_test_vectors
  * Compile: make -f Makefile_test_vectors
- * Example: ./estream_test_vectors -h ./estream_test_vectors -a 1
+ * Test: make -f Makefile_test_vectors test
+ * Example: ./estream_test_vectors -h or ./estream_test_vectors -a 1 or ./estream_test_vectors test_vectors/trivium.test-vectors
+ * Known answer tests: the files of the vectors in the format of the eSTREAM verified.test-vectors
+ * ("Primitive Name: ...", "Set N, vector# M:", key, IV, windows stream[a..b] of the keystream and
+ * xor-digest - XOR of the all 64-byte blocks of the keystream). The keystream is the crypt of the zero bytes,
+ * its length is the end of the last window. Every vector is checked by every variant of the crypt calls,
+ * the program returns 1 if any vector is bad.
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
 #include <getopt.h>
 
 #include "estream.h"
 
+// Number of the algorithms
+#define NALGS		7
+
+// Maximum number of the windows of the vector
+#define MAX_WINDOWS	8
+
+// Size of the window and the xor-digest
+#define WINDOW		64
+
+// Maximum length of the keystream of the vector
+#define MAX_STREAM	(1 << 24)
+
 // Secret key
 uint8_t key[32] = { 0x00, 0x11, 0x22, 0x33,
 		    0x44, 0x55, 0x66, 0x77,
@@ -34,12 +54,16 @@ static void
 help(void)
 {
 	printf("\nThis program provides the user interface for testing algorithms project eSTREAM on test vectors!\n");
+	printf("\nUsage: ./estream_test_vectors [options] [files of the vectors]\n");
 	printf("\nOptions:\n");
 	printf("\t--help(-h) - reference manual\n");
-	printf("\t--algorithm(-a) - selection algorithm:\n");
+	printf("\t--algorithm(-a) - print the first keystream of the fixed key and IV of the algorithm:\n");
 	printf("\t\t0 - Salsa\n\t\t1 - Rabbit\n\t\t2 - HC128\n\t\t3 - Sosemanuk\n");
 	printf("\t\t4 - Grain\n\t\t5 - Mickey\n\t\t6 - Trivium\n");
-	printf("\nExample: ./estream_testvectors -h or ./estream_testvectors -a 1\n\n");
+	printf("\t--verbose(-v) - print every vector\n");
+	printf("\nFiles: the vectors in the format of the eSTREAM verified.test-vectors (test_vectors/*.test-vectors),\n");
+	printf("every vector is checked by every variant of the crypt calls. Exit status 1 if any vector is bad.\n");
+	printf("\nExample: ./estream_test_vectors -h or ./estream_test_vectors -a 1 or ./estream_test_vectors test_vectors/*.test-vectors\n\n");
 }
 
 // Union all structures eSTREAM project
@@ -54,84 +78,399 @@ union context {
 };
 
 typedef int (*set_t)(void *ctx, uint8_t *key, int keylen, uint8_t *iv, int ivlen);
+typedef void (*crypt_t)(void *ctx, uint8_t *buf, uint32_t buflen, uint8_t *out);
 typedef void (*test_t)(void *ctx);
 
 // Pointer of the function eSTREAM project
-set_t set[] = { (set_t)salsa_set_key_and_iv,
-		(set_t)rabbit_set_key_and_iv,
-		(set_t)hc128_set_key_and_iv,
-		(set_t)sosemanuk_set_key_and_iv,
-		(set_t)grain_set_key_and_iv,
-		(set_t)mickey_set_key_and_iv,
-		(set_t)trivium_set_key_and_iv };
-
-test_t test[] = { (test_t)salsa_test_vectors,
-		  (test_t)rabbit_test_vectors,
-		  (test_t)hc128_test_vectors,
-		  (test_t)sosemanuk_test_vectors,
-		  (test_t)grain_test_vectors,
-		  (test_t)mickey_test_vectors,
-		  (test_t)trivium_test_vectors };
+static const set_t set[] = { (set_t)salsa_set_key_and_iv,
+			     (set_t)rabbit_set_key_and_iv,
+			     (set_t)hc128_set_key_and_iv,
+			     (set_t)sosemanuk_set_key_and_iv,
+			     (set_t)grain_set_key_and_iv,
+			     (set_t)mickey_set_key_and_iv,
+			     (set_t)trivium_set_key_and_iv };
+
+static const crypt_t crypt[] = { (crypt_t)salsa_crypt,
+				 (crypt_t)rabbit_crypt,
+				 (crypt_t)hc128_crypt,
+				 (crypt_t)sosemanuk_crypt,
+				 (crypt_t)grain_crypt,
+				 (crypt_t)mickey_crypt,
+				 (crypt_t)trivium_crypt };
+
+static const test_t test[] = { (test_t)salsa_test_vectors,
+			       (test_t)rabbit_test_vectors,
+			       (test_t)hc128_test_vectors,
+			       (test_t)sosemanuk_test_vectors,
+			       (test_t)grain_test_vectors,
+			       (test_t)mickey_test_vectors,
+			       (test_t)trivium_test_vectors };
 
 // Maximum length secret key and IV
-const int keylen[7] = { 32, 16, 16, 32, 16, 10, 10 };
-const int ivlen[7] =  {  8,  8, 16, 16, 12, 10, 10 };
+static const int keylen[NALGS] = { 32, 16, 16, 32, 16, 10, 10 };
+static const int ivlen[NALGS] =  {  8,  8, 16, 16, 12, 10, 10 };
 
-// Test vectors
-static void
-test_vectors(void *ctx, int alg)
+// Size of the block of the keystream: the crypt function continues the keystream after the whole blocks
+static const int block[NALGS] = { 64, 16, 64, 80, 1, 1, 4 };
+
+// Primitive name of the eSTREAM vectors (prefix, the case is ignored)
+static const char *primitive[NALGS] = { "Salsa20", "Rabbit", "HC-128", "Sosemanuk", "Grain-128", "MICKEY", "Trivium" };
+
+/*
+ * Variant of the crypt calls
+ * name - name of the variant
+ * blocks - number of the blocks of the one call, 0 - the whole keystream by the one call
+ * offset - the input and the output are the different buffers shifted by offset bytes, 0 - crypt in place
+*/
+struct variant {
+	const char *name;
+	uint32_t blocks;
+	uint32_t offset;
+};
+
+static const struct variant variants[] = { { "oneshot",   0, 0 },
+					   { "block",     1, 0 },
+					   { "3 blocks",  3, 0 },
+					   { "unaligned", 0, 1 } };
+
+#define NVARIANTS	((int)(sizeof(variants) / sizeof(variants[0])))
+
+/*
+ * Vector of the known answer test
+ * name - name of the vector ("Set 1, vector# 0")
+ * key, iv - secret key and IV
+ * start, end - windows of the keystream stream[start..end]
+ * window - expected bytes of the windows
+ * digest - expected xor-digest, has_digest - 1 if the vector has the xor-digest
+*/
+struct vector {
+	char name[64];
+	uint8_t key[32];
+	int keylen;
+	uint8_t iv[16];
+	int ivlen;
+	int nwindows;
+	uint32_t start[MAX_WINDOWS];
+	uint32_t end[MAX_WINDOWS];
+	uint8_t window[MAX_WINDOWS][WINDOW];
+	int has_digest;
+	uint8_t digest[WINDOW];
+};
+
+// Hex string to the bytes, the spaces are skipped
+// Return value: number of the bytes, -1 (if the string is bad or the bytes are more than max)
+static int
+parse_hex(const char *str, uint8_t *out, int max)
+{
+	int n = 0, hi = -1, d;
+
+	for(; *str != '\0'; str++) {
+		if(isspace((unsigned char)*str))
+			continue;
+
+		if(!isxdigit((unsigned char)*str))
+			return -1;
+
+		d = isdigit((unsigned char)*str) ? *str - '0' : (toupper((unsigned char)*str) - 'A' + 10);
+
+		if(hi < 0) {
+			hi = d;
+			continue;
+		}
+
+		if(n == max)
+			return -1;
+
+		out[n++] = (hi << 4) | d;
+		hi = -1;
+	}
+
+	return (hi < 0) ? n : -1;
+}
+
+// Crypt of the zero bytes by the variant
+// Return value: 0 (if all is well), -1 (if the setup of the key and IV failed)
+static int
+keystream(int alg, const struct vector *v, const struct variant *var, uint8_t *zero, uint8_t *out, uint32_t len)
+{
+	union context ctx;
+	uint8_t *in;
+	uint32_t off, n, step;
+
+	if(set[alg](&ctx, (uint8_t *)v->key, v->keylen, (uint8_t *)v->iv, v->ivlen))
+		return -1;
+
+	// Crypt in place or the shifted buffers
+	in = (var->offset > 0) ? zero + var->offset : out;
+	out += var->offset;
+	memset(in, 0, len);
+
+	step = (var->blocks > 0) ? var->blocks * block[alg] : len;
+
+	for(off = 0; off < len; off += n) {
+		n = (len - off < step) ? len - off : step;
+		crypt[alg](&ctx, in + off, n, out + off);
+	}
+
+	return 0;
+}
+
+// Check the vector by every variant
+// Return value: number of the failed variants
+static int
+check_vector(int alg, const struct vector *v, uint8_t *zero, uint8_t *out, int verbose)
 {
-	set[alg](ctx, key, keylen[alg], iv, ivlen[alg]);
+	uint8_t digest[WINDOW], *stream;
+	uint32_t len = 0, i;
+	int j, k, bad = 0, failed;
+
+	for(j = 0; j < v->nwindows; j++)
+		len = (v->end[j] + 1 > len) ? v->end[j] + 1 : len;
 
-	test[alg](ctx);
+	for(k = 0; k < NVARIANTS; k++) {
+		failed = 0;
+
+		if(keystream(alg, v, &variants[k], zero, out, len)) {
+			printf("FAIL %s %s (%s): setup of the key and IV\n", primitive[alg], v->name, variants[k].name);
+			bad++;
+			continue;
+		}
+
+		stream = out + variants[k].offset;
+
+		for(j = 0; j < v->nwindows; j++) {
+			if(memcmp(stream + v->start[j], v->window[j], v->end[j] - v->start[j] + 1)) {
+				printf("FAIL %s %s (%s): stream[%u..%u]\n", primitive[alg], v->name,
+				       variants[k].name, v->start[j], v->end[j]);
+				failed = 1;
+			}
+		}
+
+		if(v->has_digest) {
+			memset(digest, 0, sizeof(digest));
+
+			for(i = 0; i < len; i++)
+				digest[i % WINDOW] ^= stream[i];
+
+			if(memcmp(digest, v->digest, WINDOW)) {
+				printf("FAIL %s %s (%s): xor-digest\n", primitive[alg], v->name, variants[k].name);
+				failed = 1;
+			}
+		}
+
+		bad += failed;
+	}
+
+	if(verbose && (bad == 0))
+		printf("ok   %s %s\n", primitive[alg], v->name);
+
+	return bad;
+}
+
+// Test the file of the vectors
+// Return value: number of the failed vectors, -1 (if the file is bad)
+static int
+test_file(const char *path, uint8_t *zero, uint8_t *out, int verbose)
+{
+	struct vector v;
+	char line[256], *eq, *name, *end;
+	uint8_t *field = NULL;
+	int alg = -1, pending = 0, eof, nvectors = 0, bad = 0, window_len, *field_len = NULL, field_max = 0, n;
+	uint32_t a, b;
+	FILE *fp;
+
+	if((fp = fopen(path, "r")) == NULL) {
+		printf("\nError openning the file - %s!\n", path);
+		return -1;
+	}
+
+	memset(&v, 0, sizeof(v));
+
+	for(;;) {
+		eof = (fgets(line, sizeof(line), fp) == NULL);
+
+		// End of the vector: the next vector or the end of the file
+		if(pending && (eof || !strncmp(line, "Set ", 4))) {
+			if(v.nwindows == 0) {
+				printf("FAIL %s %s: no keystream\n", path, v.name);
+				bad++;
+			}
+			else if(check_vector(alg, &v, zero, out, verbose))
+				bad++;
+
+			nvectors++;
+			pending = 0;
+		}
+
+		if(eof)
+			break;
+
+		if(!strncmp(line, "Primitive Name:", 15)) {
+			for(name = line + 15; isspace((unsigned char)*name); name++);
+
+			for(alg = 0; (alg < NALGS) && strncasecmp(name, primitive[alg], strlen(primitive[alg])); alg++);
+
+			if(alg == NALGS) {
+				printf("\nNo such algorithm - %s", name);
+				fclose(fp);
+				return -1;
+			}
+
+			continue;
+		}
+
+		if(sscanf(line, "Set %u, vector#%u:", &a, &b) == 2) {
+			if(alg < 0) {
+				printf("\nNo primitive name - %s!\n", path);
+				fclose(fp);
+				return -1;
+			}
+
+			memset(&v, 0, sizeof(v));
+
+			if((end = strchr(line, ':')) != NULL)
+				*end = '\0';
+
+			snprintf(v.name, sizeof(v.name), "%.60s", line);
+			field = NULL;
+			pending = 1;
+			continue;
+		}
+
+		for(name = line; isspace((unsigned char)*name); name++);
+
+		// The empty line is the end of the field
+		if(!pending || (*name == '\0')) {
+			field = NULL;
+			continue;
+		}
+
+		// Field "name = hex" or the continuation of the field (the hex only)
+		if((eq = strchr(line, '=')) != NULL) {
+			*eq = '\0';
+
+			for(name = line; isspace((unsigned char)*name); name++);
+
+			for(end = eq; (end > name) && isspace((unsigned char)end[-1]); end--);
+
+			*end = '\0';
+			field = NULL;
+
+			if(!strcmp(name, "key")) {
+				field = v.key;
+				field_len = &v.keylen;
+				field_max = sizeof(v.key);
+			}
+			else if(!strcasecmp(name, "IV")) {
+				field = v.iv;
+				field_len = &v.ivlen;
+				field_max = sizeof(v.iv);
+			}
+			else if(!strcmp(name, "xor-digest")) {
+				field = v.digest;
+				field_len = &v.has_digest;
+				field_max = WINDOW;
+			}
+			else if((sscanf(name, "stream[%u..%u]", &a, &b) == 2) && (v.nwindows < MAX_WINDOWS) &&
+				(a <= b) && (b - a < WINDOW) && (b < MAX_STREAM)) {
+				v.start[v.nwindows] = a;
+				v.end[v.nwindows] = b;
+				field = v.window[v.nwindows++];
+				field_len = &window_len;
+				field_max = b - a + 1;
+			}
+
+			if(field == NULL)
+				continue;
+
+			*field_len = 0;
+			name = eq + 1;
+		}
+
+		if(field == NULL)
+			continue;
+
+		if((n = parse_hex(name, field + *field_len, field_max - *field_len)) < 0) {
+			printf("FAIL %s %s: bad field\n", path, v.name);
+			bad++;
+			field = NULL;
+			continue;
+		}
+
+		*field_len += n;
+	}
+
+	fclose(fp);
+
+	printf("%s: %s, %d vectors, %d variants: %s\n", path, (alg < 0) ? "?" : primitive[alg], nvectors,
+	       NVARIANTS, bad ? "FAIL" : "ok");
+
+	return bad;
 }
 
 int
 main(int argc, char *argv[])
 {
 	union context context;
-	int res, alg = 0;
-	
+	uint8_t *zero, *out;
+	int res, i, alg = -1, verbose = 0, bad = 0;
+
 	const struct option long_option [] = {
 		{"algorithm", 1, NULL, 'a'},
+		{"verbose",   0, NULL, 'v'},
 		{"help",      0, NULL, 'h'},
 		{0,  	      0, NULL,  0 }
 	};
-	
+
 	if(argc < 2) {
 		help();
 		return 0;
 	}
 
 	// Parse argument
-	while((res = getopt_long(argc, argv, "a:h", long_option, 0)) != -1) {
+	while((res = getopt_long(argc, argv, "a:vh", long_option, 0)) != -1) {
 		switch(res) {
 		case 'h' : help();
 			   return 0;
 		case 'a' : alg = atoi(optarg);
 			   break;
+		case 'v' : verbose = 1;
+			   break;
 		}
 	}
-	
-	switch(alg) {
-	case 0 : test_vectors(&(context.salsa), alg);
-		 break;
-	case 1 : test_vectors(&(context.rabbit), alg);
-		 break;
-	case 2 : test_vectors(&(context.hc128), alg);
-		 break;
-	case 3 : test_vectors(&(context.sosemanuk), alg);
-		 break;
-	case 4 : test_vectors(&(context.grain), alg);
-		 break;
-	case 5 : test_vectors(&(context.mickey), alg);
-		 break;
-	case 6 : test_vectors(&(context.trivium), alg);
-		 break;
-	default: printf("\nNo such algorithm!\n\n");
-		 break;
+
+	// The first keystream of the fixed key and IV
+	if(alg >= 0) {
+		if(alg >= NALGS) {
+			printf("\nNo such algorithm!\n\n");
+			return 1;
+		}
+
+		set[alg](&context, key, keylen[alg], iv, ivlen[alg]);
+		test[alg](&context);
+	}
+
+	if(optind == argc)
+		return 0;
+
+	// Buffers of the keystream: the maximum stream and the shift of the unaligned variant
+	if(((zero = malloc(MAX_STREAM + 16)) == NULL) || ((out = malloc(MAX_STREAM + 16)) == NULL)) {
+		printf("\nError allocating memory!\n");
+		return 1;
+	}
+
+	for(i = optind; i < argc; i++) {
+		res = test_file(argv[i], zero, out, verbose);
+		bad += (res < 0) ? 1 : res;
+	}
+
+	free(zero);
+	free(out);
+
+	if(bad) {
+		printf("\n%d vectors failed!\n", bad);
+		return 1;
 	}
 
 	return 0;
 }
-
@@ -0,0 +1,559 @@
+/*
+ * This program tests the HASH functions to speed perfomance
+ * Makefile: Makefile_hash
+ * Compile: make -f Makefile_hash
+ * Example: ./hash_speed_test -h or ./hash_speed_test -a 3 or ./hash_speed_test -a 7,11 -M 1M -F json
+ * or ./hash_speed_test -a 3,11 -j 1,2,4,8 -c 0-7
+ * Every algorithm is measured on the messages from 16 bytes to 64 MB (every size is 4 times larger):
+ *	oneshot - init, update of the whole message, final
+ *	incremental - the message is updated by the pieces (1000 bytes by default)
+ *	multi - SHA3 of the several messages (up to 1 MB) by the SIMD lanes (sha3x), the scalar variant is the single stream
+ * The SIMD algorithms (BLAKE3, SHA3x) are measured by every variant of the kernel of the processor.
+ * Scaling mode (-j): N threads hash their own buffers (oneshot) as the scaling mode of the estream_speed_test.
+ * Hardware counters (-P): IPC and the instructions, branch misses, L1D and LLC misses per byte of the samples.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "md5.h"
+#include "sha1.h"
+#include "sha224.h"
+#include "sha256.h"
+#include "sha384.h"
+#include "sha512.h"
+#include "sha3.h"
+#include "sha3x.h"
+#include "k12.h"
+#include "blake3.h"
+#include "bench.h"
+
+// Number of the algorithms
+#define NALGS		12
+
+// Default sizes of the messages, bytes
+#define MIN_BYTES	16
+#define MAX_BYTES	(64 << 20)
+
+// Default number of the samples and the time of the one size, s
+#define SAMPLES		10
+#define BUDGET		1.0
+
+// Default size of the piece of the incremental mode
+#define PIECE_BYTES	1000
+
+// Number of the messages and the maximum size of the message of the multi-buffer mode
+#define MULTI_MESSAGES	64
+#define MULTI_BYTES	(1 << 20)
+
+// Scaling mode: default size of the buffer of the thread, bytes
+#define THREAD_BYTES	(64 << 20)
+
+// Union all structures HASH functions
+union context {
+	struct md5_context md5;
+	struct sha1_context sha1;
+	struct sha224_context sha224;
+	struct sha256_context sha256;
+	struct sha384_context sha384;
+	struct sha512_context sha512;
+	struct sha3_context sha3;
+	struct k12_context k12;
+	struct blake3_context blake3;
+};
+
+typedef void (*init_t)(void *ctx, ...);
+typedef void (*update_t)(void *ctx, const void *message, uint32_t msglen);
+typedef void (*final_t)(void *ctx, uint8_t *digest);
+
+// Pointer of the function HASH functions
+static const init_t init[] = { (init_t)md5_init,
+			       (init_t)sha1_init,
+			       (init_t)sha224_init,
+			       (init_t)sha256_init,
+			       (init_t)sha384_init,
+			       (init_t)sha512_init,
+			       (init_t)sha3_init,
+			       (init_t)k12_init,
+			       (init_t)blake3_init };
+
+static const update_t update[] = { (update_t)md5_update,
+				   (update_t)sha1_update,
+				   (update_t)sha224_update,
+				   (update_t)sha256_update,
+				   (update_t)sha384_update,
+				   (update_t)sha512_update,
+				   (update_t)sha3_update,
+				   (update_t)k12_update,
+				   (update_t)blake3_update };
+
+static const final_t final[] = { (final_t)md5_final,
+				 (final_t)sha1_final,
+				 (final_t)sha224_final,
+				 (final_t)sha256_final,
+				 (final_t)sha384_final,
+				 (final_t)sha512_final,
+				 (final_t)sha3_final,
+				 (final_t)k12_final,
+				 (final_t)blake3_final };
+
+// Index of the init/update/final functions of the algorithm
+static const int index_func[NALGS] = { 0, 1, 2, 3, 4, 5, 6, 6, 6, 6, 7, 8 };
+
+// Parameter of the init function: size of the SHA3 hash, number of the threads of the KangarooTwelve
+static const int init_size[NALGS] = { 0, 0, 0, 0, 0, 0, 224, 256, 384, 512, 1, 0 };
+
+// Name of the algorithm
+static const char *hash_name[NALGS] = { "MD5", "SHA1", "SHA224", "SHA256", "SHA384", "SHA512",
+					"SHA3/224", "SHA3/256", "SHA3/384", "SHA3/512",
+					"KangarooTwelve", "BLAKE3" };
+
+// Kernels of the SIMD lanes (limit of the lanes), the widest first
+static const int blake3_kernel[] = { 16, 8, 4, 1 };
+static const int sha3x_kernel[] = { 8, 4, 1 };
+
+/*
+ * Measured operation
+ * alg - algorithm
+ * buf - messages
+ * len - size of the message
+ * piece - size of the piece of the incremental mode, 0 - one update
+ * lanes - limit of the SIMD lanes (BLAKE3, SHA3x), 0 - all lanes of the processor
+*/
+struct speed_arg {
+	int alg;
+	uint8_t *buf;
+	uint32_t len;
+	uint32_t piece;
+	int lanes;
+};
+
+// Manual
+static void
+help(void)
+{
+	printf("\nThis program tests the HASH functions on speed!\n");
+	printf("\nOptions:\n");
+	printf("\t--help(-h) - reference manual\n");
+	printf("\t--algorithm(-a) - selection algorithm, the list (-a 0,3,7), all by default:\n");
+	printf("\t\t0 - MD5\n\t\t1 - SHA1\n\t\t2 - SHA224\n\t\t3 - SHA256\n\t\t4 - SHA384\n\t\t5 - SHA512\n");
+	printf("\t\t6 - SHA3/224\n\t\t7 - SHA3/256\n\t\t8 - SHA3/384\n\t\t9 - SHA3/512\n");
+	printf("\t\t10 - KangarooTwelve (one thread)\n\t\t11 - BLAKE3 (one thread)\n");
+	printf("\t--min(-m) - minimum size of the message (16 by default), suffix K, M, G\n");
+	printf("\t--max(-M) - maximum size of the message (64M by default)\n");
+	printf("\t--piece(-u) - size of the piece of the incremental mode (1000 by default)\n");
+	printf("\t--samples(-r) - number of the samples of the one size (10 by default)\n");
+	printf("\t--budget(-b) - time in seconds of the samples of the one size (1 by default)\n");
+	printf("\t--threads(-j) - scaling mode: the numbers of the threads (-j 1,2,4 or -j 1-8, -j auto - 1,2,4,... processors)\n");
+	printf("\t--cpus(-c) - processors of the threads of the scaling mode (-c 0,2,4,6 or -c 0-15), no pinning by default\n");
+	printf("\t--size(-s) - size of the buffer of the one thread of the scaling mode (64M by default)\n");
+	printf("\t--format(-F) - format of the results: text, json, csv\n");
+	printf("\t--output(-o) - file of the results (stdout by default)\n");
+	printf("\t--perf(-P) - hardware counters of the samples (perf_event_open)\n");
+	printf("\nModes: oneshot, incremental (the pieces), multi (%d messages of the SHA3 by the SIMD lanes).\n", MULTI_MESSAGES);
+	printf("Variants: scalar, sse4.1, avx2, avx512 - kernel of the SIMD algorithms (BLAKE3, SHA3 multi).\n");
+	printf("Columns: ns - time of the one message, GB/s and cycles/byte (time stamp counter),\n");
+	printf("*_ci - half-width of the 95%% confidence interval.\n");
+	printf("Scaling mode: GB/s - total speed of the threads, efficiency_%% - speed of the one thread against\n");
+	printf("the first number of the threads, memcpy_GB/s - copied bytes of the same threads, roofline_%% - part of it.\n");
+	printf("Hardware counters: IPC - instructions per cycle, instructions, branch misses, L1D and LLC misses\n");
+	printf("per byte of the operation, n/a - the event is not available.\n");
+	printf("\nExample: ./hash_speed_test -h or ./hash_speed_test -a 3 or ./hash_speed_test -a 7,11 -M 1M -F json\n");
+	printf("or ./hash_speed_test -a 3,11 -j 1,2,4,8 -c 0-7\n\n");
+}
+
+// Hash of the message: one update or the pieces
+static void
+speed_hash(void *arg, uint64_t iters)
+{
+	struct speed_arg *a = arg;
+	union context ctx;
+	uint8_t digest[64];
+	uint32_t off, n;
+	uint64_t i;
+	int f = index_func[a->alg];
+
+	for(i = 0; i < iters; i++) {
+		if(a->alg == 11)
+			blake3_init_lanes(&ctx.blake3, a->lanes);
+		else
+			init[f](&ctx, init_size[a->alg]);
+
+		if(a->piece == 0)
+			update[f](&ctx, a->buf, a->len);
+		else {
+			for(off = 0; off < a->len; off += n) {
+				n = (a->len - off < a->piece) ? a->len - off : a->piece;
+				update[f](&ctx, a->buf + off, n);
+			}
+		}
+
+		final[f](&ctx, digest);
+	}
+}
+
+// SHA3 of the MULTI_MESSAGES messages by the lanes
+static void
+speed_multi(void *arg, uint64_t iters)
+{
+	struct speed_arg *a = arg;
+	const void *message[MULTI_MESSAGES];
+	uint32_t msglen[MULTI_MESSAGES];
+	uint8_t out[MULTI_MESSAGES][64], *digest[MULTI_MESSAGES];
+	uint64_t i;
+	int j;
+
+	for(j = 0; j < MULTI_MESSAGES; j++) {
+		message[j] = a->buf + (uint64_t)j * a->len;
+		msglen[j] = a->len;
+		digest[j] = out[j];
+	}
+
+	for(i = 0; i < iters; i++)
+		sha3x_hash_lanes(init_size[a->alg], MULTI_MESSAGES, message, msglen, digest, a->lanes);
+}
+
+// Name of the variant of the kernel by the number of the lanes
+static const char *
+variant_name(int lanes, int blake3)
+{
+	switch(lanes) {
+	case 1 : return "scalar";
+	case 4 : return blake3 ? "sse4.1" : "avx2";
+	case 8 : return blake3 ? "avx2" : "avx512";
+	default : return "avx512";
+	}
+}
+
+// Measure the operation and write the record of the results
+// multi - the multi-buffer mode (MULTI_MESSAGES messages of the one operation)
+// perf - hardware counters of the samples, NULL - no counters
+static void
+speed_test(struct bench_output *out, struct speed_arg *a, const char *variant, int multi, int samples, double budget,
+	   struct bench_perf *perf)
+{
+	struct bench_field field[BENCH_MAX_FIELDS];
+	struct bench_stat ns, gbps, cpb;
+	double t[samples], c[samples], x[samples];
+	uint64_t iters, bytes;
+	int n, i, k = 0;
+
+	n = bench_run(multi ? speed_multi : speed_hash, a, samples, budget, t, c, &iters, perf);
+
+	// Time of the one message
+	bytes = (uint64_t)a->len * (multi ? MULTI_MESSAGES : 1);
+
+	for(i = 0; i < n; i++)
+		x[i] = t[i] * a->len / bytes;
+
+	bench_stat(x, n, &ns);
+
+	for(i = 0; i < n; i++)
+		x[i] = bytes / t[i];
+
+	bench_stat(x, n, &gbps);
+
+	for(i = 0; i < n; i++)
+		x[i] = c[i] / bytes;
+
+	bench_stat(x, n, &cpb);
+
+	bench_str(&field[k++], "hash", hash_name[a->alg]);
+	bench_str(&field[k++], "variant", variant);
+	bench_str(&field[k++], "mode", multi ? "multi" : (a->piece > 0) ? "incremental" : "oneshot");
+	bench_num(&field[k++], "bytes", a->len, 0);
+	bench_num(&field[k++], "samples", n, 0);
+	bench_num(&field[k++], "ns", ns.mean, 1);
+	bench_num(&field[k++], "ns_ci", ns.ci, 1);
+	bench_num(&field[k++], "GB/s", gbps.mean, 3);
+	bench_num(&field[k++], "GB/s_ci", gbps.ci, 3);
+	bench_num(&field[k++], "cycles/byte", cpb.mean, 2);
+	bench_num(&field[k++], "cpb_ci", cpb.ci, 2);
+
+	if(perf != NULL)
+		k += bench_perf_fields(&field[k], perf, bytes);
+
+	bench_row(out, field, k);
+}
+
+// Thread of the scaling mode: own buffer, touched by the pinned thread
+static int
+scaling_setup(void *arg)
+{
+	struct speed_arg *a = arg;
+	uint32_t i;
+
+	if(posix_memalign((void **)&a->buf, 64, a->len))
+		return -1;
+
+	for(i = 0; i < a->len; i++)
+		a->buf[i] = i * 7 + 1;
+
+	return 0;
+}
+
+// Write the record of the scaling mode
+// name - algorithm, base - speed of the one thread of the first number of the threads, roofline - memcpy speed
+static void
+scaling_row(struct bench_output *out, const char *name, uint32_t len, int threads, double speed, double base, double roofline)
+{
+	struct bench_field field[BENCH_MAX_FIELDS];
+	int k = 0;
+
+	bench_str(&field[k++], "hash", name);
+	bench_num(&field[k++], "threads", threads, 0);
+	bench_num(&field[k++], "bytes", len, 0);
+	bench_num(&field[k++], "GB/s", speed, 3);
+	bench_num(&field[k++], "GB/s/thread", speed / threads, 3);
+	bench_num(&field[k++], "efficiency_%", 100 * speed / (threads * base), 1);
+	bench_num(&field[k++], "memcpy_GB/s", roofline, 3);
+	bench_num(&field[k++], "roofline_%", 100 * speed / roofline, 1);
+
+	bench_row(out, field, k);
+}
+
+// Scaling of the algorithm by the numbers of the threads
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+scaling_test(struct bench_output *out, int alg, uint32_t len, const int *threads, int nthreads,
+	     const int *cpu, int ncpus, double budget, const double *roofline)
+{
+	struct speed_arg *arg[BENCH_MAX_THREADS];
+	double speed, base = 0;
+	int i, j, n;
+
+	for(j = 0; j < nthreads; j++) {
+		for(n = 0; n < threads[j]; n++) {
+			if(posix_memalign((void **)&arg[n], 64, sizeof(*arg[n])))
+				break;
+
+			arg[n]->alg = alg;
+			arg[n]->buf = NULL;
+			arg[n]->len = len;
+			arg[n]->piece = 0;
+			arg[n]->lanes = 0;
+		}
+
+		speed = (n == threads[j]) ? bench_scaling(scaling_setup, speed_hash, (void **)arg, len, n, cpu, ncpus, budget) : -1;
+
+		for(i = 0; i < n; i++) {
+			free(arg[i]->buf);
+			free(arg[i]);
+		}
+
+		if(speed <= 0)
+			return -1;
+
+		if(j == 0)
+			base = speed / threads[j];
+
+		scaling_row(out, hash_name[alg], len, threads[j], speed, base, roofline[j]);
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct speed_arg arg;
+	struct bench_output out;
+	struct bench_perf counters, *perf = NULL;
+	uint64_t min = MIN_BYTES, max = MAX_BYTES, len, size;
+	uint32_t piece = PIECE_BYTES;
+	int res, i, k, nalgs = NALGS, samples = SAMPLES, format = BENCH_TEXT;
+	int algs[NALGS] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+	int nthreads = 0, ncpus = 0, threads[BENCH_MAX_THREADS], cpu[BENCH_MAX_THREADS];
+	double roofline[BENCH_MAX_THREADS];
+	uint64_t thread_bytes = THREAD_BYTES;
+	double budget = BUDGET;
+	char *p, *output = NULL;
+	FILE *fp = stdout;
+
+	const struct option long_option [] = {
+		{"algorithm", 1, NULL, 'a'},
+		{"min",       1, NULL, 'm'},
+		{"max",       1, NULL, 'M'},
+		{"piece",     1, NULL, 'u'},
+		{"samples",   1, NULL, 'r'},
+		{"budget",    1, NULL, 'b'},
+		{"threads",   1, NULL, 'j'},
+		{"cpus",      1, NULL, 'c'},
+		{"size",      1, NULL, 's'},
+		{"format",    1, NULL, 'F'},
+		{"output",    1, NULL, 'o'},
+		{"perf",      0, NULL, 'P'},
+		{"help",      0, NULL, 'h'},
+		{0, 	      0, NULL,  0 }
+	};
+
+	// Parse argument
+	while((res = getopt_long(argc, argv, "a:m:M:u:r:b:j:c:s:F:o:Ph", long_option, 0)) != -1) {
+		switch(res) {
+		case 'h' : help();
+			   return 0;
+		case 'a' : nalgs = 0;
+			   p = optarg;
+
+			   // List of the algorithms separated by the comma
+			   do {
+				   algs[nalgs++] = strtol(p, &p, 10);
+			   } while((*p++ == ',') && (nalgs < NALGS));
+			   break;
+		case 'm' : min = bench_size(optarg);
+			   break;
+		case 'M' : max = bench_size(optarg);
+			   break;
+		case 'u' : piece = bench_size(optarg);
+			   break;
+		case 'r' : samples = atoi(optarg);
+			   break;
+		case 'b' : budget = atof(optarg);
+			   break;
+		case 'j' : nthreads = strcmp(optarg, "auto") ? bench_list(optarg, threads, BENCH_MAX_THREADS) :
+							       bench_threads(threads, BENCH_MAX_THREADS);
+			   break;
+		case 'c' : ncpus = bench_list(optarg, cpu, BENCH_MAX_THREADS);
+			   break;
+		case 's' : thread_bytes = bench_size(optarg);
+			   break;
+		case 'F' : format = bench_format(optarg);
+			   break;
+		case 'o' : output = optarg;
+			   break;
+		case 'P' : perf = &counters;
+			   break;
+		}
+	}
+
+	for(i = 0; i < nalgs; i++) {
+		if((algs[i] < 0) || (algs[i] >= NALGS)) {
+			printf("\nNo such algorithm!\n");
+			return 0;
+		}
+	}
+
+	if((min == 0) || (max < min) || (max > 0xFFFFFFFF) || (piece == 0) || (samples < 2) || (format < 0)) {
+		printf("\nBad parameters of the test!\n");
+		return 0;
+	}
+
+	for(i = 0; i < nthreads; i++) {
+		if((threads[i] < 1) || (threads[i] > BENCH_MAX_THREADS))
+			nthreads = -1;
+	}
+
+	for(i = 0; i < ncpus; i++) {
+		if((cpu[i] < 0) || (cpu[i] >= BENCH_MAX_CPUS))
+			ncpus = -1;
+	}
+
+	if((nthreads < 0) || (ncpus < 0) || (thread_bytes == 0) || (thread_bytes > 0xFFFFFFFF)) {
+		printf("\nBad parameters of the test!\n");
+		return 0;
+	}
+
+	if((output != NULL) && ((fp = fopen(output, "w")) == NULL)) {
+		printf("\nError openning the file - %s!\n", output);
+		return 0;
+	}
+
+	// Scaling mode: the memcpy roofline of the every number of the threads, then the algorithms
+	if(nthreads > 0) {
+		bench_begin(&out, fp, format);
+
+		for(i = 0; i < nthreads; i++) {
+			if((roofline[i] = bench_memcpy(thread_bytes, threads[i], cpu, ncpus, budget)) <= 0) {
+				printf("\nError starting the threads!\n");
+				return 0;
+			}
+
+			scaling_row(&out, "memcpy", thread_bytes, threads[i], roofline[i], roofline[0] / threads[0], roofline[i]);
+		}
+
+		for(i = 0; i < nalgs; i++) {
+			if(scaling_test(&out, algs[i], thread_bytes, threads, nthreads, cpu, ncpus, budget, roofline)) {
+				printf("\nError starting the threads!\n");
+				return 0;
+			}
+		}
+
+		bench_end(&out);
+
+		if(fp != stdout)
+			fclose(fp);
+
+		return 0;
+	}
+
+	// Messages of the multi-buffer mode follow each other
+	size = ((max < MULTI_BYTES) ? max : MULTI_BYTES) * MULTI_MESSAGES;
+	size = (size > max) ? size : max;
+
+	if(posix_memalign((void **)&arg.buf, 64, size)) {
+		printf("\nError allocating memory!\n");
+		return 0;
+	}
+
+	for(len = 0; len < size; len++)
+		arg.buf[len] = len * 7 + 1;
+
+	if((perf != NULL) && (bench_perf_open(perf) == 0))
+		fprintf(stderr, "Hardware counters are not available (perf_event_paranoid or the virtual machine)!\n");
+
+	bench_begin(&out, fp, format);
+
+	for(i = 0; i < nalgs; i++) {
+		arg.alg = algs[i];
+
+		for(len = min; len <= max; len *= 4) {
+			arg.len = len;
+
+			// BLAKE3: every kernel of the chunks
+			if(arg.alg == 11) {
+				for(k = 0; k < (int)(sizeof(blake3_kernel) / sizeof(int)); k++) {
+					if(blake3_kernel[k] <= blake3_lanes()) {
+						arg.piece = 0;
+						arg.lanes = blake3_kernel[k];
+						speed_test(&out, &arg, variant_name(arg.lanes, 1), 0, samples, budget, perf);
+					}
+				}
+			}
+			else {
+				arg.piece = 0;
+				speed_test(&out, &arg, "scalar", 0, samples, budget, perf);
+			}
+
+			arg.piece = piece;
+			arg.lanes = 0;
+			speed_test(&out, &arg, (arg.alg == 11) ? variant_name(blake3_lanes(), 1) : "scalar", 0, samples, budget, perf);
+
+			// SHA3: the lanes against the single stream
+			if((arg.alg >= 6) && (arg.alg <= 9) && (len <= MULTI_BYTES)) {
+				for(k = 0; k < (int)(sizeof(sha3x_kernel) / sizeof(int)); k++) {
+					if(sha3x_kernel[k] <= sha3x_lanes()) {
+						arg.lanes = sha3x_kernel[k];
+						speed_test(&out, &arg, variant_name(arg.lanes, 0), 1, samples, budget, perf);
+					}
+				}
+
+				arg.lanes = 0;
+			}
+		}
+	}
+
+	bench_end(&out);
+
+	if(perf != NULL)
+		bench_perf_close(perf);
+
+	if(fp != stdout)
+		fclose(fp);
+
+	free(arg.buf);
+
+	return 0;
+}
@@ -0,0 +1,706 @@
+/*
+ * This program tests the HASH functions on the known answers of the specifications
+ * Makefile: Makefile_hash
+ * Compile: make -f Makefile_hash
+ * Test: make -f Makefile_hash test
+ * Example: ./hash_test_vectors or ./hash_test_vectors -v
+ * KangarooTwelve - the vectors of the specification (RFC 9861), ptn(n) is the n bytes of the pattern
+ * 00 01 .. FA repeated.
+ * BLAKE3 - the hash mode of the official test_vectors.json, the input is the bytes i % 251 (the same pattern),
+ * the first 32 bytes of the extended output.
+ * HMAC - RFC 4231 test cases 1-7 of the HMAC-SHA224, SHA256, SHA384 and SHA512 (the key of the 131 bytes
+ * is longer than the block), the HMAC of the case 5 is truncated to 128 bits.
+ * HKDF - RFC 5869 test cases 1-3 of the HKDF-SHA256: the PRK of the extract, the OKM of the expand and of the hkdf.
+ * PBKDF2 - RFC 7914 section 11 vectors of the PBKDF2-HMAC-SHA256 and the PBKDF2-HMAC-SHA512 vectors, checked by
+ * pbkdf2, by pbkdf2_many of the one password and by pbkdf2_many of the every kernel of the lanes (the first block).
+ * Every vector is checked by the one call, by the pieces of the update (not multiple of the chunk)
+ * and by the threads. The program returns 1 if any vector is bad.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <getopt.h>
+
+#include "k12.h"
+#include "blake3.h"
+#include "hmac.h"
+#include "pbkdf2.h"
+
+// Maximum size of the expected hash
+#define MAX_DIGEST	64
+
+// Maximum size of the inputs of the HMAC and HKDF (key, message, salt, info)
+#define MAX_INPUT	256
+
+// Maximum number of the lanes of the PBKDF2 kernels
+#define MAX_LANES	16
+
+// Maximum size of the output of the KangarooTwelve
+#define MAX_OUT		10032
+
+// Size of the piece of the update: crosses the boundaries of the chunks
+#define PIECE		4099
+
+/*
+ * Variant of the hash calls
+ * name - name of the variant
+ * piece - size of the piece of the update, 0 - the whole message by the one call
+ * nthreads - number of the threads (KangarooTwelve, BLAKE3)
+*/
+struct variant {
+	const char *name;
+	uint32_t piece;
+	int nthreads;
+};
+
+static const struct variant variants[] = { { "oneshot", 0,     1 },
+					   { "pieces",  PIECE, 1 },
+					   { "threads", 0,     4 } };
+
+#define NVARIANTS	((int)(sizeof(variants) / sizeof(variants[0])))
+
+typedef void (*update_t)(void *ctx, const void *message, uint32_t msglen);
+
+/*
+ * Vector of the KangarooTwelve
+ * msglen - the size of the message, fill - the byte of the message, -1 - ptn(msglen)
+ * customlen - the size of the customization string ptn(customlen)
+ * outlen - the size of the hash, digest - the last bytes of the hash
+*/
+struct k12_vector {
+	uint32_t msglen;
+	int fill;
+	uint32_t customlen;
+	uint32_t outlen;
+	const char *digest;
+};
+
+static const struct k12_vector k12_vectors[] = {
+	{        0,   -1,     0,    32, "1AC2D450FC3B4205D19DA7BFCA1B37513C0803577AC7167F06FE2CE1F0EF39E5" },
+	{        0,   -1,     0,    64, "1AC2D450FC3B4205D19DA7BFCA1B37513C0803577AC7167F06FE2CE1F0EF39E5"
+					"4269C056B8C82E48276038B6D292966CC07A3D4645272E31FF38508139EB0A71" },
+	{        0,   -1,     0, 10032, "E8DC563642F7228C84684C898405D3A834799158C079B12880277A1D28E2FF6D" },
+	{        1,   -1,     0,    32, "2BDA92450E8B147F8A7CB629E784A058EFCA7CF7D8218E02D345DFAA65244A1F" },
+	{       17,   -1,     0,    32, "6BF75FA2239198DB4772E36478F8E19B0F371205F6A9A93A273F51DF37122888" },
+	{      289,   -1,     0,    32, "0C315EBCDEDBF61426DE7DCF8FB725D1E74675D7F5327A5067F367B108ECB67C" },
+	{     4913,   -1,     0,    32, "CB552E2EC77D9910701D578B457DDF772C12E322E4EE7FE417F92C758F0D59D0" },
+	{    83521,   -1,     0,    32, "8701045E22205345FF4DDA05555CBB5C3AF1A771C2B89BAEF37DB43D9998B9FE" },
+	{  1419857,   -1,     0,    32, "844D610933B1B9963CBDEB5AE3B6B05CC7CBD67CEEDF883EB678A0A8E0371682" },
+	{ 24137569,   -1,     0,    32, "3C390782A8A4E89FA6367F72FEAAF13255C8D95878481D3CD8CE85F58E880AF8" },
+	{        0,   -1,     1,    32, "FAB658DB63E94A246188BF7AF69A133045F46EE984C56E3C3328CAAF1AA1A583" },
+	{        1, 0xFF,    41,    32, "D848C5068CED736F4462159B9867FD4C20B808ACC3D5BC48E0B06BA0A3762EC4" },
+	{        3, 0xFF,  1681,    32, "C389E5009AE57120854C2E8C64670AC01358CF4C1BAF89447A724234DC7CED74" },
+	{        7, 0xFF, 68921,    32, "75D2F86A2E644566726B4FBCFC5657B9DBCF070C7B0DCA06450AB291D7443BCF" },
+	{     8191,   -1,     0,    32, "1B577636F723643E990CC7D6A659837436FD6A103626600EB8301CD1DBE553D6" },
+	{     8192,   -1,     0,    32, "48F256F6772F9EDFB6A8B661EC92DC93B95EBD05A08A17B39AE3490870C926C3" },
+	{     8192,   -1,  8189,    32, "3ED12F70FB05DDB58689510AB3E4D23C6C6033849AA01E1D8C220A297FEDCD0B" },
+	{     8192,   -1,  8190,    32, "6A7C1B6A5CD0D8C9CA943A4A216CC64604559A2EA45F78570A15253D67BA00AE" },
+	{     8191,   -1,  8190,    32, "6057430F613258F3A047936C8170843A9AF005C09931031BF5333B128F4B9AA8" }
+};
+
+#define K12_NVECTORS	((int)(sizeof(k12_vectors) / sizeof(k12_vectors[0])))
+
+/*
+ * Vector of the BLAKE3
+ * msglen - the size of the message ptn(msglen)
+ * digest - the hash
+*/
+struct blake3_vector {
+	uint32_t msglen;
+	const char *digest;
+};
+
+static const struct blake3_vector blake3_vectors[] = {
+	{      0, "AF1349B9F5F9A1A6A0404DEA36DCC9499BCB25C9ADC112B7CC9A93CAE41F3262" },
+	{      1, "2D3ADEDFF11B61F14C886E35AFA036736DCD87A74D27B5C1510225D0F592E213" },
+	{   1023, "10108970EEDA3EB932BAAC1428C7A2163B0E924C9A9E25B35BBA72B28F70BD11" },
+	{   1024, "42214739F095A406F3FC83DEB889744AC00DF831C10DAA55189B5D121C855AF7" },
+	{   1025, "D00278AE47EB27B34FAECF67B4FE263F82D5412916C1FFD97C8CB7FB814B8444" },
+	{   2048, "E776B6028C7CD22A4D0BA182A8BF62205D2EF576467E838ED6F2529B85FBA24A" },
+	{   8193, "BAB6C09CB8CE8CF459261398D2E7AEF35700BF488116CEB94A36D0F5F1B7BC3B" },
+	{ 102400, "BC3E3D41A1146B069ABFFAD3C0D44860CF664390AFCE4D9661F7902E7943E085" }
+};
+
+#define BLAKE3_NVECTORS	((int)(sizeof(blake3_vectors) / sizeof(blake3_vectors[0])))
+
+// Algorithms of the HMAC vectors
+static const int hmac_algs[] = { HMAC_SHA224, HMAC_SHA256, HMAC_SHA384, HMAC_SHA512 };
+
+static const char *hmac_names[] = { "HMAC-SHA224", "HMAC-SHA256", "HMAC-SHA384", "HMAC-SHA512" };
+
+#define HMAC_NALGS	((int)(sizeof(hmac_algs) / sizeof(hmac_algs[0])))
+
+/*
+ * Vector of the HMAC
+ * key, data - hex of the key and of the message, repeated up to keylen and datalen bytes
+ * outlen - the size of the truncated HMAC, 0 - the whole HMAC
+ * mac - HMAC of the every algorithm of the hmac_algs
+*/
+struct hmac_vector {
+	const char *key;
+	uint32_t keylen;
+	const char *data;
+	uint32_t datalen;
+	int outlen;
+	const char *mac[HMAC_NALGS];
+};
+
+static const struct hmac_vector hmac_vectors[] = {
+	{ "0B", 20, "4869205468657265", 8, 0,
+	  { "896FB1128ABBDF196832107CD49DF33F47B4B1169912BA4F53684B22",
+	    "B0344C61D8DB38535CA8AFCEAF0BF12B881DC200C9833DA726E9376C2E32CFF7",
+	    "AFD03944D84895626B0825F4AB46907F15F9DADBE4101EC682AA034C7CEBC59C"
+	    "FAEA9EA9076EDE7F4AF152E8B2FA9CB6",
+	    "87AA7CDEA5EF619D4FF0B4241A1D6CB02379F4E2CE4EC2787AD0B30545E17CDE"
+	    "DAA833B7D6B8A702038B274EAEA3F4E4BE9D914EEB61F1702E696C203A126854" } },
+	{ "4A656665", 4, "7768617420646F2079612077616E7420666F72206E6F7468696E673F", 28, 0,
+	  { "A30E01098BC6DBBF45690F3A7E9E6D0F8BBEA2A39E6148008FD05E44",
+	    "5BDCC146BF60754E6A042426089575C75A003F089D2739839DEC58B964EC3843",
+	    "AF45D2E376484031617F78D2B58A6B1B9C7EF464F5A01B47E42EC3736322445E"
+	    "8E2240CA5E69E2C78B3239ECFAB21649",
+	    "164B7A7BFCF819E2E395FBE73B56E0A387BD64222E831FD610270CD7EA250554"
+	    "9758BF75C05A994A6D034F65F8F0E6FDCAEAB1A34D4A6B4B636E070A38BCE737" } },
+	{ "AA", 20, "DD", 50, 0,
+	  { "7FB3CB3588C6C1F6FFA9694D7D6AD2649365B0C1F65D69D1EC8333EA",
+	    "773EA91E36800E46854DB8EBD09181A72959098B3EF8C122D9635514CED565FE",
+	    "88062608D3E6AD8A0AA2ACE014C8A86F0AA635D947AC9FEBE83EF4E55966144B"
+	    "2A5AB39DC13814B94E3AB6E101A34F27",
+	    "FA73B0089D56A284EFB0F0756C890BE9B1B5DBDD8EE81A3655F83E33B2279D39"
+	    "BF3E848279A722C806B485A47E67C807B946A337BEE8942674278859E13292FB" } },
+	{ "0102030405060708090A0B0C0D0E0F10111213141516171819", 25, "CD", 50, 0,
+	  { "6C11506874013CAC6A2ABC1BB382627CEC6A90D86EFC012DE7AFEC5A",
+	    "82558A389A443C0EA4CC819899F2083A85F0FAA3E578F8077A2E3FF46729665B",
+	    "3E8A69B7783C25851933AB6290AF6CA77A9981480850009CC5577C6E1F573B4E"
+	    "6801DD23C4A7D679CCF8A386C674CFFB",
+	    "B0BA465637458C6990E5A8C5F61D4AF7E576D97FF94B872DE76F8050361EE3DB"
+	    "A91CA5C11AA25EB4D679275CC5788063A5F19741120C4F2DE2ADEBEB10A298DD" } },
+	{ "0C", 20, "546573742057697468205472756E636174696F6E", 20, 16,
+	  { "0E2AEA68A90C8D37C988BCDB9FCA6FA8",
+	    "A3B6167473100EE06E0C796C2955552B",
+	    "3ABF34C3503B2A23A46EFC619BAEF897",
+	    "415FAD6271580A531D4179BC891D87A6" } },
+	{ "AA", 131, "54657374205573696E67204C6172676572205468616E20426C6F636B2D53697A"
+		     "65204B6579202D2048617368204B6579204669727374", 54, 0,
+	  { "95E9A0DB962095ADAEBE9B2D6F0DBCE2D499F112F2D2B7273FA6870E",
+	    "60E431591EE0B67F0D8A26AACBF5B77F8E0BC6213728C5140546040F0EE37F54",
+	    "4ECE084485813E9088D2C63A041BC5B44F9EF1012A2B588F3CD11F05033AC4C6"
+	    "0C2EF6AB4030FE8296248DF163F44952",
+	    "80B24263C7C1A3EBB71493C1DD7BE8B49B46D1F41B4AEEC1121B013783F8F352"
+	    "6B56D037E05F2598BD0FD2215D6A1E5295E64F73F63F0AEC8B915A985D786598" } },
+	{ "AA", 131, "5468697320697320612074657374207573696E672061206C6172676572207468"
+		     "616E20626C6F636B2D73697A65206B657920616E642061206C61726765722074"
+		     "68616E20626C6F636B2D73697A6520646174612E20546865206B6579206E6565"
+		     "647320746F20626520686173686564206265666F7265206265696E6720757365"
+		     "642062792074686520484D414320616C676F726974686D2E", 152, 0,
+	  { "3A854166AC5D9F023F54D517D0B39DBD946770DB9C2B95C9F6F565D1",
+	    "9B09FFA71B942FCB27635FBCD5B0E944BFDC63644F0713938A7F51535C3A35E2",
+	    "6617178E941F020D351E2F254E8FD32C602420FEB0B8FB9ADCCEBB82461E99C5"
+	    "A678CC31E799176D3860E6110C46523E",
+	    "E37B6A775DC87DBAA4DFA9F96E5E3FFDDEBD71F8867289865DF5A32D20CDC944"
+	    "B6022CAC3C4982B10D5EEB55C3E4DE15134676FB6DE0446065C97440FA8C6A58" } }
+};
+
+#define HMAC_NVECTORS	((int)(sizeof(hmac_vectors) / sizeof(hmac_vectors[0])))
+
+/*
+ * Vector of the HKDF-SHA256
+ * ikm, salt, info - hex of the input key material, of the salt and of the info (empty string - no bytes)
+ * prk - the pseudorandom key of the extract, okm - the okmlen bytes of the key material
+*/
+struct hkdf_vector {
+	const char *ikm;
+	const char *salt;
+	const char *info;
+	uint32_t okmlen;
+	const char *prk;
+	const char *okm;
+};
+
+static const struct hkdf_vector hkdf_vectors[] = {
+	{ "0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B",
+	  "000102030405060708090A0B0C",
+	  "F0F1F2F3F4F5F6F7F8F9", 42,
+	  "077709362C2E32DF0DDC3F0DC47BBA6390B6C73BB50F9C3122EC844AD7C2B3E5",
+	  "3CB25F25FAACD57A90434F64D0362F2A2D2D0A90CF1A5A4C5DB02D56ECC4C5BF"
+	  "34007208D5B887185865" },
+	{ "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+	  "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+	  "404142434445464748494A4B4C4D4E4F",
+	  "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+	  "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+	  "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF",
+	  "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBFC0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+	  "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDFE0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+	  "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF", 82,
+	  "06A6B88C5853361A06104C9CEB35B45CEF760014904671014A193F40C15FC244",
+	  "B11E398DC80327A1C8E7F78C596A49344F012EDA2D4EFAD8A050CC4C19AFA97C"
+	  "59045A99CAC7827271CB41C65E590E09DA3275600C2F09B8367793A9ACA3DB71"
+	  "CC30C58179EC3E87C14C01D5C1F3434F1D87" },
+	{ "0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B",
+	  "",
+	  "", 42,
+	  "19EF24A32C717B167F33A91D6F648BDF96596776AFDB6377AC434C1C293CCB04",
+	  "8DA4E775A563C18F715F802A063C5A31B8A11F5C5EE1879EC3454E5F3C738D2D"
+	  "9D201395FAA4B61A96C8" }
+};
+
+#define HKDF_NVECTORS	((int)(sizeof(hkdf_vectors) / sizeof(hkdf_vectors[0])))
+
+/*
+ * Vector of the PBKDF2
+ * alg - PBKDF2_SHA256 or PBKDF2_SHA512
+ * password, salt - the strings
+ * iterations - the iteration count, out - the derived key
+*/
+struct pbkdf2_vector {
+	int alg;
+	const char *password;
+	const char *salt;
+	uint32_t iterations;
+	const char *out;
+};
+
+static const struct pbkdf2_vector pbkdf2_vectors[] = {
+	{ PBKDF2_SHA256, "passwd", "salt", 1,
+	  "55AC046E56E3089FEC1691C22544B605F94185216DDE0465E68B9D57C20DACBC"
+	  "49CA9CCCF179B645991664B39D77EF317C71B845B1E30BD509112041D3A19783" },
+	{ PBKDF2_SHA256, "Password", "NaCl", 80000,
+	  "4DDCD8F60B98BE21830CEE5EF22701F9641A4418D04C0414AEFF08876B34AB56"
+	  "A1D425A1225833549ADB841B51C9B3176A272BDEBBA1D078478F62B397F33C8D" },
+	{ PBKDF2_SHA512, "password", "salt", 1,
+	  "867F70CF1ADE02CFF3752599A3A53DC4AF34C7A669815AE5D513554E1C8CF252"
+	  "C02D470A285A0501BAD999BFE943C08F050235D7D68B1DA55E63F73B60A57FCE" },
+	{ PBKDF2_SHA512, "passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096,
+	  "8C0511F4C6E597C6AC6315D8F0362E225F3C501495BA23B868C005174DC4EE71"
+	  "115B59F9E60CD9532FA33E0F75AEFE30225C583A186CD82BD4DAEA9724A3D3B8" }
+};
+
+#define PBKDF2_NVECTORS	((int)(sizeof(pbkdf2_vectors) / sizeof(pbkdf2_vectors[0])))
+
+// Kernels of the lanes of the PBKDF2 (pbkdf2_many): n jobs are calculated by the narrowest kernel of n lanes
+static const int pbkdf2_kernels_sha256[] = { 1, 4, 8, 16 };
+static const int pbkdf2_kernels_sha512[] = { 1, 2, 4, 8 };
+
+#define PBKDF2_NKERNELS	4
+
+// Manual
+static void
+help(void)
+{
+	printf("\nThis program tests the HASH functions on the known answers of the specifications!\n");
+	printf("\nUsage: ./hash_test_vectors [options]\n");
+	printf("\nOptions:\n");
+	printf("\t--help(-h) - reference manual\n");
+	printf("\t--verbose(-v) - print every vector\n");
+	printf("\nVectors: KangarooTwelve (RFC 9861), BLAKE3 (test_vectors.json), HMAC (RFC 4231),\n");
+	printf("HKDF-SHA256 (RFC 5869), PBKDF2-HMAC-SHA256 (RFC 7914), PBKDF2-HMAC-SHA512.\n");
+	printf("Every vector is checked by every variant of the hash calls. Exit status 1 if any vector is bad.\n");
+	printf("\nExample: ./hash_test_vectors or ./hash_test_vectors -v\n\n");
+}
+
+// Hex string to the bytes
+// Return value: number of the bytes, -1 (if the string is bad or the bytes are more than max)
+static int
+parse_hex(const char *str, uint8_t *out, int max)
+{
+	int n = 0, hi, lo;
+
+	for(; (str[0] != '\0') && (str[1] != '\0'); str += 2) {
+		if(!isxdigit((unsigned char)str[0]) || !isxdigit((unsigned char)str[1]) || (n == max))
+			return -1;
+
+		hi = isdigit((unsigned char)str[0]) ? str[0] - '0' : (toupper((unsigned char)str[0]) - 'A' + 10);
+		lo = isdigit((unsigned char)str[1]) ? str[1] - '0' : (toupper((unsigned char)str[1]) - 'A' + 10);
+		out[n++] = (hi << 4) | lo;
+	}
+
+	return (str[0] == '\0') ? n : -1;
+}
+
+// Hex pattern repeated up to len bytes
+// Return value: 0 (if all is well), -1 (if the pattern is bad)
+static int
+repeat_hex(const char *str, uint8_t *out, uint32_t len)
+{
+	uint32_t i;
+	int n;
+
+	if((n = parse_hex(str, out, len)) <= 0)
+		return -1;
+
+	for(i = n; i < len; i++)
+		out[i] = out[i - n];
+
+	return 0;
+}
+
+// Pattern of the vectors: ptn(len) - the bytes 00 01 .. FA repeated
+static void
+pattern(uint8_t *buf, uint32_t len)
+{
+	uint32_t i;
+
+	for(i = 0; i < len; i++)
+		buf[i] = i % 251;
+}
+
+// Update of the message by the variant
+static void
+update(void *ctx, update_t upd, const uint8_t *msg, uint32_t msglen, const struct variant *var)
+{
+	uint32_t off, n, step = (var->piece > 0) ? var->piece : msglen;
+
+	// The empty message is the one call of the empty update
+	if(msglen == 0)
+		upd(ctx, msg, 0);
+
+	for(off = 0; off < msglen; off += n) {
+		n = (msglen - off < step) ? msglen - off : step;
+		upd(ctx, msg + off, n);
+	}
+}
+
+// Test the vectors of the KangarooTwelve
+// Return value: number of the failed vectors
+static int
+test_k12(uint8_t *msg, uint8_t *custom, int verbose)
+{
+	const struct k12_vector *v;
+	struct k12_context ctx;
+	uint8_t expect[MAX_DIGEST], *out;
+	int i, k, n, bad = 0, failed;
+
+	if((out = malloc(MAX_OUT)) == NULL) {
+		printf("\nError allocating memory!\n");
+		return K12_NVECTORS;
+	}
+
+	for(i = 0; i < K12_NVECTORS; i++) {
+		v = &k12_vectors[i];
+		n = parse_hex(v->digest, expect, MAX_DIGEST);
+
+		if(v->fill < 0)
+			pattern(msg, v->msglen);
+		else
+			memset(msg, v->fill, v->msglen);
+
+		pattern(custom, v->customlen);
+		failed = 0;
+
+		for(k = 0; k < NVARIANTS; k++) {
+			if(k12_init(&ctx, variants[k].nthreads)) {
+				printf("FAIL KangarooTwelve #%d (%s): initialization\n", i, variants[k].name);
+				failed = 1;
+				continue;
+			}
+
+			update(&ctx, (update_t)k12_update, msg, v->msglen, &variants[k]);
+			k12_final_custom(&ctx, custom, v->customlen, out, v->outlen);
+
+			if((n < 0) || memcmp(out + v->outlen - n, expect, n)) {
+				printf("FAIL KangarooTwelve #%d (%s): M %u bytes, C %u bytes\n", i, variants[k].name,
+				       v->msglen, v->customlen);
+				failed = 1;
+			}
+		}
+
+		if(verbose && !failed)
+			printf("ok   KangarooTwelve #%d: M %u bytes, C %u bytes, %u bytes of the hash\n", i, v->msglen,
+			       v->customlen, v->outlen);
+
+		bad += failed;
+	}
+
+	free(out);
+
+	printf("KangarooTwelve: %d vectors, %d variants: %s\n", K12_NVECTORS, NVARIANTS, bad ? "FAIL" : "ok");
+
+	return bad;
+}
+
+// Test the vectors of the BLAKE3
+// Return value: number of the failed vectors
+static int
+test_blake3(uint8_t *msg, int verbose)
+{
+	const struct blake3_vector *v;
+	struct blake3_context ctx;
+	uint8_t expect[32], out[32];
+	int i, k, n, bad = 0, failed;
+
+	for(i = 0; i < BLAKE3_NVECTORS; i++) {
+		v = &blake3_vectors[i];
+		n = parse_hex(v->digest, expect, sizeof(expect));
+		pattern(msg, v->msglen);
+		failed = 0;
+
+		for(k = 0; k < NVARIANTS; k++) {
+			if(variants[k].nthreads == 1)
+				blake3_init(&ctx);
+			else if(blake3_init_threads(&ctx, variants[k].nthreads)) {
+				printf("FAIL BLAKE3 #%d (%s): initialization\n", i, variants[k].name);
+				failed = 1;
+				continue;
+			}
+
+			update(&ctx, (update_t)blake3_update, msg, v->msglen, &variants[k]);
+			blake3_final(&ctx, out);
+
+			if((n != sizeof(out)) || memcmp(out, expect, n)) {
+				printf("FAIL BLAKE3 #%d (%s): M %u bytes\n", i, variants[k].name, v->msglen);
+				failed = 1;
+			}
+		}
+
+		if(verbose && !failed)
+			printf("ok   BLAKE3 #%d: M %u bytes\n", i, v->msglen);
+
+		bad += failed;
+	}
+
+	printf("BLAKE3: %d vectors, %d variants: %s\n", BLAKE3_NVECTORS, NVARIANTS, bad ? "FAIL" : "ok");
+
+	return bad;
+}
+
+// Test the vectors of the HMAC: the one call and the update of the one byte
+// Return value: number of the failed vectors
+static int
+test_hmac(int verbose)
+{
+	const struct hmac_vector *v;
+	struct hmac_key key;
+	struct hmac_context ctx;
+	uint8_t k[MAX_INPUT], data[MAX_INPUT], expect[HMAC_MAX_SIZE], mac[HMAC_MAX_SIZE], part[HMAC_MAX_SIZE];
+	uint32_t j;
+	int i, a, n, bad = 0, failed;
+
+	for(i = 0; i < HMAC_NVECTORS; i++) {
+		v = &hmac_vectors[i];
+		failed = 0;
+
+		if(repeat_hex(v->key, k, v->keylen) || repeat_hex(v->data, data, v->datalen)) {
+			printf("FAIL HMAC case %d: bad vector\n", i + 1);
+			bad++;
+			continue;
+		}
+
+		for(a = 0; a < HMAC_NALGS; a++) {
+			n = parse_hex(v->mac[a], expect, sizeof(expect));
+
+			if(hmac_set_key(&key, hmac_algs[a], k, v->keylen)) {
+				printf("FAIL %s case %d: key\n", hmac_names[a], i + 1);
+				failed = 1;
+				continue;
+			}
+
+			hmac(&key, data, v->datalen, mac);
+
+			hmac_init(&ctx, &key);
+
+			for(j = 0; j < v->datalen; j++)
+				hmac_update(&ctx, data + j, 1);
+
+			hmac_final(&ctx, part);
+
+			if((n != ((v->outlen > 0) ? v->outlen : hmac_size(hmac_algs[a]))) || memcmp(mac, expect, n) ||
+			   memcmp(part, expect, n)) {
+				printf("FAIL %s case %d\n", hmac_names[a], i + 1);
+				failed = 1;
+			}
+		}
+
+		if(verbose && !failed)
+			printf("ok   HMAC case %d: key %u bytes, data %u bytes\n", i + 1, v->keylen, v->datalen);
+
+		bad += failed;
+	}
+
+	printf("HMAC: %d vectors, %d algorithms: %s\n", HMAC_NVECTORS, HMAC_NALGS, bad ? "FAIL" : "ok");
+
+	return bad;
+}
+
+// Test the vectors of the HKDF-SHA256: extract, expand and hkdf
+// Return value: number of the failed vectors
+static int
+test_hkdf(int verbose)
+{
+	const struct hkdf_vector *v;
+	uint8_t ikm[MAX_INPUT], salt[MAX_INPUT], info[MAX_INPUT], prk[HMAC_MAX_SIZE], okm[MAX_INPUT];
+	uint8_t expect_prk[HMAC_MAX_SIZE], expect_okm[MAX_INPUT];
+	int i, ikmlen, saltlen, infolen, bad = 0, failed;
+
+	for(i = 0; i < HKDF_NVECTORS; i++) {
+		v = &hkdf_vectors[i];
+		failed = 0;
+
+		ikmlen = parse_hex(v->ikm, ikm, sizeof(ikm));
+		saltlen = parse_hex(v->salt, salt, sizeof(salt));
+		infolen = parse_hex(v->info, info, sizeof(info));
+
+		if((ikmlen < 0) || (saltlen < 0) || (infolen < 0) || (parse_hex(v->prk, expect_prk, sizeof(expect_prk)) != 32) ||
+		   (parse_hex(v->okm, expect_okm, sizeof(expect_okm)) != (int)v->okmlen)) {
+			printf("FAIL HKDF-SHA256 case %d: bad vector\n", i + 1);
+			bad++;
+			continue;
+		}
+
+		if(hkdf_extract(HMAC_SHA256, salt, saltlen, ikm, ikmlen, prk) || memcmp(prk, expect_prk, 32)) {
+			printf("FAIL HKDF-SHA256 case %d: extract\n", i + 1);
+			failed = 1;
+		}
+
+		if(hkdf_expand(HMAC_SHA256, expect_prk, 32, info, infolen, okm, v->okmlen) || memcmp(okm, expect_okm, v->okmlen)) {
+			printf("FAIL HKDF-SHA256 case %d: expand\n", i + 1);
+			failed = 1;
+		}
+
+		memset(okm, 0, sizeof(okm));
+
+		if(hkdf(HMAC_SHA256, salt, saltlen, ikm, ikmlen, info, infolen, okm, v->okmlen) ||
+		   memcmp(okm, expect_okm, v->okmlen)) {
+			printf("FAIL HKDF-SHA256 case %d: hkdf\n", i + 1);
+			failed = 1;
+		}
+
+		if(verbose && !failed)
+			printf("ok   HKDF-SHA256 case %d: %u bytes of the key material\n", i + 1, v->okmlen);
+
+		bad += failed;
+	}
+
+	printf("HKDF-SHA256: %d vectors: %s\n", HKDF_NVECTORS, bad ? "FAIL" : "ok");
+
+	return bad;
+}
+
+// Test the vectors of the PBKDF2: pbkdf2, pbkdf2_many of the one password (the all blocks)
+// and pbkdf2_many of the n copies of the password (the first block), n - lanes of the every kernel of the processor
+// Return value: number of the failed vectors
+static int
+test_pbkdf2(int verbose)
+{
+	const struct pbkdf2_vector *v;
+	const uint8_t *password[MAX_LANES];
+	const int *kernels;
+	uint32_t passlen[MAX_LANES], saltlen;
+	uint8_t expect[HMAC_MAX_SIZE * 2], key[MAX_LANES][HMAC_MAX_SIZE * 2], *out[MAX_LANES];
+	int i, j, k, n, size, bad = 0, failed;
+
+	for(i = 0; i < PBKDF2_NVECTORS; i++) {
+		v = &pbkdf2_vectors[i];
+		failed = 0;
+
+		n = parse_hex(v->out, expect, sizeof(expect));
+		size = hmac_size(v->alg);
+		saltlen = strlen(v->salt);
+		kernels = (v->alg == PBKDF2_SHA256) ? pbkdf2_kernels_sha256 : pbkdf2_kernels_sha512;
+
+		for(j = 0; j < MAX_LANES; j++) {
+			password[j] = (const uint8_t *)v->password;
+			passlen[j] = strlen(v->password);
+			out[j] = key[j];
+		}
+
+		if(pbkdf2(v->alg, password[0], passlen[0], (const uint8_t *)v->salt, saltlen, v->iterations, key[0], n) ||
+		   memcmp(key[0], expect, n)) {
+			printf("FAIL PBKDF2 #%d: pbkdf2\n", i);
+			failed = 1;
+		}
+
+		memset(key[0], 0, n);
+
+		if(pbkdf2_many(v->alg, 1, password, passlen, (const uint8_t *)v->salt, saltlen, v->iterations, out, n) ||
+		   memcmp(key[0], expect, n)) {
+			printf("FAIL PBKDF2 #%d: pbkdf2_many of the one password\n", i);
+			failed = 1;
+		}
+
+		for(k = 0; (k < PBKDF2_NKERNELS) && (kernels[k] <= pbkdf2_lanes(v->alg)); k++) {
+			memset(key, 0, sizeof(key));
+
+			if(pbkdf2_many(v->alg, kernels[k], password, passlen, (const uint8_t *)v->salt, saltlen,
+				       v->iterations, out, size)) {
+				printf("FAIL PBKDF2 #%d: pbkdf2_many of the %d lanes\n", i, kernels[k]);
+				failed = 1;
+				continue;
+			}
+
+			for(j = 0; j < kernels[k]; j++) {
+				if(memcmp(key[j], expect, size)) {
+					printf("FAIL PBKDF2 #%d: pbkdf2_many of the %d lanes, password %d\n", i, kernels[k], j);
+					failed = 1;
+					break;
+				}
+			}
+		}
+
+		if(verbose && !failed)
+			printf("ok   PBKDF2-HMAC-SHA%d #%d: %u iterations, kernels up to %d lanes\n",
+			       (v->alg == PBKDF2_SHA256) ? 256 : 512, i, v->iterations, kernels[k - 1]);
+
+		bad += failed;
+	}
+
+	printf("PBKDF2: %d vectors: %s\n", PBKDF2_NVECTORS, bad ? "FAIL" : "ok");
+
+	return bad;
+}
+
+int
+main(int argc, char *argv[])
+{
+	uint8_t *msg, *custom;
+	uint32_t msgmax = 0, custommax = 0;
+	int res, i, verbose = 0, bad = 0;
+
+	const struct option long_option [] = {
+		{"verbose",   0, NULL, 'v'},
+		{"help",      0, NULL, 'h'},
+		{0,  	      0, NULL,  0 }
+	};
+
+	// Parse argument
+	while((res = getopt_long(argc, argv, "vh", long_option, 0)) != -1) {
+		switch(res) {
+		case 'h' : help();
+			   return 0;
+		case 'v' : verbose = 1;
+			   break;
+		}
+	}
+
+	// Buffers of the longest message and customization string
+	for(i = 0; i < K12_NVECTORS; i++) {
+		msgmax = (k12_vectors[i].msglen > msgmax) ? k12_vectors[i].msglen : msgmax;
+		custommax = (k12_vectors[i].customlen > custommax) ? k12_vectors[i].customlen : custommax;
+	}
+
+	for(i = 0; i < BLAKE3_NVECTORS; i++)
+		msgmax = (blake3_vectors[i].msglen > msgmax) ? blake3_vectors[i].msglen : msgmax;
+
+	if(((msg = malloc(msgmax + 1)) == NULL) || ((custom = malloc(custommax + 1)) == NULL)) {
+		printf("\nError allocating memory!\n");
+		return 1;
+	}
+
+	bad += test_k12(msg, custom, verbose);
+	bad += test_blake3(msg, verbose);
+	bad += test_hmac(verbose);
+	bad += test_hkdf(verbose);
+	bad += test_pbkdf2(verbose);
+
+	free(msg);
+	free(custom);
+
+	if(bad) {
+		printf("\n%d vectors failed!\n", bad);
+		return 1;
+	}
+
+	return 0;
+}
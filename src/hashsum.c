@@ -3,18 +3,64 @@
  * Makefile: Makefile_hash
  * Compile: make -f Makefile_hash
  * Example: ./estream -h or ./estream -a 1 -f 1.text or ./estream -t test_string
+ * Several files are hashed concurrently by the thread pool, results are printed in the input order.
+ * Example of the check: ./hashsum -c SHA256SUMS (the algorithm by the size of the hash) or ./hashsum -a 7 -c SHA3SUMS
+ * With the cache (-C file) the unchanged files are not read again.
+ * With the state file (-s file) the hash of the one file is resumed from the saved midstate.
+ * The files of the SHA3 are hashed by the batches in the SIMD lanes (sha3x).
+ * The file truncated while mapped is failed (the SIGBUS handler maps the zero page), the other files go on.
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <getopt.h>
-#include "estream.h"
+#include "md5.h"
+#include "sha1.h"
+#include "sha224.h"
+#include "sha256.h"
+#include "sha384.h"
+#include "sha512.h"
+#include "sha3.h"
+#include "sha3x.h"
+#include "k12.h"
+#include "blake3.h"
+#include "pool.h"
+#include "hashsum_cache.h"
+
+// Size of the read buffer of the file (if mmap is impossible)
+#define READ_BYTES	(1 << 20)
+
+// Maximum bytes of the one update of the mapped file
+#define MAP_BYTES	(1 << 30)
+
+// Size of the piece of the file in the multi-algorithm mode
+#define MULTI_BYTES	(8 << 20)
+
+// Number of the files hashed ahead of the printed file, per thread
+#define WINDOW_FILES	64
+
+// Number of the files of the one batch of the SHA3 (the lane of the finished file takes the next file)
+#define BATCH_FILES	(2 * SHA3X_MAX_LANES)
 
-// Maximum bytes read of the file
-#define READ_BYTES	1000
+// Interval in bytes between the checkpoints of the state file
+#define CHECKPOINT_BYTES	(1ULL << 30)
+
+// Number of the last bytes of the hashed part of the file compared by the resume
+#define TAIL_BYTES	4096
+
+// Magic string and version of the state file
+#define STATE_MAGIC	"HSUMSTAT"
+#define STATE_VERSION	1
 
 // Print the HASH
 #define PRINT_DIGEST(digest, size) { 		\
@@ -24,9 +70,6 @@
 	printf("\n");				\
 }
 
-static void hash_text(void *ctx, int alg, char *text, int size);
-static void hash_file(void *ctx, int alg, char *file_name, int size);
-
 // Union all structures HASH functions
 union context {
 	struct md5_context md5;
@@ -36,57 +79,200 @@ union context {
 	struct sha384_context sha384;
 	struct sha512_context sha512;
 	struct sha3_context sha3;
+	struct k12_context k12;
+	struct blake3_context blake3;
 };
 
-typedef void (*func_t)(void *ctx, const int alg, char *s, int size);
 typedef void (*init_t)(void *ctx, ...);
 typedef void (*update_t)(void *ctx, void *message, uint32_t msglen);
 typedef void (*final_t)(void *ctx, uint8_t *digest);
+typedef void (*init_pool_t)(void *ctx, struct pool *pool);
+typedef void (*export_t)(void *ctx, uint8_t *state);
+typedef int (*import_t)(void *ctx, const uint8_t *state);
 
 // Pointer of the function HASH functions
-func_t func[] = { (func_t)hash_text,
-		  (func_t)hash_file };
-
-init_t init[] = { (init_t)md5_init,
-		  (init_t)sha1_init,
-		  (init_t)sha224_init,
-		  (init_t)sha256_init,
-		  (init_t)sha384_init,
-		  (init_t)sha512_init,
-		  (init_t)sha3_init };
-
-update_t update[] = { (update_t)md5_update,
-		      (update_t)sha1_update,
-		      (update_t)sha224_update,
-		      (update_t)sha256_update,
-		      (update_t)sha384_update,
-		      (update_t)sha512_update,
-		      (update_t)sha3_update };
-
-final_t final[] = { (final_t)md5_final,
-		    (final_t)sha1_final,
-		    (final_t)sha224_final,
-		    (final_t)sha256_final,
-		    (final_t)sha384_final,
-		    (final_t)sha512_final,
-		    (final_t)sha3_final };
+static const init_t init[] = { (init_t)md5_init,
+			       (init_t)sha1_init,
+			       (init_t)sha224_init,
+			       (init_t)sha256_init,
+			       (init_t)sha384_init,
+			       (init_t)sha512_init,
+			       (init_t)sha3_init,
+			       (init_t)k12_init,
+			       (init_t)blake3_init_threads };
+
+static const update_t update[] = { (update_t)md5_update,
+				   (update_t)sha1_update,
+				   (update_t)sha224_update,
+				   (update_t)sha256_update,
+				   (update_t)sha384_update,
+				   (update_t)sha512_update,
+				   (update_t)sha3_update,
+				   (update_t)k12_update,
+				   (update_t)blake3_update };
+
+static const final_t final[] = { (final_t)md5_final,
+				 (final_t)sha1_final,
+				 (final_t)sha224_final,
+				 (final_t)sha256_final,
+				 (final_t)sha384_final,
+				 (final_t)sha512_final,
+				 (final_t)sha3_final,
+				 (final_t)k12_final,
+				 (final_t)blake3_final };
+
+// Initialization of the tree hash by the shared pool, NULL - the hash is not the tree
+static const init_pool_t init_pool[] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+					 (init_pool_t)k12_init_pool,
+					 (init_pool_t)blake3_init_pool };
+
+// Export and import of the midstate
+static const export_t export_state[] = { (export_t)md5_export_state,
+					 (export_t)sha1_export_state,
+					 (export_t)sha224_export_state,
+					 (export_t)sha256_export_state,
+					 (export_t)sha384_export_state,
+					 (export_t)sha512_export_state,
+					 (export_t)sha3_export_state,
+					 (export_t)k12_export_state,
+					 (export_t)blake3_export_state };
+
+static const import_t import_state[] = { (import_t)md5_import_state,
+					 (import_t)sha1_import_state,
+					 (import_t)sha224_import_state,
+					 (import_t)sha256_import_state,
+					 (import_t)sha384_import_state,
+					 (import_t)sha512_import_state,
+					 (import_t)sha3_import_state,
+					 (import_t)k12_import_state,
+					 (import_t)blake3_import_state };
+
+// Size of the midstate
+static const int state_size[9] = { MD5_STATE_SIZE, SHA1_STATE_SIZE, SHA224_STATE_SIZE, SHA256_STATE_SIZE,
+				   SHA384_STATE_SIZE, SHA512_STATE_SIZE, SHA3_STATE_SIZE, K12_STATE_SIZE,
+				   BLAKE3_STATE_SIZE };
 
 // Hash size
-static const int hash_size[10] = { 16, 20, 28, 32, 48, 64, 28, 32, 48, 64 };
+static const int hash_size[12] = { 16, 20, 28, 32, 48, 64, 28, 32, 48, 64, 32, 32 };
+
+// Index of the init/update/final functions of the algorithm
+static const int index_func[12] = { 0, 1, 2, 3, 4, 5, 6, 6, 6, 6, 7, 8 };
+
+// Parameter of the init function: size of the SHA3 hash, -1 - number of the threads
+static const int init_size[12] = { 0, 0, 0, 0, 0, 0, 224, 256, 384, 512, -1, -1 };
+
+// Name of the algorithm
+static const char *hash_name[12] = { "MD5", "SHA1", "SHA224", "SHA256", "SHA384", "SHA512",
+				     "SHA3/224", "SHA3/256", "SHA3/384", "SHA3/512",
+				     "KangarooTwelve", "BLAKE3" };
+
+/*
+ * File of the multi-file mode
+ * file_name - name of the file
+ * expect - expected hash (hex) of the check mode, NULL if the hash is printed
+ * alg - algorithm
+ * size - parameter of the init function
+ * pool - shared pool of the tree hashes
+ * res - result: 0 (if all is well), -1 (if all bad)
+ * done - the hash is calculated
+ * digest - hash of the file
+*/
+struct hash_job {
+	const char *file_name;
+	const char *expect;
+	int alg;
+	int size;
+	struct pool *pool;
+	int res;
+	int done;
+	uint8_t digest[64];
+};
+
+/*
+ * Batch of the SHA3 files: the files are hashed together by the SIMD lanes
+ * n - number of the files
+ * job - jobs of the files
+*/
+struct hash_batch {
+	int n;
+	struct hash_job *job[BATCH_FILES];
+};
+
+/*
+ * Header of the state file, the midstate follows the header
+ * magic - STATE_MAGIC
+ * version - STATE_VERSION
+ * alg - algorithm
+ * dev, ino - hashed file
+ * offset - size in bytes of the hashed part of the file
+ * tail - SHA256 of the last TAIL_BYTES bytes of the hashed part (the part is not changed)
+*/
+struct state_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t alg;
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t offset;
+	uint8_t tail[32];
+};
+
+// Cache of the results, NULL if no cache
+static struct hash_cache *cache;
+
+// Hash the files even if the cache has the result
+static int refresh;
+
+// Page size and the number of the SIGBUS of the mapped files (sigbus_handler)
+static long page_size;
+static unsigned long sigbus_count;
+
+// Completion of the jobs of the multi-file mode
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+struct hash_multi;
+
+/*
+ * Task of the multi-algorithm mode
+ * multi - state of the mode
+ * i - number of the algorithm
+*/
+struct hash_multi_task {
+	struct hash_multi *multi;
+	int i;
+};
+
+/*
+ * Multi-algorithm mode: the file is read once, every piece is hashed by all algorithms,
+ * each algorithm in its own thread of the pool
+ * n - number of the algorithms
+ * alg - algorithms
+ * context - contexts of the algorithms
+ * task - tasks of the algorithms
+ * data, len - current piece of the file
+ * pool - thread pool, NULL if one thread
+*/
+struct hash_multi {
+	int n;
+	int alg[12];
+	union context context[12];
+	struct hash_multi_task task[12];
+	const uint8_t *data;
+	uint32_t len;
+	struct pool *pool;
+};
 
 // Calculate the HASH of the text string
+// size - parameter of the init function: size of the SHA3 hash or number of the threads
 static void
 hash_text(void *ctx, int alg, char *text, int size)
 {
 	uint8_t digest[hash_size[alg]];
 	int tmp = alg;
 
-	if(size != 0) {
-		alg = 6;
-		init[alg](ctx, size);
-	}
-	else
-		init[alg](ctx);
+	alg = index_func[alg];
+	init[alg](ctx, size);
 
 	update[alg](ctx, text, strlen(text));
 	final[alg](ctx, digest);
@@ -94,35 +280,748 @@ hash_text(void *ctx, int alg, char *text, int size)
 	PRINT_DIGEST(digest, hash_size[tmp]);
 }
 
-// Calculate the HASH of the file
+// SIGBUS of the page after the end of the file truncated while mapped (any thread, also the threads
+// of the tree hash): the page is replaced by the zero page, the hash goes on and the file is failed
+// by the map_truncated. Other SIGBUS - the default action (the fault is repeated after the return).
 static void
-hash_file(void *ctx, int alg, char *file_name, int size)
+sigbus_handler(int sig, siginfo_t *info, void *uc)
 {
-	FILE *fp;
-	uint8_t digest[hash_size[alg]], buf[READ_BYTES];
-	uint32_t byte;
-	int tmp = alg;
+	void *page = (void *)((uintptr_t)info->si_addr & ~(uintptr_t)(page_size - 1));
+
+	if((info->si_code != BUS_ADRERR) ||
+	   (mmap(page, page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED))
+		signal(SIGBUS, SIG_DFL);
+	else
+		__atomic_add_fetch(&sigbus_count, 1, __ATOMIC_RELAXED);
+}
+
+// The file is not changed: the same size and time of the modification
+static int
+file_same(const struct stat *st1, const struct stat *st2)
+{
+	return (st1->st_size == st2->st_size) && (st1->st_mtim.tv_sec == st2->st_mtim.tv_sec) &&
+	       (st1->st_mtim.tv_nsec == st2->st_mtim.tv_nsec);
+}
+
+// The file is truncated while mapped: the zero pages are hashed instead of the end of the file
+// fd - descriptor and st - stat of the mapped file, faults - sigbus_count before the hash
+// Return value: 1 (the file is failed, the message is printed), 0 (the mapped data are of the file)
+static int
+map_truncated(const char *file_name, int fd, const struct stat *st, unsigned long faults)
+{
+	struct stat st2;
+
+	// Shorter file or, after the SIGBUS, the file written again
+	if(fstat(fd, &st2) || (st2.st_size < st->st_size) ||
+	   ((__atomic_load_n(&sigbus_count, __ATOMIC_RELAXED) != faults) && !file_same(st, &st2))) {
+		fprintf(stderr, "The file is truncated while hashed - %s!\n", file_name);
+		return 1;
+	}
+
+	return 0;
+}
+
+// Feed the file to the hash: mmap of the regular file, else read by the large aligned buffer
+// feed - function taking the pieces of the file (update function of the hash)
+// piece - maximum bytes of the one piece of the mapped file
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+read_file(const char *file_name, update_t feed, void *arg, uint32_t piece)
+{
+	struct stat st;
+	uint8_t *map, *buf;
+	ssize_t byte;
+	off_t off;
+	uint32_t n;
+	unsigned long faults = __atomic_load_n(&sigbus_count, __ATOMIC_RELAXED);
+	int fd, res;
 
-	if((fp = fopen(file_name, "rb+")) == NULL) {
-		printf("Error openning the file - %s!\n", file_name);
-		return;
+	if((fd = open(file_name, O_RDONLY)) < 0)
+		return -1;
+
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	if((fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size > 0) &&
+	   ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED)) {
+		madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+		for(off = 0; off < st.st_size; off += n) {
+			n = (st.st_size - off < piece) ? st.st_size - off : piece;
+			feed(arg, map + off, n);
+		}
+
+		res = map_truncated(file_name, fd, &st, faults) ? -1 : 0;
+		munmap(map, st.st_size);
+		close(fd);
+		return res;
 	}
-	
-	if(size != 0) {
-		alg = 6;
-		init[alg](ctx, size);
+
+	// Pipe, device or empty file
+	if(posix_memalign((void **)&buf, 4096, READ_BYTES)) {
+		close(fd);
+		return -1;
 	}
+
+	while((byte = read(fd, buf, READ_BYTES)) > 0)
+		feed(arg, buf, byte);
+
+	free(buf);
+	close(fd);
+
+	return (byte < 0) ? -1 : 0;
+}
+
+// Stat of the file for the cache
+// Return value: 1 (the file may be cached), 0 (no cache or not the regular file)
+static int
+cache_stat(const char *file_name, struct stat *st)
+{
+	return (cache != NULL) && !stat(file_name, st) && S_ISREG(st->st_mode);
+}
+
+// Calculate the HASH of the file
+// pool - shared pool of the tree hash (the large file is split between the threads), may be NULL
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+hash_file(void *ctx, int alg, const char *file_name, int size, struct pool *pool, uint8_t *digest)
+{
+	struct stat st, st2;
+	int res, f, cached;
+
+	// Unchanged file - the hash of the cache
+	cached = cache_stat(file_name, &st);
+
+	if(cached && !refresh && !cache_lookup(cache, &st, alg, digest, hash_size[alg]))
+		return 0;
+
+	f = index_func[alg];
+
+	if((pool != NULL) && (init_pool[f] != NULL))
+		init_pool[f](ctx, pool);
 	else
-		init[alg](ctx);
+		init[f](ctx, size);
 
-	while((byte = fread(buf, 1, READ_BYTES, fp)) > 0)
-		update[alg](ctx, buf, byte);
+	res = read_file(file_name, update[f], ctx, MAP_BYTES);
 
+	// Final also frees the resources of the context
+	final[f](ctx, digest);
+
+	// The file changed while hashed is not cached
+	if(cached && !res && !stat(file_name, &st2) && file_same(&st, &st2))
+		cache_store(cache, &st, alg, digest, hash_size[alg]);
+
+	return res;
+}
+
+// SHA256 of the last TAIL_BYTES bytes of the first offset bytes of the file
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+state_tail(int fd, uint64_t offset, uint8_t tail[32])
+{
+	struct sha256_context ctx;
+	uint8_t buf[TAIL_BYTES];
+	uint64_t len;
+
+	len = (offset < TAIL_BYTES) ? offset : TAIL_BYTES;
+
+	if(pread(fd, buf, len, offset - len) != len)
+		return -1;
+
+	sha256_init(&ctx);
+	sha256_update(&ctx, buf, len);
+	sha256_final(&ctx, tail);
+
+	return 0;
+}
+
+// Save the midstate of the first offset bytes of the file: the new state file replaces the old one
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+state_save(const char *state_name, void *ctx, int alg, int fd, const struct stat *st, uint64_t offset)
+{
+	struct state_header h;
+	uint8_t state[K12_STATE_SIZE];
+	char tmp_name[strlen(state_name) + 5];
+	FILE *fp;
+	int res;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, STATE_MAGIC, 8);
+	h.version = STATE_VERSION;
+	h.alg = alg;
+	h.dev = st->st_dev;
+	h.ino = st->st_ino;
+	h.offset = offset;
+
+	if(state_tail(fd, offset, h.tail))
+		return -1;
+
+	export_state[index_func[alg]](ctx, state);
+
+	sprintf(tmp_name, "%s.tmp", state_name);
+
+	if((fp = fopen(tmp_name, "wb")) == NULL)
+		return -1;
+
+	res = (fwrite(&h, sizeof(h), 1, fp) != 1) || (fwrite(state, state_size[index_func[alg]], 1, fp) != 1);
+	res |= fflush(fp) || fsync(fileno(fp));
+	res |= fclose(fp);
+
+	if(res || rename(tmp_name, state_name)) {
+		unlink(tmp_name);
+		return -1;
+	}
+
+	return 0;
+}
+
+// Load the midstate of the file, the context is initialized
+// Return value: size in bytes of the hashed part of the file, 0 (no state or the state of the other file)
+static uint64_t
+state_load(const char *state_name, void *ctx, int alg, int fd, const struct stat *st)
+{
+	struct state_header h;
+	uint8_t state[K12_STATE_SIZE], tail[32];
+	FILE *fp;
+	int res;
+
+	if((fp = fopen(state_name, "rb")) == NULL)
+		return 0;
+
+	res = (fread(&h, sizeof(h), 1, fp) != 1) || (fread(state, state_size[index_func[alg]], 1, fp) != 1);
 	fclose(fp);
 
-	final[alg](ctx, digest);
+	// The same file, the hashed part is not changed (the file is appended)
+	if(res || memcmp(h.magic, STATE_MAGIC, 8) || (h.version != STATE_VERSION) || (h.alg != alg) ||
+	   (h.dev != st->st_dev) || (h.ino != st->st_ino) || (h.offset > st->st_size) ||
+	   state_tail(fd, h.offset, tail) || memcmp(tail, h.tail, 32))
+		return 0;
 
-	PRINT_DIGEST(digest, hash_size[tmp]);
+	if(import_state[index_func[alg]](ctx, state))
+		return 0;
+
+	return h.offset;
+}
+
+// Calculate the HASH of the file resumed from the state file
+// The state is saved every CHECKPOINT_BYTES bytes and at the end of the file,
+// so the interrupted hash is continued and the appended file is hashed from the old end
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+hash_resume(void *ctx, int alg, const char *file_name, int size, const char *state_name, uint8_t *digest)
+{
+	struct stat st;
+	uint8_t *map = NULL;
+	uint64_t off, next;
+	uint32_t n;
+	unsigned long faults = __atomic_load_n(&sigbus_count, __ATOMIC_RELAXED);
+	int fd, f, res = 0;
+
+	if((fd = open(file_name, O_RDONLY)) < 0)
+		return -1;
+
+	if(fstat(fd, &st) || !S_ISREG(st.st_mode) ||
+	   ((st.st_size > 0) && ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED))) {
+		close(fd);
+		return -1;
+	}
+
+	f = index_func[alg];
+	init[f](ctx, size);
+
+	if((off = state_load(state_name, ctx, alg, fd, &st)) > 0)
+		fprintf(stderr, "Resumed from %llu bytes\n", (unsigned long long)off);
+
+	if(off < st.st_size)
+		madvise(map + off, st.st_size - off, MADV_SEQUENTIAL);
+
+	for(next = off + CHECKPOINT_BYTES; off < st.st_size; off += n) {
+		n = (st.st_size - off < MAP_BYTES) ? st.st_size - off : MAP_BYTES;
+		update[f](ctx, map + off, n);
+
+		// The midstate of the zero pages of the truncated file is not saved
+		if((off + n >= next) && (off + n < st.st_size)) {
+			if((res = map_truncated(file_name, fd, &st, faults)))
+				break;
+
+			state_save(state_name, ctx, alg, fd, &st, off + n);
+			next = off + n + CHECKPOINT_BYTES;
+		}
+	}
+
+	if(!res && (st.st_size > 0))
+		res = map_truncated(file_name, fd, &st, faults);
+
+	// Midstate of the whole file: the appended file is continued from here
+	if(!res && state_save(state_name, ctx, alg, fd, &st, st.st_size))
+		printf("Error saving the state - %s!\n", state_name);
+
+	final[f](ctx, digest);
+
+	if(map != NULL)
+		munmap(map, st.st_size);
+
+	close(fd);
+
+	return res ? -1 : 0;
+}
+
+// Task of the pool: HASH of the one file
+static void
+hash_job_run(void *arg)
+{
+	struct hash_job *job = arg;
+	union context context;
+
+	job->res = hash_file(&context, job->alg, job->file_name, job->size, job->pool, job->digest);
+
+	pthread_mutex_lock(&job_lock);
+	job->done = 1;
+	pthread_cond_broadcast(&job_done);
+	pthread_mutex_unlock(&job_lock);
+}
+
+// Map the regular file no more than MAP_BYTES bytes (the message of the lane)
+// fd - descriptor (closed by the caller) and st - stat of the mapped file
+// Return value: 0 (if all is well), -1 (the file is hashed by the one stream)
+static int
+map_file(const char *file_name, uint8_t **map, uint32_t *len, int *fd, struct stat *st)
+{
+	if((*fd = open(file_name, O_RDONLY)) < 0)
+		return -1;
+
+	if(fstat(*fd, st) || !S_ISREG(st->st_mode) || (st->st_size > MAP_BYTES)) {
+		close(*fd);
+		return -1;
+	}
+
+	*map = NULL;
+	*len = st->st_size;
+
+	if((st->st_size > 0) && ((*map = mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, *fd, 0)) == MAP_FAILED)) {
+		close(*fd);
+		return -1;
+	}
+
+	return 0;
+}
+
+// Task of the pool: HASH of the batch of the SHA3 files
+static void
+hash_batch_run(void *arg)
+{
+	struct hash_batch *batch = arg;
+	struct hash_job *job;
+	struct stat st[BATCH_FILES], mst[BATCH_FILES], st2;
+	union context context;
+	const void *message[BATCH_FILES];
+	uint32_t msglen[BATCH_FILES];
+	uint8_t *map[BATCH_FILES], *digest[BATCH_FILES];
+	int lane[BATCH_FILES], cached[BATCH_FILES], fd[BATCH_FILES];
+	unsigned long faults = __atomic_load_n(&sigbus_count, __ATOMIC_RELAXED);
+	int i, m;
+
+	for(i = m = 0; i < batch->n; i++) {
+		job = batch->job[i];
+		job->res = 0;
+		cached[m] = cache_stat(job->file_name, &st[m]);
+
+		// Pipe, device or large file - the one stream
+		if(map_file(job->file_name, &map[m], &msglen[m], &fd[m], &mst[m])) {
+			job->res = hash_file(&context, job->alg, job->file_name, job->size, NULL, job->digest);
+			continue;
+		}
+
+		// Unchanged file - the hash of the cache
+		if(cached[m] && !refresh && !cache_lookup(cache, &st[m], job->alg, job->digest, hash_size[job->alg])) {
+			if(map[m] != NULL)
+				munmap(map[m], msglen[m]);
+
+			close(fd[m]);
+			continue;
+		}
+
+		message[m] = (map[m] != NULL) ? map[m] : (const uint8_t *)"";
+		digest[m] = job->digest;
+		lane[m++] = i;
+	}
+
+	if(m > 0)
+		sha3x_hash(batch->job[0]->size, m, message, msglen, digest);
+
+	for(i = 0; i < m; i++) {
+		job = batch->job[lane[i]];
+
+		if(map[i] != NULL) {
+			job->res = map_truncated(job->file_name, fd[i], &mst[i], faults) ? -1 : 0;
+			munmap(map[i], msglen[i]);
+		}
+
+		close(fd[i]);
+
+		// The file changed while hashed is not cached
+		if(cached[i] && !job->res && !stat(job->file_name, &st2) && file_same(&st[i], &st2))
+			cache_store(cache, &st[i], job->alg, job->digest, hash_size[job->alg]);
+	}
+
+	pthread_mutex_lock(&job_lock);
+
+	for(i = 0; i < batch->n; i++)
+		batch->job[i]->done = 1;
+
+	pthread_cond_broadcast(&job_done);
+	pthread_mutex_unlock(&job_lock);
+}
+
+// Compare the hash with the hex string
+// Return value: 0 (if equal), -1 (if not)
+static int
+digest_compare(const uint8_t *digest, int size, const char *hex)
+{
+	char byte[3];
+	int i;
+
+	if(strlen(hex) != size * 2)
+		return -1;
+
+	for(i = 0; i < size; i++) {
+		sprintf(byte, "%02x", digest[i]);
+
+		if(strncasecmp(byte, hex + i * 2, 2))
+			return -1;
+	}
+
+	return 0;
+}
+
+// Calculate the HASH of the files by the thread pool, print in the input order
+// expect - expected hashes of the check mode, NULL if the hashes are printed
+// threads - number of the threads, 0 - number of the processors
+// The large file of the tree hash is split between the threads of the same pool,
+// the SHA3 files are hashed by the batches of the BATCH_FILES files
+// Return value: number of the failed files
+static int
+hash_files(int alg, char *file_name[], char *expect[], int n, int size, int threads)
+{
+	struct hash_job *job, *p;
+	struct hash_batch *batch, *b;
+	struct pool *pool;
+	int window, next, fail, nbatch, m, i, j;
+
+	pool = pool_create(threads);
+	window = WINDOW_FILES * ((pool != NULL) ? pool_threads(pool) : 1);
+
+	// One file of the job - other algorithms
+	nbatch = (init[index_func[alg]] == (init_t)sha3_init) ? BATCH_FILES : 1;
+
+	job = calloc(window, sizeof(*job));
+	batch = calloc(window, sizeof(*batch));
+
+	if((job == NULL) || (batch == NULL)) {
+		printf("Error allocating memory!\n");
+
+		if(pool != NULL)
+			pool_destroy(pool);
+
+		free(job);
+		free(batch);
+
+		return n;
+	}
+
+	for(i = next = fail = 0; i < n; i++) {
+
+		// Submit the files of the window by the whole batches
+		while(next < n) {
+			m = (n - next < nbatch) ? n - next : nbatch;
+
+			if(next - i + m > window)
+				break;
+
+			b = &batch[next % window];
+
+			for(b->n = 0; b->n < m; next++) {
+				p = &job[next % window];
+				p->file_name = file_name[next];
+				p->expect = (expect != NULL) ? expect[next] : NULL;
+				p->alg = alg;
+				p->size = size;
+				p->pool = pool;
+				p->done = 0;
+				b->job[b->n++] = p;
+			}
+
+			// No pool - in this thread
+			if(nbatch == 1) {
+				if((pool == NULL) || pool_submit(pool, hash_job_run, b->job[0]))
+					hash_job_run(b->job[0]);
+			}
+			else if((pool == NULL) || pool_submit(pool, hash_batch_run, b))
+				hash_batch_run(b);
+		}
+
+		p = &job[i % window];
+
+		pthread_mutex_lock(&job_lock);
+
+		while(!p->done)
+			pthread_cond_wait(&job_done, &job_lock);
+
+		pthread_mutex_unlock(&job_lock);
+
+		if(p->res) {
+			fail++;
+
+			if(expect != NULL)
+				printf("%s: FAILED open or read\n", p->file_name);
+			else
+				printf("Error openning the file - %s!\n", p->file_name);
+
+			continue;
+		}
+
+		if(expect != NULL) {
+			if(digest_compare(p->digest, hash_size[alg], p->expect)) {
+				fail++;
+				printf("%s: FAILED\n", p->file_name);
+			}
+			else
+				printf("%s: OK\n", p->file_name);
+
+			continue;
+		}
+
+		for(j = 0; j < hash_size[alg]; j++)
+			printf("%02X", p->digest[j]);
+
+		printf("  %s\n", p->file_name);
+	}
+
+	if(pool != NULL)
+		pool_destroy(pool);
+
+	free(job);
+	free(batch);
+
+	return fail;
+}
+
+// Read the manifest: lines "hash  file" (or "hash *file") of the sha256sum format
+// text - contents of the manifest, files and expect point to it
+// Return value: number of the files or -1 (if all bad)
+static int
+read_manifest(const char *manifest, char **text, char ***files, char ***expect)
+{
+	FILE *fp;
+	long len;
+	char *line, *end, *name;
+	int n, max;
+
+	if((fp = fopen(manifest, "rb")) == NULL)
+		return -1;
+
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if((len < 0) || ((*text = malloc(len + 1)) == NULL)) {
+		fclose(fp);
+		return -1;
+	}
+
+	len = fread(*text, 1, len, fp);
+	(*text)[len] = '\0';
+	fclose(fp);
+
+	// Upper bound of the number of the lines
+	for(max = 1, line = *text; (line = strchr(line, '\n')) != NULL; line++)
+		max++;
+
+	*files = malloc(max * sizeof(char *));
+	*expect = malloc(max * sizeof(char *));
+
+	if((*files == NULL) || (*expect == NULL)) {
+		free(*files);
+		free(*expect);
+		free(*text);
+		return -1;
+	}
+
+	for(n = 0, line = *text; line != NULL; line = end) {
+		if((end = strchr(line, '\n')) != NULL)
+			*end++ = '\0';
+
+		if(line[strcspn(line, "\r")] == '\r')
+			line[strcspn(line, "\r")] = '\0';
+
+		if((*line == '\0') || (*line == '#'))
+			continue;
+
+		// Hash, space, space or '*' (binary), name of the file
+		if(((name = strchr(line, ' ')) == NULL) || ((name[1] != ' ') && (name[1] != '*')) || (name[2] == '\0')) {
+			printf("Improperly formatted line - %s\n", line);
+			continue;
+		}
+
+		*name = '\0';
+		(*expect)[n] = line;
+		(*files)[n++] = name + 2;
+	}
+
+	return n;
+}
+
+// Algorithm of the manifest by the size of the hash: MD5, SHA1 or SHA2 (md5sum, sha1sum, sha256sum ...),
+// the SHA3 of the same size is selected by the -a option
+// Return value: number of the algorithm or -1 (if the size is unknown)
+static int
+manifest_alg(const char *hex)
+{
+	int i;
+
+	for(i = 0; i <= 5; i++) {
+		if(strlen(hex) == hash_size[i] * 2)
+			return i;
+	}
+
+	return -1;
+}
+
+// Check the files of the manifest in parallel
+// alg - algorithm, -1 - by the size of the first hash of the manifest
+// Return value: 0 (if all is well), 1 (if some files failed)
+static int
+check_manifest(int alg, const char *manifest, int threads)
+{
+	char *text, **files, **expect;
+	int n, fail;
+
+	if((n = read_manifest(manifest, &text, &files, &expect)) < 0) {
+		printf("Error openning the file - %s!\n", manifest);
+		return 1;
+	}
+
+	if((alg < 0) && ((n == 0) || ((alg = manifest_alg(expect[0])) < 0))) {
+		printf("Unknown size of the hash - %s, select the algorithm (-a)!\n", manifest);
+		free(files);
+		free(expect);
+		free(text);
+		return 1;
+	}
+
+	fail = hash_files(alg, files, expect, n, (init_size[alg] < 0) ? 1 : init_size[alg], threads);
+
+	if(fail > 0)
+		printf("WARNING: %d of %d files FAILED\n", fail, n);
+
+	free(files);
+	free(expect);
+	free(text);
+
+	return (fail > 0) ? 1 : 0;
+}
+
+// Task of the pool: the piece of the file by the one algorithm
+static void
+hash_multi_run(void *arg)
+{
+	struct hash_multi_task *task = arg;
+	struct hash_multi *multi = task->multi;
+
+	update[index_func[multi->alg[task->i]]](&multi->context[task->i], (void *)multi->data, multi->len);
+}
+
+// Feed function of the multi-algorithm mode: all algorithms hash the piece in parallel
+static void
+hash_multi_feed(void *arg, void *data, uint32_t len)
+{
+	struct hash_multi *multi = arg;
+	int i;
+
+	multi->data = data;
+	multi->len = len;
+
+	for(i = 0; i < multi->n; i++) {
+		if((multi->pool == NULL) || pool_submit(multi->pool, hash_multi_run, &multi->task[i]))
+			hash_multi_run(&multi->task[i]);
+	}
+
+	// The piece may be reused by the reader after all algorithms
+	if(multi->pool != NULL)
+		pool_wait(multi->pool);
+}
+
+// Calculate the HASH of the files by the several algorithms, every file is read once
+// threads - number of the threads of the KangarooTwelve and BLAKE3
+// Return value: number of the failed files
+static int
+hash_multi_files(int n, const int alg[], char *file_name[], int nfiles, int threads)
+{
+	struct hash_multi *multi;
+	struct stat st, st2;
+	uint8_t digest[12][64], *out;
+	int i, j, res, size, cached, hits, fail = 0;
+
+	if((multi = malloc(sizeof(*multi))) == NULL) {
+		printf("Error allocating memory!\n");
+		return nfiles;
+	}
+
+	multi->n = n;
+	multi->pool = pool_create(n);
+
+	for(i = 0; i < n; i++) {
+		multi->alg[i] = alg[i];
+		multi->task[i].multi = multi;
+		multi->task[i].i = i;
+	}
+
+	for(j = 0; j < nfiles; j++) {
+
+		// The file is read only if some hash is not in the cache
+		cached = cache_stat(file_name[j], &st);
+
+		for(i = hits = 0; cached && !refresh && (i < n); i++)
+			hits += !cache_lookup(cache, &st, alg[i], digest[i], hash_size[alg[i]]);
+
+		if(hits < n) {
+			for(i = 0; i < n; i++)
+				init[index_func[alg[i]]](&multi->context[i], (init_size[alg[i]] < 0) ? threads : init_size[alg[i]]);
+
+			res = read_file(file_name[j], hash_multi_feed, multi, MULTI_BYTES);
+
+			// Final also frees the resources of the context
+			for(i = 0; i < n; i++)
+				final[index_func[alg[i]]](&multi->context[i], digest[i]);
+
+			if(cached && !res && !stat(file_name[j], &st2) && file_same(&st, &st2)) {
+				for(i = 0; i < n; i++)
+					cache_store(cache, &st, alg[i], digest[i], hash_size[alg[i]]);
+			}
+		}
+		else
+			res = 0;
+
+		for(i = 0; !res && (i < n); i++) {
+			size = hash_size[alg[i]];
+			out = digest[i];
+
+			printf("%s (%s) = ", hash_name[alg[i]], file_name[j]);
+			PRINT_DIGEST(out, size);
+		}
+
+		if(res) {
+			fail++;
+			printf("Error openning the file - %s!\n", file_name[j]);
+		}
+	}
+
+	if(multi->pool != NULL)
+		pool_destroy(multi->pool);
+
+	free(multi);
+
+	return fail;
 }
 
 // Manual of the program
@@ -133,26 +1032,48 @@ help(void)
 	printf("\nOptions:\n");
 	printf("\t--help(-h) - reference manual\n");
 	printf("\t--text(-t) - the string that needs the HASH to be calculated\n");
-	printf("\t--file(-f) - the file name that needs the HASH to be calculated\n");
-	printf("\t--algorithm(-a) - selection type HASH\n");
+	printf("\t--file(-f) - the file name that needs the HASH to be calculated (the option may be repeated,\n");
+	printf("\t\tthe other arguments are the files too)\n");
+	printf("\t--threads(-j) - number of the threads, 0 - all processors: the files are hashed in parallel,\n");
+	printf("\t\tone file - the threads of the KangarooTwelve and BLAKE3\n");
+	printf("\t--check(-c) - check the hashes of the files of the list (sha256sum format) in parallel,\n");
+	printf("\t\twithout -a the algorithm is found by the size of the hash (MD5, SHA1, SHA224, SHA256, SHA384, SHA512)\n");
+	printf("\t--cache(-C) - file of the cache: the hash of the unchanged file (device, inode, size, time) is not calculated\n");
+	printf("\t--refresh(-r) - calculate the hashes of the all files and update the cache\n");
+	printf("\t--compact days - remove the entries of the cache not used for the days (0 - keep all) and shrink the file\n");
+	printf("\t--state(-s) - state file of the one file: the hash is resumed from the saved state,\n");
+	printf("\t\tthe state is saved every 1 GB and at the end (the appended file is hashed from the old end)\n");
+	printf("\t--algorithm(-a) - selection type HASH, the list (-a 0,3,7) - the file is read once for all\n");
 	printf("\t\t0 - MD5 hash\n\t\t1 - SHA1 hash\n\t\t2 - SHA224 hash\n");
-	printf("\t\t3 - SHA256 hash\n\t\t4 - SHA384 hash\n\t\t5 - SHA512 hash\n");
+	printf("\t\t3 - SHA256 hash\n\t\t4 - SHA384 hash\n\t\t5 - SHA512 hash (default)\n");
 	printf("\t\t6 - SHA3/224 hash\n\t\t7 - SHA3/256 hash\n");
 	printf("\t\t8 - SHA3/384 hash\n\t\t9 - SHA3/512 hash\n");
-	printf("\nExample: ./hashsum -h or ./hashsum -t test_string or ./hashsum -f 1.text -a 4\n\n");
+	printf("\t\t10 - KangarooTwelve hash\n\t\t11 - BLAKE3 hash\n");
+	printf("\nExample: ./hashsum -h or ./hashsum -t test_string or ./hashsum -f 1.text -a 4 or ./hashsum -a 3 *.iso or ./hashsum -a 0,3,7 1.iso\n\n");
 }
 
 int
 main(int argc, char *argv[])
 {
-	int res, type = 0, alg = 5;
-	char str[4096];
+	// nalgs = 0 - no -a option: SHA512, the manifest (-c) by the size of the hash
+	int res, type = 0, alg = 5, threads = 0, nfiles = 0, nalgs = 0, size, i;
+	int algs[12] = { 5 };
+	char str[4096] = "", **files, *p, *manifest = NULL, *cache_name = NULL, *state_name = NULL;
+	long compact = -1;
+	uint8_t digest[64];
 	union context context;
+	struct sigaction sa;
 	const struct option long_option [] = {
 		{"help",      0, NULL, 'h'},
 		{"text",      1, NULL, 't'},
 		{"file",      1, NULL, 'f'},
 		{"algorithm", 1, NULL, 'a'},
+		{"threads",   1, NULL, 'j'},
+		{"check",     1, NULL, 'c'},
+		{"cache",     1, NULL, 'C'},
+		{"refresh",   0, NULL, 'r'},
+		{"compact",   1, NULL, 'K'},
+		{"state",     1, NULL, 's'},
 		{0, 	      0, NULL,  0 }
 	};
 
@@ -161,59 +1082,126 @@ main(int argc, char *argv[])
 		return 0;
 	}
 
+	if((files = malloc(argc * sizeof(char *))) == NULL) {
+		printf("Error allocating memory!\n");
+		return 0;
+	}
+
 	// Parse argument
-	while((res = getopt_long(argc, argv, "t:f:a:h", long_option, 0)) != -1) {
+	while((res = getopt_long(argc, argv, "t:f:a:j:c:C:rs:h", long_option, 0)) != -1) {
 		switch(res) {
 		case 't' : strcpy(str, optarg);
 			   type = 0;
 			   break;
-		case 'f' : strcpy(str, optarg);
+		case 'f' : files[nfiles++] = optarg;
 			   type = 1;
 			   break;
-		case 'a' : alg = atoi(optarg);
+		case 'a' : nalgs = 0;
+			   p = optarg;
+
+			   // List of the algorithms separated by the comma
+			   do {
+				   algs[nalgs++] = strtol(p, &p, 10);
+			   } while((*p++ == ',') && (nalgs < 12));
+
+			   alg = algs[0];
+			   break;
+		case 'j' : threads = atoi(optarg);
+			   break;
+		case 'c' : manifest = optarg;
+			   break;
+		case 'C' : cache_name = optarg;
+			   break;
+		case 'r' : refresh = 1;
+			   break;
+		case 'K' : compact = atol(optarg);
+			   break;
+		case 's' : state_name = optarg;
 			   break;
 		case 'h' : help();
+			   free(files);
 			   return 0;
 		}
 	}
 
-	// Calculate HASH
-	switch(alg) {
-	case 0 : printf("MD5 hash:\n");
-		 func[type](&(context.md5), alg, str, 0);
-		 break;
-	case 1 : printf("SHA1 hash:\n");
-		 func[type](&(context.sha1), alg, str, 0);
-		 break;
-	case 2 : printf("SHA224 hash:\n");
-		 func[type](&(context.sha224), alg, str, 0);
-		 break;
-	case 3 : printf("SHA256 hash:\n");
-		 func[type](&(context.sha256), alg, str, 0);
-		 break;
-	case 4 : printf("SHA384 hash:\n");
-		 func[type](&(context.sha384), alg, str, 0);
-		 break;
-	case 5 : printf("SHA512 hash:\n");
-		 func[type](&(context.sha512), alg, str, 0);
-		 break;
-	case 6 : printf("SHA3/224 hash:\n");
-		 func[type](&(context.sha3), alg, str, 224);
-		 break;
-	case 7 : printf("SHA3/256 hash:\n");
-		 func[type](&(context.sha3), alg, str, 256);
-		 break;
-	case 8 : printf("SHA3/384 hash:\n");
-		 func[type](&(context.sha3), alg, str, 384);
-		 break;
-	case 9 : printf("SHA3/512 hash:\n");
-		 func[type](&(context.sha3), alg, str, 512);
-		 break;
-	default:
-		 printf("NO such this algorithm!\n");
-		 break;
+	// Other arguments are the files
+	for(; optind < argc; optind++) {
+		files[nfiles++] = argv[optind];
+		type = 1;
 	}
 
-	return 0;
-}
+	for(i = 0; i < nalgs; i++) {
+		if((algs[i] < 0) || (algs[i] > 11)) {
+			printf("NO such this algorithm!\n");
+			free(files);
+			return 0;
+		}
+	}
+
+	// The file truncated while mapped is failed, not the program (sigbus_handler)
+	page_size = sysconf(_SC_PAGESIZE);
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = sigbus_handler;
+	sa.sa_flags = SA_SIGINFO;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGBUS, &sa, NULL);
+
+	// Cache of the results
+	if((cache_name != NULL) && ((cache = cache_open(cache_name)) == NULL))
+		printf("Error openning the cache - %s!\n", cache_name);
+
+	if((state_name != NULL) && ((manifest != NULL) || (nalgs > 1) || (nfiles != 1)))
+		printf("The state file is used with the one file and the one algorithm!\n");
+
+	// Exit code 1 if some file failed (as sha256sum)
+	res = 0;
+
+	// Check the manifest by the first algorithm or by the size of the hash
+	if(manifest != NULL)
+		res = check_manifest((nalgs == 0) ? -1 : alg, manifest, threads);
+	else if((type == 1) && (nalgs > 1))
+		res = (hash_multi_files(nalgs, algs, files, nfiles, threads) > 0) ? 1 : 0;
+	else if((nalgs > 1) && (str[0] != '\0')) {
+		for(i = 0; i < nalgs; i++) {
+			printf("%s hash:\n", hash_name[algs[i]]);
+			hash_text(&context, algs[i], str, (init_size[algs[i]] < 0) ? threads : init_size[algs[i]]);
+		}
+	}
+	else if((type == 1) || (str[0] != '\0')) {
+		// Calculate HASH
+		printf("%s hash:\n", hash_name[alg]);
+
+		size = (init_size[alg] < 0) ? threads : init_size[alg];
 
+		if(type == 0)
+			hash_text(&context, alg, str, size);
+		else if(nfiles == 1) {
+			if(((state_name != NULL) ? hash_resume(&context, alg, files[0], size, state_name, digest) :
+			    hash_file(&context, alg, files[0], size, NULL, digest))) {
+				printf("Error openning the file - %s!\n", files[0]);
+				res = 1;
+			}
+			else
+				PRINT_DIGEST(digest, hash_size[alg]);
+		}
+		else {
+			// The files are hashed in parallel, the tree hash of the large file - by the same pool
+			if(init_size[alg] < 0)
+				size = 1;
+
+			res = (hash_files(alg, files, NULL, nfiles, size, threads) > 0) ? 1 : 0;
+		}
+	}
+
+	if(cache != NULL) {
+		// Remove the entries not used for the compact days
+		if((compact >= 0) && ((i = cache_compact(cache, compact * 86400)) >= 0))
+			printf("Cache: %d entries removed\n", i);
+
+		cache_close(cache);
+	}
+
+	free(files);
+
+	return res;
+}
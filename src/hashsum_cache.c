@@ -0,0 +1,366 @@
+/*
+ * This program implements the persistent cache of the hashsum results.
+ * File: header (64 bytes), then the hash table of the entries (128 bytes) with the linear probing.
+ * The slot is found by (device, inode, algorithm): the changed file replaces its old entry,
+ * so the table does not collect the old versions of the files.
+ * The table is rebuilt when it is half full (twice larger) and by the compaction.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hashsum_cache.h"
+
+// Magic string and version of the file
+#define CACHE_MAGIC	"HSUMCACH"
+#define CACHE_VERSION	1
+
+// Initial and minimum number of the slots
+#define CACHE_SLOTS	4096
+
+/*
+ * Header of the cache file
+ * magic - CACHE_MAGIC
+ * version - CACHE_VERSION
+ * nslots - number of the slots (power of 2)
+ * count - number of the used slots
+*/
+struct cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t nslots;
+	uint32_t count;
+	uint8_t reserved[44];
+};
+
+/*
+ * Entry of the cache
+ * dev, ino - file
+ * size - size in bytes of the file
+ * mtime - time of the modification of the file, ns
+ * seen - time of the last use of the entry, s
+ * alg - algorithm (number of the hashsum), 0xFFFFFFFF - free slot
+ * len - size in bytes of the hash
+ * digest - hash of the file
+*/
+struct cache_entry {
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t size;
+	int64_t mtime;
+	int64_t seen;
+	uint32_t alg;
+	uint32_t len;
+	uint8_t digest[64];
+	uint8_t reserved[16];
+};
+
+#define CACHE_FREE	0xFFFFFFFF
+
+/*
+ * Cache context
+ * lock - mutex of the table (the files are hashed by several threads)
+ * fd - cache file
+ * map - mapped file
+ * header - header of the file
+ * entry - table of the entries
+ * now - current time
+*/
+struct hash_cache {
+	pthread_mutex_t lock;
+	int fd;
+	void *map;
+	struct cache_header *header;
+	struct cache_entry *entry;
+	time_t now;
+};
+
+// Size in bytes of the file of the nslots slots
+#define CACHE_BYTES(nslots)	(sizeof(struct cache_header) + (size_t)(nslots) * sizeof(struct cache_entry))
+
+// Index of the first slot of the key
+static uint32_t
+cache_slot(struct hash_cache *cache, uint64_t dev, uint64_t ino, uint32_t alg)
+{
+	uint64_t h;
+
+	h = (dev * 0x9E3779B97F4A7C15) ^ (ino * 0xC2B2AE3D27D4EB4F) ^ alg;
+	h ^= h >> 29;
+	h *= 0xBF58476D1CE4E5B9;
+	h ^= h >> 32;
+
+	return (uint32_t)h & (cache->header->nslots - 1);
+}
+
+// Find the slot of the key: slot of the key or the free slot
+// Return value: pointer of the slot or NULL (if the table has no free slot)
+static struct cache_entry *
+cache_find(struct hash_cache *cache, uint64_t dev, uint64_t ino, uint32_t alg)
+{
+	struct cache_entry *e;
+	uint32_t i, n, mask = cache->header->nslots - 1;
+
+	// The damaged file (the count is less than the used slots) may be full: no more than nslots probes
+	for(i = cache_slot(cache, dev, ino, alg), n = 0; n < cache->header->nslots; i = (i + 1) & mask, n++) {
+		e = &cache->entry[i];
+
+		if(e->alg == CACHE_FREE)
+			return e;
+
+		if((e->dev == dev) && (e->ino == ino) && (e->alg == alg))
+			return e;
+	}
+
+	return NULL;
+}
+
+// Map the file of the nslots slots, the table is empty if clear is set
+// Return value: 0 (if all is well), -1 (if all bad)
+static int
+cache_map(struct hash_cache *cache, uint32_t nslots, int clear)
+{
+	uint32_t i;
+
+	if(cache->map != NULL)
+		munmap(cache->map, CACHE_BYTES(cache->header->nslots));
+
+	cache->map = NULL;
+
+	if(ftruncate(cache->fd, CACHE_BYTES(nslots)))
+		return -1;
+
+	cache->map = mmap(NULL, CACHE_BYTES(nslots), PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0);
+
+	if(cache->map == MAP_FAILED) {
+		cache->map = NULL;
+		return -1;
+	}
+
+	cache->header = cache->map;
+	cache->entry = (struct cache_entry *)(cache->header + 1);
+
+	if(clear) {
+		memset(cache->header, 0, sizeof(*cache->header));
+		memcpy(cache->header->magic, CACHE_MAGIC, 8);
+		cache->header->version = CACHE_VERSION;
+		cache->header->nslots = nslots;
+
+		for(i = 0; i < nslots; i++)
+			cache->entry[i].alg = CACHE_FREE;
+	}
+
+	return 0;
+}
+
+// Rebuild the table of the nslots slots without the entries not used for the age seconds
+// Return value: number of the removed entries or -1 (if all bad)
+static int
+cache_rebuild(struct hash_cache *cache, uint32_t nslots, time_t age)
+{
+	struct cache_entry *old, *e;
+	uint32_t i, n, removed;
+
+	// The used slots are counted by the table, not by the header (the count of the damaged file may be wrong)
+	if((old = malloc(cache->header->nslots * sizeof(*old))) == NULL)
+		return -1;
+
+	for(i = n = removed = 0; i < cache->header->nslots; i++) {
+		if(cache->entry[i].alg == CACHE_FREE)
+			continue;
+
+		if((age > 0) && (cache->now - cache->entry[i].seen > age))
+			removed++;
+		else
+			old[n++] = cache->entry[i];
+	}
+
+	// The table is no more than half full
+	while(nslots / 2 < n)
+		nslots *= 2;
+
+	if(cache_map(cache, nslots, 1)) {
+		free(old);
+		return -1;
+	}
+
+	// The new table is no more than half full: the free slot is always found.
+	// The key repeated in the damaged file takes one slot
+	for(i = 0; i < n; i++) {
+		if((e = cache_find(cache, old[i].dev, old[i].ino, old[i].alg)) == NULL)
+			continue;
+
+		if(e->alg == CACHE_FREE)
+			cache->header->count++;
+
+		*e = old[i];
+	}
+
+	free(old);
+
+	return removed;
+}
+
+// Open (or create) the cache file
+// Return value: pointer of the cache or NULL (if all bad)
+struct hash_cache *
+cache_open(const char *file_name)
+{
+	struct hash_cache *cache;
+	struct cache_header *h;
+	struct stat st;
+
+	if((cache = calloc(1, sizeof(*cache))) == NULL)
+		return NULL;
+
+	if((cache->fd = open(file_name, O_RDWR | O_CREAT, 0644)) < 0) {
+		free(cache);
+		return NULL;
+	}
+
+	// One process of the cache at the time
+	if(flock(cache->fd, LOCK_EX) || fstat(cache->fd, &st)) {
+		close(cache->fd);
+		free(cache);
+		return NULL;
+	}
+
+	cache->now = time(NULL);
+	pthread_mutex_init(&cache->lock, NULL);
+
+	// Map the existing file, if the header is correct
+	if(st.st_size >= sizeof(*h)) {
+		h = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0);
+
+		if(h != MAP_FAILED) {
+			if(!memcmp(h->magic, CACHE_MAGIC, 8) && (h->version == CACHE_VERSION) &&
+			   (h->nslots >= CACHE_SLOTS) && !(h->nslots & (h->nslots - 1)) &&
+			   (h->count <= h->nslots) && (st.st_size == CACHE_BYTES(h->nslots))) {
+				cache->map = h;
+				cache->header = h;
+				cache->entry = (struct cache_entry *)(h + 1);
+				return cache;
+			}
+
+			munmap(h, st.st_size);
+		}
+	}
+
+	// New (or damaged) file - empty table
+	if(cache_map(cache, CACHE_SLOTS, 1)) {
+		cache_close(cache);
+		return NULL;
+	}
+
+	return cache;
+}
+
+// Find the hash of the file
+// Return value: 0 (if the hash is found), -1 (if not)
+int
+cache_lookup(struct hash_cache *cache, const struct stat *st, int alg, uint8_t *digest, int size)
+{
+	struct cache_entry *e;
+	int res = -1;
+
+	pthread_mutex_lock(&cache->lock);
+
+	// The file is not mapped after the error
+	if(cache->map == NULL) {
+		pthread_mutex_unlock(&cache->lock);
+		return -1;
+	}
+
+	e = cache_find(cache, st->st_dev, st->st_ino, alg);
+
+	if((e != NULL) && (e->alg != CACHE_FREE) && (e->size == st->st_size) && (e->len == size) &&
+	   (e->mtime == st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec)) {
+		memcpy(digest, e->digest, size);
+		e->seen = cache->now;
+		res = 0;
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	return res;
+}
+
+// Save the hash of the file
+// Return value: 0 (if all is well), -1 (if all bad)
+int
+cache_store(struct hash_cache *cache, const struct stat *st, int alg, const uint8_t *digest, int size)
+{
+	struct cache_entry *e;
+
+	pthread_mutex_lock(&cache->lock);
+
+	if(cache->map == NULL) {
+		pthread_mutex_unlock(&cache->lock);
+		return -1;
+	}
+
+	e = cache_find(cache, st->st_dev, st->st_ino, alg);
+
+	// New entry: the table is no more than half full (the full table of the damaged file is rebuilt too)
+	if((e == NULL) || ((e->alg == CACHE_FREE) && (cache->header->count + 1 > cache->header->nslots / 2))) {
+		if(cache_rebuild(cache, cache->header->nslots * 2, 0) < 0) {
+			pthread_mutex_unlock(&cache->lock);
+			return -1;
+		}
+
+		if((e = cache_find(cache, st->st_dev, st->st_ino, alg)) == NULL) {
+			pthread_mutex_unlock(&cache->lock);
+			return -1;
+		}
+	}
+
+	if(e->alg == CACHE_FREE)
+		cache->header->count++;
+
+	e->dev = st->st_dev;
+	e->ino = st->st_ino;
+	e->size = st->st_size;
+	e->mtime = st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+	e->seen = cache->now;
+	e->alg = alg;
+	e->len = size;
+	memcpy(e->digest, digest, size);
+
+	pthread_mutex_unlock(&cache->lock);
+
+	return 0;
+}
+
+// Remove the entries not used for the age seconds and shrink the file
+// Return value: number of the removed entries or -1 (if all bad)
+int
+cache_compact(struct hash_cache *cache, time_t age)
+{
+	int res;
+
+	pthread_mutex_lock(&cache->lock);
+	res = (cache->map != NULL) ? cache_rebuild(cache, CACHE_SLOTS, age) : -1;
+	pthread_mutex_unlock(&cache->lock);
+
+	return res;
+}
+
+// Close the cache file
+void
+cache_close(struct hash_cache *cache)
+{
+	if(cache->map != NULL)
+		munmap(cache->map, CACHE_BYTES(cache->header->nslots));
+
+	pthread_mutex_destroy(&cache->lock);
+	close(cache->fd);
+	free(cache);
+}
@@ -0,0 +1,36 @@
+/*
+ * Persistent cache of the hashsum results.
+ * The cache file is the memory-mapped hash table keyed by (device, inode, algorithm),
+ * the entry is valid while the size and the modification time (ns) of the file are the same.
+ * The file is locked (flock) while the cache is open.
+*/
+
+#ifndef HASHSUM_CACHE_H
+#define HASHSUM_CACHE_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/stat.h>
+
+struct hash_cache;
+
+// Open (or create) the cache file
+// Return value: pointer of the cache or NULL (if all bad)
+struct hash_cache *cache_open(const char *file_name);
+
+// Find the hash of the file
+// Return value: 0 (if the hash is found), -1 (if not)
+int cache_lookup(struct hash_cache *cache, const struct stat *st, int alg, uint8_t *digest, int size);
+
+// Save the hash of the file
+// Return value: 0 (if all is well), -1 (if all bad)
+int cache_store(struct hash_cache *cache, const struct stat *st, int alg, const uint8_t *digest, int size);
+
+// Remove the entries not used for the age seconds and shrink the file
+// Return value: number of the removed entries or -1 (if all bad)
+int cache_compact(struct hash_cache *cache, time_t age);
+
+// Close the cache file
+void cache_close(struct hash_cache *cache);
+
+#endif /* HASHSUM_CACHE_H */